@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "dataHeader.h"
+#include "log_vault.h"
+
+/*
+cold start benchmark for pman
+measures the time from starting a new process until
+    - pman prints the first prompt (the password prompt of an existing vault)
+    - pman get prints the first decrypted byte of a record (the password is written to its stdin, --password-fd 0)
+usage: pman_coldstart <path to pman> [runs] [iterations of the chainhashes]
+*/
+
+extern char** environ;
+
+static const std::string PASSWORD = "benchmark-password";
+static const std::string PROMPT = "Please enter the password";
+
+static double spawnAndWait(std::vector<std::string> args, std::vector<std::string> env, std::string marker, std::string input=""){
+    //starts the process, writes the input to its stdin and returns the milliseconds until the marker (or one byte for an empty marker) was written to stdout
+    int out[2];
+    int in[2];
+    if(pipe(out) != 0 || pipe(in) != 0){
+        throw std::runtime_error("cannot create pipes");
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, in[1]);
+    posix_spawn_file_actions_addclose(&actions, out[0]);
+    std::vector<char*> argv;
+    for(std::string& arg : args){
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    std::vector<char*> envp;
+    for(std::string& var : env){
+        envp.push_back(var.data());
+    }
+    envp.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    if(posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), envp.data()) != 0){
+        throw std::runtime_error("cannot start " + args[0]);
+    }
+    close(in[0]);
+    close(out[1]);
+    if(!input.empty() && write(in[1], input.data(), input.size()) != (ssize_t)input.size()){
+        throw std::runtime_error("cannot write the input of " + args[0]);     //the input is smaller than the pipe buffer
+    }
+    std::string output;
+    char buf[4096];
+    ssize_t len;
+    while((len = read(out[0], buf, sizeof(buf))) > 0){
+        output.append(buf, len);
+        if(marker.empty() || output.find(marker) != std::string::npos){
+            break;
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    kill(pid, SIGKILL);     //the prompt waits for input, pman get is stopped after its first byte
+    waitpid(pid, nullptr, 0);
+    close(in[1]);
+    close(out[0]);
+    posix_spawn_file_actions_destroy(&actions);
+    if(len <= 0){
+        throw std::runtime_error(args[0] + " stopped before the marker was written");
+    }
+    return ms;
+}
+
+static void printTimes(std::string name, std::vector<double> times){
+    std::sort(times.begin(), times.end());
+    std::cout << name << ": min " << times.front() << " ms, median " << times[times.size()/2] << " ms, p90 " << times[times.size()*9/10] << " ms" << std::endl;
+}
+
+static std::filesystem::path createVault(std::filesystem::path dir, unsigned long iters){
+    //creates a vault with 1000 records and an app data file that points to it
+    std::filesystem::path path = dir / "bench.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(64);
+    DataHeader dh(STANDARD_HASHMODE);
+    dh.setCipherMode(STANDARD_CIPHERMODE);
+    dh.setChainHash1(1, iters, 0, Bytes());
+    dh.setChainHash2(1, iters, 0, Bytes());
+    dh.setPassword(PASSWORD, datakey);
+    dh.setEncryptedSalt(Bytes(64));
+    LogVault vault(path, dh, datakey);
+    for(int i=0; i < 1000; i++){
+        vault.put("entry" + std::to_string(i), Bytes(64));
+    }
+    std::filesystem::create_directories(dir / ".pman");
+    std::ofstream(dir / ".pman" / "data.txt") << "filePath " << path.string() << std::endl;
+    return path;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        std::cout << "usage: " << argv[0] << " <path to pman> [runs] [iterations]" << std::endl;
+        return 1;
+    }
+    std::string pman = std::filesystem::absolute(argv[1]).string();
+    int runs = argc > 2 ? std::stoi(argv[2]) : 20;
+    unsigned long iters = argc > 3 ? std::stoul(argv[3]) : STANDARD_PASS_VAL_ITERATIONS;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_coldstart";
+    std::filesystem::create_directories(dir);
+    std::filesystem::path vault = createVault(dir, iters);
+    std::vector<std::string> env = {"HOME=" + dir.string(), "PMAN_AGENT_SOCK=" + (dir / "no-agent.sock").string()};    //no agent, so pman get unlocks with the password
+
+    std::vector<double> prompt;
+    std::vector<double> decrypted;
+    for(int i=0; i < runs; i++){
+        prompt.push_back(spawnAndWait({pman}, env, PROMPT));
+        decrypted.push_back(spawnAndWait({pman, "get", "entry0", "--vault", vault.string(), "--password-fd", "0"}, env, "", PASSWORD + "\n"));
+    }
+    std::cout << runs << " runs, " << iters << " chainhash iterations" << std::endl;
+    printTimes("start to first prompt", prompt);
+    printTimes("start to first decrypted byte", decrypted);
+    std::filesystem::remove_all(dir);
+    return 0;
+}
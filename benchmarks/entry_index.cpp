@@ -0,0 +1,63 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "entry_index.h"
+#include "entry_record.h"
+
+/*
+benchmark for the entry index
+builds the index of a vault with n entries and measures exact lookups, prefix queries and changes
+usage: pman_entry_index [entries]
+*/
+
+int main(int argc, char* argv[]){
+    unsigned long entries = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::vector<std::pair<std::string, Bytes>> records;
+    for(unsigned long i=0; i < entries; i++){
+        Entry entry;
+        entry.title = "entry" + std::to_string(i);
+        entry.username = "user" + std::to_string(i);
+        entry.secret = "secret";
+        entry.url = "https://site" + std::to_string(i) + ".example.com";
+        records.emplace_back("record" + std::to_string(i), EntryView::encode(entry));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    EntryIndex index(entries);      //like LogVault when the records are loaded
+    for(const std::pair<std::string, Bytes>& record : records){
+        index.put(EntryView(record.second.getView()).getFieldString(EntryView::FIELD_TITLE), record.first);
+    }
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const unsigned long lookups = 1000000;
+    unsigned long found = 0;
+    start = std::chrono::steady_clock::now();
+    for(unsigned long i=0; i < lookups; i++){
+        found += index.find("entry" + std::to_string((i * 7919) % entries)).has_value();
+    }
+    double lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+    const unsigned long queries = 10000;
+    start = std::chrono::steady_clock::now();
+    for(unsigned long i=0; i < queries; i++){
+        found += index.findPrefix("entry" + std::to_string(i % 1000), 10).size();
+    }
+    double prefix_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries;
+
+    const unsigned long changes = 1000;
+    start = std::chrono::steady_clock::now();
+    for(unsigned long i=0; i < changes; i++){
+        index.put("new" + std::to_string(i), "record" + std::to_string(i));
+        index.remove("entry" + std::to_string(i));
+    }
+    double change_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / changes;
+
+    std::cout << entries << " entries (" << found << " found)" << std::endl;
+    std::cout << "build:  " << build_ms << " ms" << std::endl;
+    std::cout << "lookup: " << lookup_ns << " ns" << std::endl;
+    std::cout << "prefix: " << prefix_us << " us (10 results)" << std::endl;
+    std::cout << "change: " << change_us << " us (put and remove)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "importer.h"
+#include "log_vault.h"
+
+/*
+benchmark for pman import
+writes a csv export with n entries and imports it into a new vault with one and with all threads,
+for comparison the first entries are stored with one put (one append and sync) each
+usage: pman_import [entries]
+*/
+
+static DataHeader createHeader(const Bytes datakey){
+    DataHeader dh(1);
+    dh.setCipherMode(2);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    return dh;
+}
+
+static void removeVault(const std::filesystem::path path){
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+int main(int argc, char* argv[]){
+    unsigned long entries = argc > 1 ? std::stoul(argv[1]) : 40000;
+    std::filesystem::path csv_path = std::filesystem::temp_directory_path() / "pman_import_bench.csv";
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_import_bench.enc";
+    {
+        std::ofstream csv(csv_path, std::ios::binary);
+        csv << "name,username,password,url,notes\n";
+        for(unsigned long i=0; i < entries; i++){
+            csv << "entry" << i << ",user" << i << "@example.org,pw-" << i * 7919 << ",https://site" << i << ".example.com,\"notes of the entry " << i << ", with a comma\"\n";
+        }
+    }
+    std::cout << entries << " entries, " << std::filesystem::file_size(csv_path) / 1024 << " KiB csv" << std::endl;
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createHeader(datakey);
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads : {1u, cores}){
+        removeVault(path);
+        LogVault vault(path, dh, datakey);
+        std::ifstream csv(csv_path, std::ios::binary);
+        ImportReport report = Importer::run(csv, Importer::FORMAT_CSV, vault, threads);
+        std::cout << "import with " << report.threads << " threads: " << report.seconds * 1000 << " ms, " << report.entries / report.seconds << " entries/s, " << report.batches << " appends" << std::endl;
+        if(cores == 1){
+            break;
+        }
+    }
+    removeVault(path);
+    unsigned long single = std::min(entries, 2000UL);
+    {
+        LogVault vault(path, dh, datakey);
+        auto start = std::chrono::steady_clock::now();
+        for(unsigned long i=0; i < single; i++){
+            Entry entry;
+            entry.title = "entry" + std::to_string(i);
+            vault.put(entry.title, EntryView::encode(entry));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "one put per entry: " << single / seconds << " entries/s" << std::endl;
+    }
+    removeVault(path);
+    std::filesystem::remove(csv_path);
+    return 0;
+}
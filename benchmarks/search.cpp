@@ -0,0 +1,56 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "log_vault.h"
+#include "entry_record.h"
+
+/*
+benchmark for the search filters
+writes a vault with n entries and attachments of the given size, then searches with and without the filters
+usage: pman_search [entries] [attachment MiB]
+*/
+
+int main(int argc, char* argv[]){
+    unsigned long entries = argc > 1 ? std::stoul(argv[1]) : 10000;
+    unsigned long attachment_mib = argc > 2 ? std::stoul(argv[2]) : 256;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_search_bench.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setCipherMode(2);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    unsigned long file_len = 0;
+    {
+        LogVault vault(path, dh, datakey);
+        for(unsigned long i=0; i < entries; i++){
+            Entry entry;
+            entry.title = "entry" + std::to_string(i);
+            entry.username = "user" + std::to_string(i) + "@example.org";
+            entry.secret = "secret";
+            entry.url = "https://site" + std::to_string(i) + ".example.com";
+            entry.notes = "notes of the entry " + std::to_string(i * 7919);
+            vault.put("entry" + std::to_string(i), EntryView::encode(entry));
+            if(i % (entries / attachment_mib + 1) == 0 && i / (entries / attachment_mib + 1) < attachment_mib){
+                vault.put("attachment" + std::to_string(i), Bytes(1048576));    //1 MiB between the entries
+            }
+        }
+        vault.writeIndex();
+        file_len = vault.getFileLen();
+    }
+    std::string query = "user" + std::to_string(entries / 2) + "@";
+    SearchResult filtered = LogVault::search(path, dh, datakey, query);
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+    SearchResult full = LogVault::search(path, dh, datakey, query);
+
+    std::cout << entries << " entries, " << file_len / 1048576 << " MiB vault, query " << query << " (" << filtered.names.size() << " found)" << std::endl;
+    std::cout << "filters: " << filtered.seconds * 1000 << " ms, " << filtered.scanned_segments << " of " << filtered.segments << " segments, " << filtered.decrypted_len / 1024 << " KiB decrypted" << std::endl;
+    std::cout << "full:    " << full.seconds * 1000 << " ms, " << full.decrypted_len / 1024 << " KiB decrypted" << std::endl;
+    std::filesystem::remove(path);
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(FileLock::getLockPath(path));
+    return 0;
+}
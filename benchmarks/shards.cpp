@@ -0,0 +1,55 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "sharded_vault.h"
+
+/*
+benchmark for sharded vault directories
+writes a sharded vault with n entries, loads it with 1, 2, 4, ... threads and saves a change of one entry
+usage: pman_shards [entries] [shards] [entry bytes]
+*/
+
+int main(int argc, char* argv[]){
+    unsigned long entries = argc > 1 ? std::stoul(argv[1]) : 200000;
+    unsigned long shard_number = argc > 2 ? std::stoul(argv[2]) : 64;
+    unsigned long entry_len = argc > 3 ? std::stoul(argv[3]) : 1000;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_shards_bench";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setCipherMode(2);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    ShardedVault::create(dir, dh, datakey, shard_number);
+    SaveReport full;
+    {
+        ShardedVault vault(dir, dh, datakey);
+        for(unsigned long i=0; i < entries; i++){
+            vault.put("entry" + std::to_string(i), Bytes(entry_len));
+        }
+        full = vault.save();
+    }
+    std::cout << entries << " entries in " << shard_number << " shards, " << full.bytes / 1048576 << " MiB" << std::endl;
+    double single = 0;
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads = 1; threads <= cores; threads = threads < cores && threads * 2 > cores ? cores : threads * 2){
+        ShardedVault vault(dir, dh, datakey, threads);
+        ShardLoadReport load = vault.getLastLoad();
+        single = threads == 1 ? load.seconds : single;
+        std::cout << "load with " << load.threads << " threads: " << load.seconds * 1000 << " ms (" << single / load.seconds << "x)" << std::endl;
+        if(threads == cores){
+            break;
+        }
+    }
+    ShardedVault vault(dir, dh, datakey);
+    vault.put("entry" + std::to_string(entries / 2), Bytes(entry_len));
+    SaveReport one = vault.save();
+    std::cout << "save of all shards: " << full.bytes / 1024 << " KiB in " << full.seconds * 1000 << " ms" << std::endl;
+    std::cout << "save of one change: " << one.bytes / 1024 << " KiB in " << one.seconds * 1000 << " ms" << std::endl;
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef AGENT_H
+#define AGENT_H
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <vector>
+#include "bytes.h"
+#include "secure_buffer.h"
+
+class Agent{
+    /*
+    the key agent (pman-agent) keeps the data keys of unlocked vaults in locked memory for a limited time,
+    so later pman calls do not have to compute the chainhashes again
+    it listens on a unix socket that only the owner can open and serves only clients with the same user id (SO_PEERCRED)
+    the directory of the socket has to be a 0700 directory of the owner, else a socket of another user could be placed there
+    the keys are zeroized when their time to live is over, when they are removed and when the agent stops
+    messages: 1 byte command/status, 4 bytes payload length, payload (see docs/agent.md)
+    */
+public:
+    static const constexpr unsigned char CMD_ADD = 1;       //payload: 2 bytes id length, id, 8 bytes ttl in seconds (0 = default), key (32, 48 or 64 bytes)
+    static const constexpr unsigned char CMD_GET = 2;       //payload: id
+    static const constexpr unsigned char CMD_REMOVE = 3;    //payload: id
+    static const constexpr unsigned char CMD_CLEAR = 4;     //no payload
+    static const constexpr unsigned char STATUS_OK = 0;
+    static const constexpr unsigned char STATUS_NOT_FOUND = 1;
+    static const constexpr unsigned char STATUS_ERROR = 2;
+    static const constexpr unsigned long MAX_MESSAGE_LEN = 65536;
+    static const constexpr unsigned long STANDARD_TTL = 900;    //seconds a key is kept if the client does not set a ttl
+
+private:
+    struct CachedKey{
+        SecureBuffer key;                                   //the data key (locked memory)
+        std::chrono::steady_clock::time_point expiry;       //the key is removed after this time
+    };
+    std::filesystem::path socket_path;  //path of the unix socket
+    int listen_fd;                      //listening socket
+    unsigned long default_ttl;          //ttl for keys without a given ttl (seconds)
+    struct Client{
+        int fd;
+        std::vector<unsigned char> message;     //5 bytes header, then sized for the payload (allocated once, so no key is left in freed memory)
+        unsigned long received;                 //bytes of the message that were read
+        std::chrono::steady_clock::time_point start;    //the client is dropped if its request is not complete after CLIENT_TIMEOUT_MS
+    };
+    std::map<std::string, CachedKey> keys;  //cached keys by vault id
+    std::atomic<bool> running;          //the serve loop runs until this is false
+
+private:
+    void purgeExpired() noexcept;
+    std::vector<unsigned char> handle(const BytesView request);     //returns the response message for a request (the caller cleanses it)
+    bool serveClient(Client& client);           //reads what the client sent and answers a complete request, returns true if the client is done
+
+public:
+    Agent(const std::filesystem::path socket_path, unsigned long default_ttl=STANDARD_TTL);    //creates the socket (throws if it cannot be created, its directory is not private or another agent uses it)
+    Agent(const Agent&) = delete;
+    Agent& operator=(const Agent&) = delete;
+    ~Agent();                                   //closes and removes the socket, zeroizes all keys
+
+    void run();                                 //serves requests until stop is called
+    void stop() noexcept;                       //stops the serve loop (can be called from a signal handler or another thread)
+    unsigned long getKeyNumber() const noexcept;
+
+    static std::filesystem::path getDefaultSocketPath();    //PMAN_AGENT_SOCK, XDG_RUNTIME_DIR/pman-agent.sock or /tmp/pman-<uid>/agent.sock
+    static std::string getVaultId(const Bytes header);      //id of a vault (sha256 of its data header, a changed header needs a new unlock)
+};
+
+class AgentClient{
+    /*
+    client side of the key agent, every call is one connection
+    if no agent runs, the calls return nothing or false (pman then unlocks with the password)
+    nothing is sent if the socket directory is not private or the agent runs with another user id
+    */
+private:
+    std::filesystem::path socket_path;
+
+private:
+    std::optional<Bytes> request(unsigned char cmd, const Bytes payload) const;     //sends the request and returns the payload of an ok response
+
+public:
+    AgentClient(const std::filesystem::path socket_path=Agent::getDefaultSocketPath());
+    std::optional<Bytes> getKey(const std::string vault_id) const;
+    bool addKey(const std::string vault_id, const Bytes key, unsigned long ttl=0) const;
+    bool removeKey(const std::string vault_id) const;
+    bool clear() const;
+};
+
+#endif //AGENT_H
@@ -2,8 +2,14 @@
 #ifndef APP_H
 #define APP_H
 
+#include <functional>
 #include <iostream>
+#include <memory>
 #include "filehandler.h"
+#include "vault_unlock.h"
+#include "log_vault.h"
+#include "sharded_vault.h"
+#include "importer.h"
 
 class App{
 private:
@@ -17,9 +23,22 @@ private:
     std::string askForPasswd() const noexcept;
     unsigned char askForHashMode() const noexcept;
     long askForPasswdIters() const noexcept;
+    std::optional<UnlockedVault> unlockVault(const VaultUnlock& unlock, const std::function<std::optional<std::string>()> getPassword) const;    //asks the agent for the key first, then unlocks with the password
+    bool withDataKey(const DataHeader& header, int password_fd, const std::function<void(const Bytes)> use) const;    //calls use once with the key of the agent (if it matches the key check value of the header) or else with the key of the password (false and a message on stderr if there is no key)
+    int runShardedBatch(std::string vault_dir, int password_fd);      //batch mode on a sharded vault directory (changes are saved after the last command)
+    std::unique_ptr<LogVault> openVault(std::string vault_path, int password_fd) const;     //unlocks the vault for the non-interactive modes (nullptr and a message on stderr if it fails)
 public:
     App();
     bool run();
+    int runBatch(std::string vault_path, int password_fd);     //non-interactive mode: unlocks once and executes the commands from stdin (batch.h) on a vault session (vault_session.h), returns the exit code
+    int runImport(std::string vault_path, int password_fd, std::string file_path, std::string format_name);    //pman import: streams the csv or json export (- for stdin) into the vault (importer.h), the format is taken from the extension if no name is given, returns the exit code
+    int runShard(std::string vault_path, int password_fd, std::string vault_dir, unsigned long shards);    //pman shard: copies the records of the vault into a new sharded vault directory (sharded_vault.h), returns the exit code
+    int runGet(std::string vault_path, int password_fd, std::string name);    //pman get: prints one record, reads it with the name index if the vault has one (log_vault.h), returns the exit code
+    int runSearch(std::string vault_path, int password_fd, std::string query);   //pman search: prints the names of the records that contain the query (uses the search filters of the vault), returns the exit code
+    int runAttach(std::string vault_path, int password_fd, std::string name, std::string file_path);    //pman attach: streams the file into an encrypted blob (blob_store.h) and stores its reference as the record, returns the exit code
+    int runExport(std::string vault_path, int password_fd, std::string name, std::string file_path);    //pman export: streams the attachment of the record into the file (- for stdout), returns the exit code
+    int runScrub(std::string vault_path, int password_fd);     //pman scrub: checks the vault file (or the shards of a sharded vault) with its segment macs (segment_mac.h) without decrypting it, prints the throughput and the damaged offsets, returns the exit code
+    int runServe(std::string vault_path, int password_fd, std::string socket_path, unsigned int threads);   //pman serve: answers the batch commands of many clients (vault_server.h), returns the exit code
 };
 
 #endif //APP_H
\ No newline at end of file
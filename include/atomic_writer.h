@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ATOMICWRITER_H
+#define ATOMICWRITER_H
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "bytes.h"
+
+struct SaveReport{
+    /*
+    result of an atomic write
+    */
+    unsigned long bytes = 0;    //number of written bytes
+    double seconds = 0;         //time the write needed (including fsync and rename)
+
+    double getThroughput() const noexcept{return this->seconds > 0 ? this->bytes / this->seconds / 1000000 : 0;}   //MB/s
+};
+
+class AtomicWriter{
+    /*
+    writes a file so that a crash leaves either the old or the new file, never a partial one:
+    the parts are written into a temp file in the same directory (with as few writev calls as possible),
+    the temp file is synced, renamed over the file and at last the directory is synced so the rename is durable
+    */
+public:
+    static SaveReport writeFile(const std::filesystem::path path, const std::vector<BytesView> parts);     //replaces the file with the parts (written one after another)
+    static SaveReport writeFile(const std::filesystem::path path, const std::string content);              //replaces the file with the string
+    static SaveReport writeStream(const std::filesystem::path path, const std::function<std::optional<Bytes>()> next);    //replaces the file with the parts returned by next until it returns nothing (one part in memory at a time)
+    static std::filesystem::path writeTemp(const std::filesystem::path path, const std::vector<BytesView> parts);   //writes and syncs the temp file of a replacement without replacing the file yet (see replaceWithTemp)
+    static void replaceWithTemp(const std::filesystem::path path, const std::filesystem::path tmp_path);           //renames the temp file over the file and syncs the directory (the temp file is removed if it fails)
+    static SaveReport appendFile(const std::filesystem::path path, const unsigned long offset, const std::vector<BytesView> parts);  //cuts the file at offset (drops a cut off append), appends the parts and syncs the file
+    static std::vector<unsigned char> readFile(const std::filesystem::path path);      //reads a whole (small) file, e.g. an index (empty if the file does not exist)
+};
+
+#endif //ATOMICWRITER_H
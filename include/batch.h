@@ -0,0 +1,26 @@
+#pragma once
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <iostream>
+#include "entry_store.h"
+
+class Batch{
+    /*
+    non-interactive mode of pman (pman --vault <file> --batch --password-fd <fd>)
+    the vault is unlocked once, then one command per line is read and answered with one line (see docs/batch.md):
+        get <name>          -> ok <value>   (the secret of an entry record, the name is the rest of the line)
+        set <name> <value>  -> ok
+        set <name>\t<value> -> ok           (the name is everything up to the first tab, so it can have spaces)
+        del <name>          -> ok           (the name is the rest of the line)
+        list                -> ok <n> followed by n lines with the names
+    errors are answered with "err <message>", the following commands are still executed
+    */
+public:
+    static bool execute(EntryStore& store, const std::string line, std::ostream& out);    //executes one command and writes its answer, returns false if it failed
+    static std::string getText(const BytesView value);                                  //text of a value for a get answer: the secret of an entry record or the value (throws runtime_error if it is binary or has line breaks)
+    static unsigned long run(EntryStore& store, std::istream& in, std::ostream& out);     //executes all commands and returns the number of failed commands
+    static std::string readPassword(int fd);                                            //reads the password (first line) from the file descriptor
+};
+
+#endif //BATCH_H
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include "bytes.h"
+#include "settings.h"
+
+struct BlobRef{
+    /*
+    reference of an attachment, it is stored as the value of a record (BlobStore::encodeRef)
+    */
+    Bytes id;                       //random id of the blob (the file name in hex)
+    unsigned long len = 0;          //plain length of the attachment
+    unsigned long chunk_len = 0;    //plain bytes per chunk
+};
+
+class BlobStore{
+    /*
+    stores attachments as encrypted blobs in files next to the vault (<vault>.blobs/<id>, see docs/attachments.md)
+    a blob is split into chunks of chunk_len plain bytes that are encrypted one by one, so writing and reading a blob
+    needs the memory of one chunk, whatever the size of the attachment
+    every chunk has its index and a last flag in front of the plain bytes and each blob has its own key,
+    so chunks cannot be reordered, swapped between blobs or cut off unnoticed
+    the vault only holds the small references, so loading the records never reads attachment bytes
+    */
+public:
+    static const constexpr int ID_LEN = 16;
+    static const constexpr int HEADER_LEN = 4 + 4 + ID_LEN;     //magic, chunk length, blob id
+    static const constexpr int REF_LEN = 4 + ID_LEN + 8 + 4;    //magic, blob id, length, chunk length
+    static const constexpr int CHUNK_PREFIX_LEN = 8 + 1;        //chunk index and last flag in front of the plain chunk
+
+private:
+    std::filesystem::path dir;      //directory of the blobs
+    unsigned char cipher_mode;      //authenticated cipher mode of the vault
+    Bytes key;                      //key derived from the data key, the blob keys are derived from it
+
+private:
+    Bytes getBlobKey(const Bytes id) const;
+    void checkHeader(std::istream& file, const BlobRef& ref) const;                   //throws runtime_error if the file does not belong to the reference
+    Bytes readChunk(std::istream& file, const BlobRef& ref, unsigned long index) const;    //decrypts the chunk at the read position of the file
+
+public:
+    BlobStore(const std::filesystem::path vault_path, unsigned char const cipher_mode, const Bytes datakey);
+    BlobRef write(std::istream& in, unsigned long chunk_len=BLOB_CHUNK_LEN) const;    //encrypts the stream chunk by chunk into a new blob
+    void read(const BlobRef& ref, std::ostream& out) const;                          //decrypts the blob chunk by chunk into the stream
+    Bytes readChunk(const BlobRef& ref, unsigned long index) const;                   //decrypts one chunk (throws range_error if it does not exist)
+    std::filesystem::path getBlobPath(const Bytes id) const;
+
+    static unsigned long getChunkNumber(const BlobRef& ref) noexcept;     //an empty attachment has one empty chunk
+    static Bytes encodeRef(const BlobRef& ref);
+    static std::optional<BlobRef> decodeRef(const BytesView value) noexcept;     //nothing if the value is not a reference
+    static std::filesystem::path getBlobDir(const std::filesystem::path vault_path);
+    static unsigned long removeUnreferenced(const std::filesystem::path vault_path, const std::set<std::string> ids, long grace_seconds=BLOB_GRACE_SECONDS);  //removes the older blobs that are not in ids (hex) and returns their number
+};
+
+#endif //BLOBSTORE_H
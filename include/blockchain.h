@@ -0,0 +1,56 @@
+#pragma once
+#ifndef BLOCKCHAIN_H
+#define BLOCKCHAIN_H
+
+#include <set>
+#include <utility>
+#include <vector>
+#include "block.h"
+#include "hash.h"
+
+class BlockChain{
+    /*
+    the blockchain holds the blocks of an encryption file
+    each block has the length of the hash size, the last block is filled up with zeros
+    the salt of the first block is the decrypted salt from the data header,
+    every other salt is the previous salt + hash(previous salt + passwordhash)
+    the chain remembers which blocks were changed since it was loaded, so only these blocks
+    have to be encoded again (getDirtyEncoded), an insert or remove only copies the data behind its position
+    pman does not write mode 1 files: vaults use the authenticated modes and save each change as an appended frame of the record log (record_log.h)
+    */
+private:
+    const Hash* hash;                   //hash function that is used to derive the salts
+    Bytes passwordhash;                 //passwordhash (hash that is derived from the password)
+    Bytes first_salt;                   //salt of the first block
+    unsigned long data_len;             //length of the plain data in bytes
+    std::vector<Block> chain;           //the blocks of the chain
+    std::set<unsigned long> dirty;      //indices of the blocks that changed since load (or since the last getDirtyEncoded call)
+
+private:
+    Bytes calcNextSalt(const Bytes prev_salt) const;        //calculates the salt of the following block
+    void resizeChain(unsigned long block_num);              //adds or removes blocks at the end of the chain
+    void writeData(unsigned long pos, const Bytes data);    //writes the data into the blocks beginning at pos and marks the touched blocks dirty
+    void encodeDirty();                                     //encodes all dirty blocks
+    Bytes getDataFrom(unsigned long pos) const;             //returns the plain data behind pos (only the blocks from pos on are read)
+public:
+    BlockChain(const Hash* hash, Bytes passwordhash, Bytes salt);  //creates an empty chain (passwordhash and salt need the hash size)
+    unsigned int getBlockLen() const noexcept;      //getter for the block length (hash size)
+    unsigned long getBlockNumber() const noexcept;  //getter for the number of blocks in the chain
+    unsigned long getDataLen() const noexcept;      //getter for the length of the plain data
+    unsigned long getEncodedLen() const noexcept;   //getter for the length of the encoded data (block number * block length)
+
+    void setData(const Bytes data);                 //replaces all plain data (every block is dirty)
+    Bytes getData() const;                          //returns the plain data
+    void setEncoded(const Bytes encoded);           //loads encoded data from a file and decodes it (no block is dirty)
+    Bytes getEncoded();                             //encodes the dirty blocks and returns the full encoded data
+
+    void changeData(unsigned long pos, const Bytes data);       //overwrites the data at pos (can extend the data at the end)
+    void insertData(unsigned long pos, const Bytes data);       //inserts data at pos (all following bytes are shifted)
+    void removeData(unsigned long pos, unsigned long len);      //removes len bytes at pos (all following bytes are shifted)
+
+    bool isDirty() const noexcept;                              //returns true if some blocks changed
+    std::vector<unsigned long> getDirtyBlocks() const noexcept; //returns the indices of the changed blocks
+    std::vector<std::pair<unsigned long, Bytes>> getDirtyEncoded(); //encodes the changed blocks and returns them as (offset in the encoded data, encoded bytes) ranges. Resets the dirty state
+};
+
+#endif //BLOCKCHAIN_H
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+template <typename T>
+class BoundedQueue{
+    /*
+    a queue between two stages of a pipeline that holds at most max_len items
+    push waits while the queue is full (a fast producer cannot fill the memory), pop waits while it is empty
+    close wakes all waiting threads: push refuses new items, pop returns the queued items and then nothing
+    */
+private:
+    std::deque<T> items;
+    unsigned long max_len;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+
+public:
+    BoundedQueue(unsigned long max_len) : max_len(max_len == 0 ? 1 : max_len), closed(false){}
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool push(T item){      //returns false if the queue was closed (the item is dropped)
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->not_full.wait(lock, [this](){return this->items.size() < this->max_len || this->closed;});
+        if(this->closed){
+            return false;
+        }
+        this->items.push_back(std::move(item));
+        this->not_empty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop(){     //returns nothing if the queue is closed and empty
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->not_empty.wait(lock, [this](){return !this->items.empty() || this->closed;});
+        if(this->items.empty()){
+            return {};
+        }
+        T item = std::move(this->items.front());
+        this->items.pop_front();
+        this->not_full.notify_one();
+        return item;
+    }
+
+    void close(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closed = true;
+        this->not_full.notify_all();
+        this->not_empty.notify_all();
+    }
+};
+
+#endif //BOUNDEDQUEUE_H
@@ -6,6 +6,8 @@
 #include <vector>
 #include <optional>
 
+class BytesView;
+
 class Bytes{
     /*
     bytes datatype holds a byte vector
@@ -19,6 +21,7 @@ public:
     void print() const noexcept;    //prints the hex string of this byte vector
     void setBytes(std::vector<unsigned char> bytes) noexcept;   //set the bytes to a given value
     std::vector<unsigned char> getBytes() const noexcept;       //getter for the byte vector
+    BytesView getView() const noexcept;                         //returns a view on the byte vector (without copying it, valid until the bytes change)
     int getLen() const noexcept;                                //getter for the length in bytes
     void addByte(const unsigned char byte) noexcept;            //adds one byte at the end of the byte vector
     void addBytes(const Bytes b1) noexcept;                     //adds a other byte object at the end of the byte vector
@@ -33,9 +36,31 @@ public:
     friend Bytes operator-(Bytes b1, Bytes b2);     //performs an subtract elementwise (the second byte vector is subtracted from the first (elementwise) mod 256)
 };
 
+class BytesView{
+    /*
+    a view on bytes that are owned by someone else (a Bytes object, a read buffer or a mapped file)
+    the bytes are not copied, so the owner has to live longer than the view
+    */
+private:
+    const unsigned char* bytes;     //begin of the viewed bytes
+    unsigned long len;              //number of viewed bytes
+public:
+    BytesView() noexcept;                                       //creates an empty view
+    BytesView(const unsigned char* bytes, unsigned long len) noexcept;     //creates a view on len bytes
+    BytesView(const std::vector<unsigned char>& bytes) noexcept;           //creates a view on the vector
+    const unsigned char* data() const noexcept;                 //getter for the begin of the bytes
+    unsigned long getLen() const noexcept;                      //getter for the length in bytes
+    bool isEmpty() const noexcept;                              //returns true if the view has no bytes
+    unsigned char operator[](unsigned long i) const noexcept;   //returns the ith byte (without range check)
+    BytesView slice(unsigned long pos, unsigned long len) const;    //returns a view on len bytes beginning at pos (throws if it is out of range)
+    Bytes toBytes() const noexcept;                             //copies the viewed bytes into a Bytes object
+};
+
 std::string toHex(const unsigned char byte) noexcept;   //returns a string (with two chars) that is the hexadecimal representation of the byte
 std::string toHex(Bytes b) noexcept;                    //returns a string (with 2*len chars) that is the hexadecimal representation of the Bytes
 unsigned long toLong(const unsigned char byte) noexcept;   //returns a long that is the decimal representation of the byte
 unsigned long toLong(Bytes b) noexcept;                    //returns a long that is the decimal representation of the Bytes
+unsigned long toLong(BytesView b) noexcept;                //returns a long that is the decimal representation of the viewed bytes
+Bytes fromLong(unsigned long num, const int len=8);         //returns the num as len bytes (highest byte first), inverse of toLong
 
 #endif //BYTES_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #ifndef CHAINHASHMODES_H
 #define CHAINHASHMODES_H
 
+#include <atomic>
 #include "hash.h"
 #include "settings.h"
 
@@ -9,8 +10,8 @@ class ChainHashModes{
 public:
     static bool isModeValid(unsigned char const chainhash_mode) noexcept;
     static bool isChainHashValid(unsigned char const chainhash_mode, unsigned long iters, Bytes datablock) noexcept;
-    static Bytes performChainHash(unsigned char const chainhash_mode, unsigned long iters, Hash* hash, Bytes data);
-    static Bytes performChainHash(unsigned char const chainhash_mode, unsigned long iters, Hash* hash, std::string data);
+    static Bytes performChainHash(unsigned char const chainhash_mode, unsigned long iters, Bytes datablock, Hash* hash, Bytes data, const std::atomic<bool>* stop=nullptr);
+    static Bytes performChainHash(unsigned char const chainhash_mode, unsigned long iters, Bytes datablock, Hash* hash, std::string data, const std::atomic<bool>* stop=nullptr);
 };
 
 
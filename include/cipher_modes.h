@@ -0,0 +1,29 @@
+#pragma once
+#ifndef CIPHERMODES_H
+#define CIPHERMODES_H
+
+#include "bytes.h"
+#include "settings.h"
+
+class CipherModes{
+    /*
+    this class provides the cipher modes that can be used for the data of an encryption file
+    mode 1 is the add mod 256 blockchain (see blockchain.h), it is not handled here
+    mode 2 and 3 are authenticated ciphers from openssl (AES-256-GCM and ChaCha20-Poly1305)
+    the data is encrypted in chunks of CIPHER_CHUNK_SIZE bytes, each chunk has its own tag
+    so every modified or missing byte is detected while decrypting
+    */
+public:
+    static const constexpr int KEY_LEN = 32;    //key length of both openssl ciphers
+    static const constexpr int NONCE_LEN = 12;  //length of the random nonce at the beginning of the encrypted data
+    static const constexpr int TAG_LEN = 16;    //length of the tag behind each chunk
+
+    static bool isModeValid(unsigned char const cipher_mode) noexcept;
+    static bool isAuthenticated(unsigned char const cipher_mode) noexcept;     //returns true if the mode is an openssl cipher (mode 2 and 3)
+    static Bytes deriveKey(const Bytes passwordhash, const std::string purpose);   //derives a key for a purpose (like "data") from the passwordhash (HMAC-SHA256)
+    static unsigned long getEncryptedLen(unsigned char const cipher_mode, unsigned long data_len);  //returns the length of the encrypted data for the given plain data length
+    static Bytes encrypt(unsigned char const cipher_mode, const Bytes key, const Bytes data);       //encrypts the data with a new random nonce
+    static Bytes decrypt(unsigned char const cipher_mode, const Bytes key, const Bytes encrypted);  //decrypts the data and throws if a chunk was modified
+};
+
+#endif //CIPHERMODES_H
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <vector>
+#include "bytes.h"
+#include "settings.h"
+
+class Compression{
+    /*
+    this class provides the compression stage that runs before the data is encrypted
+    mode 0 stores the data as it is, mode 1 is a fast LZ77 codec (lz4 block format, see docs/compression.md)
+    the data is compressed in segments of SEGMENT_SIZE plain bytes, each segment is a frame with its own lengths,
+    so one segment can be decompressed without decompressing the segments before
+    */
+public:
+    static const constexpr int FRAME_HEADER_LEN = 8;    //plain length (4) and stored length (4) of a frame
+
+    static bool isModeValid(unsigned char const compression_mode) noexcept;
+    static Bytes compressBlock(const Bytes data);                           //compresses the data with the lz codec (no frame)
+    static Bytes decompressBlock(const Bytes data, unsigned long plain_len);    //decompresses lz codec data with the given plain length
+    static Bytes compress(unsigned char const compression_mode, const Bytes data, unsigned long segment_size=SEGMENT_SIZE);  //compresses the data segment by segment into frames
+    static Bytes decompress(unsigned char const compression_mode, const Bytes data);        //decompresses all frames
+    static std::vector<unsigned long> getSegmentOffsets(const Bytes data);                  //returns the offsets of the frames (only the frame headers are read)
+    static Bytes decompressSegment(const Bytes data, unsigned long index);                  //decompresses only the frame of the given segment
+};
+
+#endif //COMPRESSION_H
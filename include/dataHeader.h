@@ -2,36 +2,63 @@
 #ifndef DATAHEADER_H
 #define DATAHEADER_H
 
+#include <vector>
 #include "bytes.h"
 #include "hash_modes.h"
 #include "chainhash_modes.h"
+#include "cipher_modes.h"
+#include "compression.h"
+#include "keyslot.h"
 
 class DataHeader{
+public:
+    static const constexpr unsigned int KEY_CHECK_LEN = 32;    //length of the key check value (HMAC-SHA256)
+
 private:
     unsigned char hash_mode;   //the hash mode that is choosen (hash function)
     unsigned char hash_size;    //the size of the hash provided by the hash function (in Bytes)
-    unsigned char chainhash1_mode;  //chainhash mode for the first chainhash (password -> passwordhash)
-    unsigned char chainhash2_mode;  //chainhash mode for the second chainhash (passwordhash -> validate password)
-    unsigned long chainhash1_iters; //iterations for the first chainhash
-    unsigned long chainhash2_iters; //iterations for the second chainhash
-    unsigned char chainhash1_datablock_len; //the length of the first datablock
-    unsigned char chainhash2_datablock_len; //the length of the second datablock
-    Bytes chainhash1_datablock;     //the first datablock
-    Bytes chainhash2_datablock;     //the second datablock
-    Bytes valid_passwordhash;       //saves the hash that should be the result of the second chainhash
+    unsigned char cipher_mode;  //the cipher that is used to encrypt the data (blockchain or openssl cipher)
+    unsigned char compression_mode; //the compression that is used before the data is encrypted
+    std::vector<KeySlot> keyslots;  //each keyslot can unlock the data key with its own password (the first one always exists)
     Bytes enc_salt;                 //saves the encoded salt
+    Bytes key_check;                //HMAC of the data key, checks a data key that does not come from a password (agent)
     Bytes header_bytes;             //bytes that are in the header
 
 private:
 
 public:
     DataHeader(unsigned char const hash_mode);
+    static unsigned int readHeaderLength(const BytesView buf);     //reads the header length from the begin of the buffer (only the length fields are read)
     void setHeaderBytes(Bytes headerBytes);
+    void setHeaderBytes(const BytesView buf);       //parses the header at the begin of the buffer in one pass (the buffer can contain more data after the header)
+    Bytes getHeaderBytes() const;                   //returns the serialized header
+    void writeHeaderBytes(unsigned char* buf, unsigned long len) const;    //serializes the header into the preallocated buffer (len has to be at least the header length)
     unsigned int getHeaderLength() const noexcept;
+    //the following setters change the first keyslot
     void setChainHash1(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock);
     void setChainHash2(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock);
     void setValidPasswordHashBytes(Bytes validBytes);
+    void setWrappedDataKey(Bytes wrapped);
+    Bytes getWrappedDataKey() const noexcept;
+
+    void setEncryptedSalt(Bytes salt);
+    Bytes getEncryptedSalt() const noexcept;
+
+    unsigned char getHashMode() const noexcept;
+    unsigned char getHashSize() const noexcept;
+    void setCipherMode(unsigned char mode);
+    unsigned char getCipherMode() const noexcept;
+    void setCompressionMode(unsigned char mode);
+    unsigned char getCompressionMode() const noexcept;
+
+    unsigned int getKeySlotNumber() const noexcept;
+    KeySlot& getKeySlot(unsigned int index);            //getter for a keyslot (to change it)
+    void addKeySlot(KeySlot keyslot);                   //adds a keyslot (it needs the same hash mode)
+    void removeKeySlot(unsigned int index);             //removes a keyslot (the last keyslot cannot be removed)
+    std::optional<Bytes> getDataKey(std::string password) const;   //tries all keyslots in parallel and returns the unwrapped data key (nothing if no keyslot matches)
+    void setPassword(std::string password, Bytes datakey, unsigned int index=0);    //sets the password of a keyslot (only the header changes, the data keeps its data key), throws if the data key does not match the key check value
+    bool isDataKeyValid(const Bytes datakey) const;     //compares the key check value of the data key in constant time (false if the header has no key check value)
 };
 
 
-#endif //DATAHEADER_H
\ No newline at end of file
+#endif //DATAHEADER_H
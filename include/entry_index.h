@@ -0,0 +1,51 @@
+#pragma once
+#ifndef ENTRYINDEX_H
+#define ENTRYINDEX_H
+
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class EntryIndex{
+    /*
+    in-memory index from a key (title or url of an entry) to the names of the records that hold the entry
+    a key can have several holders, lookups answer the one that was added last and the key stays until its last holder is removed
+    exact lookups use an open addressing hash table (linear probing, the capacity is a power of two and at most 70% is used),
+    so a lookup costs one hash and a few probes independent of the number of entries
+    prefix queries (autocomplete) use a sorted set of the keys, so a query is one search in the tree and then a scan of the results
+    changes update both structures, LogVault builds the index once when the records are loaded and then changes it with each record
+    */
+public:
+    static const constexpr unsigned long MIN_CAPACITY = 16;
+
+private:
+    struct Slot{
+        std::string key;
+        std::vector<std::string> values;    //holders of the key (the last one was added last)
+        unsigned char state = 0;    //0 free, 1 used, 2 removed (the probing continues behind removed slots)
+    };
+    std::vector<Slot> slots;            //hash table (capacity is a power of two)
+    std::set<std::string> sorted;       //all keys in ascending order
+    unsigned long size;                 //used slots
+    unsigned long removed;              //removed slots (they count for the load like used slots)
+
+private:
+    unsigned long findSlot(const std::string& key) const noexcept;     //slot of the key or the capacity if it does not exist
+    void rehash(unsigned long capacity);                                //moves all keys into a new table with the capacity
+
+public:
+    EntryIndex(unsigned long expected=0);       //reserves room for the expected number of keys
+
+    void put(const std::string key, const std::string value);  //adds the value as the latest holder of the key
+    bool remove(const std::string key);                        //removes the key with all holders, returns false if the key does not exist
+    bool remove(const std::string key, const std::string value);   //removes one holder (and the key with its last holder), returns false if the value does not hold the key
+    std::optional<std::string> find(const std::string key) const;
+    std::vector<std::pair<std::string, std::string>> findPrefix(const std::string prefix, unsigned long limit=100) const;    //sorted keys that begin with the prefix (at most limit)
+    unsigned long getSize() const noexcept;
+    unsigned long getCapacity() const noexcept;
+    void clear();                               //removes all keys (the capacity stays)
+};
+
+#endif //ENTRYINDEX_H
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef ENTRYRECORD_H
+#define ENTRYRECORD_H
+
+#include <string>
+#include "bytes.h"
+
+struct Entry{
+    /*
+    a credential entry with its fields (owning, used to create and change entries)
+    */
+    std::string title;
+    std::string username;
+    std::string secret;
+    std::string url;
+    std::string notes;
+    unsigned long created = 0;      //unix time (seconds)
+    unsigned long modified = 0;     //unix time (seconds)
+};
+
+class EntryView{
+    /*
+    reads the fields of an encoded entry record directly from the (decrypted) buffer, nothing is parsed or copied
+    the record has a fixed header with the field offsets, so a field is found with two reads from the header (see docs/entry_record.md)
+    the view is valid as long as the viewed buffer lives
+    */
+public:
+    static const constexpr unsigned char FIELD_TITLE = 0;
+    static const constexpr unsigned char FIELD_USERNAME = 1;
+    static const constexpr unsigned char FIELD_SECRET = 2;
+    static const constexpr unsigned char FIELD_URL = 3;
+    static const constexpr unsigned char FIELD_NOTES = 4;
+    static const constexpr unsigned char FIELD_NUMBER = 5;
+    static const constexpr unsigned char VERSION = 1;
+    static const constexpr unsigned long HEADER_LEN = 24 + 4*(FIELD_NUMBER + 1);     //length, version, reserved, timestamps, field offsets
+
+private:
+    BytesView record;       //the whole record (header and fields)
+
+public:
+    EntryView(const BytesView buffer);     //views the record at the begin of the buffer (throws if the header is corrupted or the record is cut off)
+
+    unsigned long getLen() const noexcept;                  //length of the record (the next record begins behind it)
+    BytesView getField(unsigned char field) const;          //view on the field (throws range_error for an unknown field)
+    std::string getFieldString(unsigned char field) const;  //copy of the field
+    unsigned long getCreated() const noexcept;
+    unsigned long getModified() const noexcept;
+    BytesView getRecord() const noexcept;
+    Entry toEntry() const;                                  //copies all fields
+
+    static Bytes encode(const Entry& entry);                //encodes the entry as a record (throws length_error if it does not fit into 4 bytes of length)
+    static bool isRecord(const BytesView value) noexcept;   //true if the value is exactly one valid entry record (a text value never is, its first bytes would be a length of more than 500 MB)
+    static unsigned long getEncodedLen(const Entry& entry) noexcept;
+};
+
+#endif //ENTRYRECORD_H
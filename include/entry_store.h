@@ -0,0 +1,31 @@
+#pragma once
+#ifndef ENTRYSTORE_H
+#define ENTRYSTORE_H
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bytes.h"
+
+class EntryStore{
+    /*
+    abstract class for the named entries of an unlocked vault
+    the batch commands (batch.h) work on an entry store, so they can run on a vault file (log_vault.h) or on the snapshots of pman serve (vault_server.h)
+    the import (importer.h) writes into an entry store
+    */
+public:
+    EntryStore() = default;
+    virtual void put(const std::string name, const Bytes value) = 0;           //adds or changes an entry
+    virtual void putAll(const std::vector<std::pair<std::string, Bytes>> records){  //adds or changes many entries (stores that write every change can save them at once)
+        for(const std::pair<std::string, Bytes>& record : records){
+            this->put(record.first, record.second);
+        }
+    }
+    virtual bool remove(const std::string name) = 0;                            //removes an entry, returns false if it does not exist
+    virtual std::optional<Bytes> get(const std::string name) const = 0;
+    virtual std::vector<std::string> getNames() const = 0;                      //sorted names of all entries
+    virtual ~EntryStore() {};
+};
+
+#endif //ENTRYSTORE_H
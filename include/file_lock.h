@@ -0,0 +1,49 @@
+#pragma once
+#ifndef FILELOCK_H
+#define FILELOCK_H
+
+#include <filesystem>
+#include "settings.h"
+
+struct FileStamp{
+    /*
+    identity and version of a file: an append changes the size, an atomic rewrite (rename) changes the inode
+    */
+    unsigned long long dev = 0;
+    unsigned long long ino = 0;
+    unsigned long long size = 0;
+    long long mtime = 0;            //modification time (nanoseconds)
+
+    bool operator==(const FileStamp& other) const noexcept{return this->dev == other.dev && this->ino == other.ino && this->size == other.size && this->mtime == other.mtime;}
+    bool operator!=(const FileStamp& other) const noexcept{return !(*this == other);}
+};
+
+class FileLock{
+    /*
+    a shared or exclusive lock between processes (and between threads with their own FileLock) on a file
+    the lock is held on a separate lock file (<file>.lock), because the files are replaced with a rename on save and a lock on the old inode would protect nothing
+    many readers can hold shared locks at the same time, a writer holds the exclusive lock only while it writes
+    linux uses open file description locks (F_OFD_SETLK), other unix systems flock and windows LockFileEx
+    the lock is released when the FileLock is destroyed (and by the kernel if the process dies)
+    */
+private:
+    int fd;             //open lock file (-1 if moved)
+    bool exclusive;
+
+public:
+    static const constexpr long WAIT_FOREVER = -1;
+
+    FileLock(const std::filesystem::path file, bool exclusive, long timeout_ms=LOCK_TIMEOUT_MS);    //locks the lock file of the file (0 tries once, throws runtime_error if the lock is not free in time)
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+    FileLock(FileLock&& other) noexcept;
+    FileLock& operator=(FileLock&& other) noexcept;
+    ~FileLock();
+
+    bool isExclusive() const noexcept;
+
+    static std::filesystem::path getLockPath(const std::filesystem::path file);    //path of the lock file of a file
+    static FileStamp getStamp(const std::filesystem::path file);                   //stamp of the file (all zero if it does not exist)
+};
+
+#endif //FILELOCK_H
@@ -10,8 +10,16 @@
 #include <filesystem>
 #include <fstream>
 #include <optional>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "bytes.h"
+#include "mapped_vault.h"
+#include "atomic_writer.h"
+#include "file_lock.h"
 
 class FileHandler{
 private:
@@ -19,23 +27,33 @@ private:
     const std::string appDataName = "data.txt";
     std::string fileName;
     std::filesystem::path encryption_filepath;
+    std::unordered_map<std::string, std::string> app_settings;  //settings of the app data file (loaded once)
+    bool app_settings_loaded;                                   //true if the app data file was read
+    bool app_settings_valid;                                    //false if the app data file is not in the right format
+    std::unordered_set<std::string> app_settings_changed;       //settings that were set or removed since they were written
 public:
     const static std::string extension;
 private:
     void getAppDataDir(); // Get the path to the directory where the application can store data
     void createAppDataDir(); // Create the application data directory if it doesn't exist
-    void createAppDataFile();   //creates the app data file if it does not exist
-    bool setAppSetting(std::string setting_name, std::string setting_value) const;
-    bool removeAppSetting(std::string setting_name) const;
+    void loadAppSettings();     //reads the app data file into the settings map (only the first call reads the file, throws runtime_error if it cannot be locked)
+    bool setAppSetting(std::string setting_name, std::string setting_value);
+    bool removeAppSetting(std::string setting_name);
     bool isAppDataFile() const noexcept;
-    std::optional<std::string> getAppSetting(std::string setting_name) const;
+    std::optional<std::string> getAppSetting(std::string setting_name);
     std::filesystem::path getAppDataFilePath() const noexcept;
-    void resetAppData() const noexcept;
 public:
     FileHandler();
+    ~FileHandler();     //writes changed settings back
+    bool isAppDataValid() noexcept;     //false if the app data file is not in the right format (nothing is asked here, only the interactive app asks to reset it)
+    void resetAppData() const noexcept;
+    bool flushAppSettings();    //merges the changed settings into the file with one atomic write (returns false if the write failed)
     bool setEncryptionFilePath(std::string path) noexcept;
-    std::string getEncryptionFilePath() const noexcept;
+    std::string getEncryptionFilePath() noexcept;      //empty if the path is not set or the app data cannot be read
     Bytes getFirstBytes(int num) const;
+    FileLock lockEncryptionFile(bool exclusive) const;     //locks the encryption file against writes (shared) or against all other users (exclusive) of other processes
+    MappedVault mapEncryptionFile() const;      //maps the encryption file (header and body can be read without copying, hold a shared lock while reading)
+    SaveReport writeEncryptionFile(const std::vector<BytesView> parts) const;  //replaces the encryption file atomically with the parts (header, body, trailer)
 };
 
 #endif //FILEHANDLER_H
\ No newline at end of file
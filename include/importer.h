@@ -0,0 +1,45 @@
+#pragma once
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include <functional>
+#include <iostream>
+#include <optional>
+#include "entry_record.h"
+#include "entry_store.h"
+
+struct ImportReport{
+    /*
+    result of an import (Importer::run)
+    */
+    unsigned long entries = 0;      //imported entries
+    unsigned long renamed = 0;      //entries that got a suffix because their name was already used
+    unsigned long skipped = 0;      //entries that were not imported because the same entry is stored already (e.g. by an import that failed)
+    unsigned long bytes = 0;        //length of the encoded entries
+    unsigned long batches = 0;      //calls of putAll (appends of a vault file)
+    unsigned int threads = 0;       //threads that encoded the entries
+    double seconds = 0;
+};
+
+class Importer{
+    /*
+    pman import: reads the csv or json export of another password manager and stores each item as an entry record (entry_record.h, see docs/import.md)
+    the import is a pipeline of three stages with bounded queues (bounded_queue.h) between them:
+    one thread parses the stream and names the entries, a pool of threads encodes them, the calling thread writes batches of IMPORT_BATCH_LEN records
+    (a vault file encrypts the frames of a batch in parallel and appends them with one write and one sync)
+    the export is never held in memory, at most two queues and one batch of entries are
+    an entry that the store holds already under its name (or a suffix) with the same fields is skipped, so a failed import can be run again,
+    the parser reads these records while the batches are written, so the store has to be thread safe (LogVault and ShardedVault are)
+    */
+public:
+    static const constexpr unsigned char FORMAT_CSV = 1;
+    static const constexpr unsigned char FORMAT_JSON = 2;
+    static const constexpr unsigned int MAX_JSON_DEPTH = 64;   //deeper nested json is refused
+
+    static std::optional<unsigned char> getFormat(const std::string name) noexcept;     //format of a name (csv or json) or of the extension of a file path
+    static void parseCsv(std::istream& in, const std::function<bool(Entry)> onEntry);   //calls onEntry for each row (the first row names the columns), stops if it returns false
+    static void parseJson(std::istream& in, const std::function<bool(Entry)> onEntry);  //calls onEntry for each item (an array of items or an object with an items array), stops if it returns false
+    static ImportReport run(std::istream& in, unsigned char format, EntryStore& store, unsigned int threads=0);    //imports all entries (0 threads = all cores), existing names are not overwritten, identical entries are skipped
+};
+
+#endif //IMPORTER_H
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef KEYSLOT_H
+#define KEYSLOT_H
+
+#include <atomic>
+#include <optional>
+#include "bytes.h"
+#include "hash_modes.h"
+#include "chainhash_modes.h"
+#include "keywrap.h"
+
+class KeySlot{
+    /*
+    a keyslot holds everything that is needed to unlock the data key with one password
+    (both chainhashes, the valid passwordhash and the wrapped data key)
+    a data header can have multiple keyslots, so a file can be shared with a password for each user
+    */
+private:
+    unsigned char hash_mode;        //the hash mode of the file (hash function)
+    unsigned char hash_size;        //the size of the hash provided by the hash function (in Bytes)
+    unsigned char chainhash1_mode;  //chainhash mode for the first chainhash (password -> passwordhash)
+    unsigned char chainhash2_mode;  //chainhash mode for the second chainhash (passwordhash -> validate password)
+    unsigned long chainhash1_iters; //iterations for the first chainhash
+    unsigned long chainhash2_iters; //iterations for the second chainhash
+    Bytes chainhash1_datablock;     //the first datablock
+    Bytes chainhash2_datablock;     //the second datablock
+    Bytes valid_passwordhash;       //saves the hash that should be the result of the second chainhash
+    Bytes enc_datakey;              //saves the data key wrapped with the passwordhash (keywrap.h)
+
+public:
+    KeySlot(unsigned char const hash_mode);
+    unsigned int getLength() const;     //length of the keyslot in the data header (dataheader.md)
+    bool isComplete() const noexcept;   //returns true if all fields are set
+    unsigned char getHashMode() const noexcept;
+    void setChainHash1(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock);
+    void setChainHash2(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock);
+    void setValidPasswordHashBytes(Bytes validBytes);
+    void setWrappedDataKey(Bytes wrapped);
+    unsigned char getChainHash1Mode() const noexcept;
+    unsigned long getChainHash1Iters() const noexcept;
+    Bytes getChainHash1Datablock() const noexcept;
+    unsigned char getChainHash2Mode() const noexcept;
+    unsigned long getChainHash2Iters() const noexcept;
+    Bytes getChainHash2Datablock() const noexcept;
+    Bytes getValidPasswordHash() const noexcept;
+    Bytes getWrappedDataKey() const noexcept;
+
+    Bytes calcPasswordHash(std::string password, const std::atomic<bool>* stop=nullptr) const;     //performs the first chainhash (password -> passwordhash)
+    bool isPasswordHashValid(Bytes passwordhash, const std::atomic<bool>* stop=nullptr) const;     //performs the second chainhash and compares it with the valid passwordhash
+    std::optional<Bytes> getDataKey(std::string password, const std::atomic<bool>* stop=nullptr) const;    //returns the unwrapped data key (nothing if the password is wrong or stop was set)
+    void setPassword(std::string password, Bytes datakey);     //sets the valid passwordhash and wraps the data key for the password (uses the set chainhashes)
+};
+
+#endif //KEYSLOT_H
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef KEYWRAP_H
+#define KEYWRAP_H
+
+#include <optional>
+#include "bytes.h"
+
+class KeyWrap{
+    /*
+    the data of a file is encrypted with a random data key, not with the passwordhash
+    the data key is wrapped (encrypted with AES-256-GCM) by a key that is derived from the passwordhash
+    and stored in the data header. Changing the password or the iterations only rewraps the data key,
+    so only the header has to be written again
+    */
+public:
+    static Bytes generateDataKey(const int len);                                        //generates a random data key with the given length (hash size)
+    static unsigned long getWrappedLen(const int len);                                 //returns the length of a wrapped data key
+    static Bytes wrap(const Bytes passwordhash, const Bytes datakey);                   //wraps the data key with the passwordhash
+    static std::optional<Bytes> unwrap(const Bytes passwordhash, const Bytes wrapped);  //unwraps the data key (nothing if the passwordhash is wrong or the wrapped key was modified)
+};
+
+#endif //KEYWRAP_H
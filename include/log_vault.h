@@ -0,0 +1,117 @@
+#pragma once
+#ifndef LOGVAULT_H
+#define LOGVAULT_H
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include "dataHeader.h"
+#include "record_log.h"
+#include "vault_unlock.h"
+#include "atomic_writer.h"
+#include "blob_store.h"
+#include "entry_index.h"
+#include "entry_store.h"
+#include "file_lock.h"
+#include "name_index.h"
+#include "search_filter.h"
+#include "segment_mac.h"
+
+struct NameLookup{
+    /*
+    result of a lookup of one record (LogVault::lookup)
+    */
+    std::optional<Bytes> value;         //value of the record (nothing if it does not exist)
+    bool used_index = false;            //false if the whole log was decrypted (no valid name index)
+    unsigned long decrypted_len = 0;    //number of decrypted bytes (index and frames)
+};
+
+struct SearchResult{
+    /*
+    result of a search over the searchable texts of the records (LogVault::search)
+    */
+    std::vector<std::string> names;         //records that contain the query (sorted)
+    bool used_filters = false;              //false if the whole log was decrypted (no valid search filters)
+    unsigned long segments = 0;             //segments of the filters
+    unsigned long scanned_segments = 0;     //segments that were decrypted because their filter may contain the query
+    unsigned long decrypted_len = 0;        //number of decrypted bytes (filters and frames)
+    double seconds = 0;
+};
+
+class LogVault : public EntryStore{
+    /*
+    a vault file with the data header followed by a record log (record_log.h)
+    every change appends one frame and syncs the file, the rest of the file is not written again
+    if the garbage passes the threshold, a background thread rewrites the file atomically with the compacted log
+    changes wait while a compaction writes the file
+    other processes can use the same file: loads hold a shared lock, appends the exclusive lock (file_lock.h),
+    a compaction writes the new file under the shared lock and only takes the exclusive lock to check that the file did not change and to rename it
+    and before a change is appended the records are read again if another process changed the file
+    a name index (name_index.h), search filters (search_filter.h) and a mac table (segment_mac.h) are written after each compaction
+    and when the vault is closed with too much of the log not indexed, so lookup can read a single record and search only the segments
+    that may match without decrypting the whole log, and pman scrub can check the file without decrypting it
+    attachments are blobs next to the vault (blob_store.h), a compaction removes the blobs that are no longer referenced
+    the titles and urls of the entry records are kept in entry indexes (entry_index.h) that are built when the records are loaded
+    and changed with each record, so findEntry finds the record of an entry without reading the other records
+    */
+private:
+    std::filesystem::path path;     //path of the vault file
+    Bytes header;                   //serialized data header at the begin of the file
+    RecordLog log;                  //records of the file
+    NameIndex name_index;           //keys of the name index
+    SearchFilter search_filter;     //keys of the search filters (without segments)
+    Bytes mac_key;                  //key of the segment macs of the file
+    EntryIndex titles;              //titles of the entry records to their record names
+    EntryIndex urls;                //urls of the entry records to their record names
+    mutable std::mutex mutex;       //guards the log and the file
+    std::thread compactor;          //background compaction (if one was started)
+    std::atomic<bool> compacting;   //true while the background compaction runs
+    SaveReport last_save;           //report of the last append or compaction
+    FileStamp stamp;                //stamp of the file when it was last read or written by this vault
+    long lock_timeout;              //time to wait for the file lock (ms)
+    unsigned long indexed_len;      //length of the log that the name index covers
+    unsigned long reloads;          //number of times the records were read from the file
+
+private:
+    void reload();                          //reads the records from the file again (the locks have to be held)
+    bool reloadIfChanged();                 //reads the records again if another process changed the file (the locks have to be held)
+    void append(const Bytes frame);         //appends the frame behind the valid log (the lock has to be held)
+    void compactLocked();                   //rewrites the file with the compacted log (the lock has to be held, takes the file locks)
+    void startCompaction();                 //starts the background compaction if it is needed and not running
+    void indexEntries();                    //builds the entry indexes from all records (the lock has to be held)
+    void indexEntry(const std::string& name);      //adds the title and url of the record if it is an entry (the lock has to be held)
+    void unindexEntry(const std::string& name);    //removes the title and url of the record from the entry indexes (before it changes, the lock has to be held)
+    void writeIndexLocked(const BytesView file);   //writes the name index, the search filters and the mac table of the current log from the file content (header and log, the lock has to be held)
+
+public:
+    LogVault(const std::filesystem::path path, const DataHeader& header, const Bytes datakey);     //loads the vault file (an empty or missing file is created with the header)
+    LogVault(const std::filesystem::path path, const DataHeader& header, const UnlockedVault unlocked);    //uses the log that was already loaded from the file (see vault_unlock.h)
+    LogVault(const LogVault&) = delete;
+    LogVault& operator=(const LogVault&) = delete;
+    ~LogVault();                            //waits for a running compaction and writes the name index if too much of the log is not indexed
+
+    void put(const std::string name, const Bytes value);   //adds or changes a record (one append)
+    void putAll(const std::vector<std::pair<std::string, Bytes>> records);     //adds or changes the records with one append (the frames are encrypted in parallel)
+    bool remove(const std::string name);                    //removes a record (one append), returns false if it does not exist
+    std::optional<Bytes> get(const std::string name) const;
+    std::vector<std::string> getNames() const;
+    std::optional<std::string> findEntry(const std::string key) const;     //name of the entry record with the title or url (the title is checked first)
+    std::vector<std::string> findEntries(const std::string prefix, unsigned long limit=100) const;     //names of the entry records whose title or url begins with the prefix (sorted, at most limit)
+    unsigned long getRecordNumber() const;
+    unsigned long getFileLen() const;
+    SaveReport getLastSave() const;
+    bool needsCompaction() const;           //true if the garbage of the log passes the threshold (settings.h)
+    bool refresh();                         //reads the changes of other processes (returns true if the file changed)
+    unsigned long getReloadCount() const;   //changes whenever the records were read from the file again (by a change, a refresh or a compaction)
+    void setLockTimeout(long timeout_ms) noexcept;     //time to wait for the file lock (FileLock::WAIT_FOREVER waits until it is free)
+    void writeIndex();                      //writes the name index, the search filters and the mac table now
+
+    static NameLookup lookup(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, const std::string name);     //reads one record with the name index (decrypts the whole log if there is no valid index)
+    static ScrubReport scrub(const std::filesystem::path path, const Bytes datakey, unsigned int threads=0);    //checks the file with its mac table in parallel without decrypting it (throws runtime_error if there is no mac table)
+    static SearchResult search(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, const std::string query, unsigned int threads=0);   //finds the records that contain the query, scans the candidate segments in parallel (0 threads = all cores)
+    void compact();                         //compacts the file now (waits for a running compaction first)
+    void waitForCompaction();               //waits until a background compaction has finished
+};
+
+#endif //LOGVAULT_H
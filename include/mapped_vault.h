@@ -0,0 +1,44 @@
+#pragma once
+#ifndef MAPPEDVAULT_H
+#define MAPPEDVAULT_H
+
+#include <filesystem>
+#include <vector>
+#include "bytes.h"
+
+class MappedVault{
+    /*
+    maps the encryption file once (read only) and gives views on the header and the body
+    the views are valid as long as the MappedVault lives, so reading the header or the body again costs nothing
+    the kernel gets hints how the file is read: the header is needed at once, the body is read sequentially
+    (on systems without mmap the file is read once into a buffer)
+    */
+private:
+    unsigned char* data;                //begin of the mapped file (nullptr if the file is empty)
+    unsigned long len;                  //length of the file
+    unsigned int header_len;            //length of the data header (computed once when the file is mapped)
+    std::vector<unsigned char> buffer;  //holds the file if it cannot be mapped
+
+private:
+    void unmap() noexcept;
+    void advise(unsigned long offset, unsigned long len, int advice) const noexcept;    //gives the kernel a hint for the pages of the range
+
+public:
+    MappedVault(const std::filesystem::path path);     //maps the file (throws if it cannot be opened or the header is corrupted)
+    MappedVault(const MappedVault&) = delete;
+    MappedVault& operator=(const MappedVault&) = delete;
+    MappedVault(MappedVault&& other) noexcept;
+    MappedVault& operator=(MappedVault&& other) noexcept;
+    ~MappedVault();
+
+    bool isEmpty() const noexcept;
+    unsigned long getLen() const noexcept;
+    unsigned int getHeaderLength() const noexcept;
+    BytesView getView() const noexcept;         //view on the whole file
+    BytesView getHeader() const noexcept;       //view on the data header (the header pages are read ahead)
+    BytesView getBody() const noexcept;         //view on everything behind the header (the body pages are read sequentially)
+    void adviseRandom() const noexcept;         //hint that the body is read in single segments (no read ahead)
+    void prefetch() const noexcept;             //hint that the whole file is needed soon (the kernel starts reading it)
+};
+
+#endif //MAPPEDVAULT_H
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bytes.h"
+
+class NameIndex{
+    /*
+    encrypted index of a record log vault, stored next to the vault (<vault>.idx, see docs/record_log.md)
+    it maps keyed hashes of the record names (HMAC-SHA256 with a key derived from the data key, the names are not stored) to the positions of their latest frames,
+    so one record is found by decrypting the index and one frame instead of the whole log
+    the index covers the log up to covered_len, frames behind it (appended later) are read from the log
+    the log id (sha256 of the begin of the log) ties the index to one version of the log, a compaction writes a new index
+    */
+public:
+    static const constexpr int HASH_LEN = 16;                   //length of the keyed name hashes in the index
+    static const constexpr int ENTRY_LEN = HASH_LEN + 8;        //name hash and frame position
+    static const constexpr unsigned long LOG_ID_LEN = 4096;     //bytes at the begin of the log that are hashed for the log id
+    static const constexpr int PREFIX_LEN = 4 + 8 + 8 + 32;     //magic, covered length, next sequence number, log id (readable without the key)
+
+private:
+    unsigned char cipher_mode;      //authenticated cipher mode of the vault
+    Bytes enc_key;                  //key that encrypts the index
+    Bytes mac_key;                  //key of the name hashes
+    Bytes entries;                  //sorted entries of the loaded index
+    unsigned long covered_len;      //length of the log that is indexed
+    unsigned long next_seq;         //sequence number of the first frame behind the covered log
+    Bytes log_id;
+
+public:
+    NameIndex(unsigned char const cipher_mode, const Bytes datakey);
+    Bytes getNameHash(const std::string name) const;
+    Bytes encode(const std::vector<std::pair<std::string, unsigned long>> offsets, unsigned long covered_len, unsigned long next_seq, const Bytes log_id) const;  //encrypted index file
+    void load(const BytesView file);                            //decrypts the index file (throws runtime_error if it was modified or is corrupted)
+    std::optional<unsigned long> find(const std::string name) const;   //position of the latest frame of the name (binary search in the loaded entries)
+    unsigned long getEntryNumber() const noexcept;
+    unsigned long getCoveredLen() const noexcept;
+    unsigned long getNextSeq() const noexcept;
+    Bytes getLogId() const noexcept;
+
+    static Bytes calcLogId(const BytesView log, unsigned long covered_len);    //sha256 of the first LOG_ID_LEN bytes of the covered log
+    static std::filesystem::path getIndexPath(const std::filesystem::path vault_path);
+    static std::optional<unsigned long> readCoveredLen(const std::filesystem::path index_path) noexcept;     //covered length from the prefix of the index file (not authenticated)
+};
+
+#endif //NAMEINDEX_H
@@ -2,6 +2,7 @@
 #ifndef PWFUNC_H
 #define PWFUNC_H
 
+#include <atomic>
 #include "hash.h"
 
 class PwFunc{
@@ -14,11 +15,14 @@ class PwFunc{
     */
 private:
     const Hash* hash;       //stores the hash function that should be used
+    const std::atomic<bool>* stop = nullptr;   //if this flag gets true, a running chainhash stops and returns empty bytes
+    bool isStopped() const noexcept;
 public:
     static bool isPasswordValid(std::string password) noexcept;
 
     PwFunc() = default;
     PwFunc(const Hash* hash) noexcept;      //sets the hash function
+    void setStopFlag(const std::atomic<bool>* stop) noexcept;  //sets a flag that can stop a running chainhash from another thread
     Bytes chainhash(const std::string password, unsigned long iterations=1) const noexcept;       //performs a chainhash
     Bytes chainhashWithConstantSalt(const std::string password, unsigned long iterations=1, const std::string salt="") const noexcept;    //adds a constant salt each iteration
     Bytes chainhashWithCountSalt(const std::string password, unsigned long iterations=1, unsigned long salt_start=1) const noexcept;    //adds a salt (number that counts up each iteration)
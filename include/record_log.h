@@ -0,0 +1,79 @@
+#pragma once
+#ifndef RECORDLOG_H
+#define RECORDLOG_H
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include "bytes.h"
+#include "cipher_modes.h"
+#include "compression.h"
+
+struct LogRecord{
+    /*
+    latest version of a record in the log
+    */
+    Bytes value;                    //plain value of the record
+    unsigned long frame_len = 0;    //length of the frame of this version in the log
+    unsigned long offset = 0;       //position of the frame of this version in the log
+};
+
+struct LogFrame{
+    /*
+    one decrypted frame of the log
+    */
+    unsigned long seq = 0;          //sequence number
+    unsigned char type = 0;         //RECORD_PUT or RECORD_TOMBSTONE
+    std::string name;
+    Bytes value;                    //empty for tombstones
+};
+
+class RecordLog{
+    /*
+    the body of a vault with an authenticated cipher mode is an append-only log of encrypted records (see docs/record_log.md)
+    adding or changing a record appends a new version, removing a record appends a tombstone
+    while loading, the latest version of each record wins. Old versions and tombstones are garbage
+    that is removed by rewriting the log (compaction)
+    this class holds the records in memory and encodes the frames, the file is written by LogVault
+    the value of each frame is compressed before it is encrypted if the header sets a compression mode (compression.h),
+    the sequence number and the name stay plain, so the length of a frame does not depend on its sequence number
+    */
+public:
+    static const constexpr int FRAME_HEADER_LEN = 4;        //length of the encrypted record in front of each frame
+    static const constexpr unsigned char RECORD_PUT = 1;
+    static const constexpr unsigned char RECORD_TOMBSTONE = 2;
+
+private:
+    unsigned char cipher_mode;                  //authenticated cipher mode that encrypts the records
+    unsigned char compression_mode;             //compression of the values before they are encrypted
+    Bytes key;                                  //key derived from the data key
+    std::map<std::string, LogRecord> records;   //latest version of each existing record
+    unsigned long log_len;                      //length of the valid log in bytes
+    unsigned long live_len;                     //length of the frames of the latest versions
+    unsigned long next_seq;                     //sequence number of the next frame (frames are numbered from the begin of the log)
+
+public:
+    RecordLog(unsigned char const cipher_mode, const Bytes datakey, unsigned char const compression_mode=0);
+    Bytes encodeFrame(unsigned long seq, unsigned char type, const std::string& name, const Bytes& value) const;    //encrypts one record as a frame (the records in memory are not changed)
+    unsigned long load(const BytesView log);                    //replays the log and returns the valid length (a cut off last frame is ignored, other damage throws)
+    LogFrame decodeFrame(const BytesView frame) const;          //decrypts one frame (with its length field), throws runtime_error if it was modified or is corrupted
+    unsigned long readFrames(const BytesView log, unsigned long begin, unsigned long seq, const std::function<void(const LogFrame&, unsigned long, unsigned long)> onFrame) const;   //decrypts the frames from begin on (the first has the sequence number seq) and calls onFrame with each frame, its position and length, returns the end of the valid log (like load)
+    static unsigned long getFrameLen(const BytesView log, unsigned long pos) noexcept;     //length of the frame at pos (0 if the frame is cut off)
+    Bytes put(const std::string name, const Bytes value);       //adds or changes the record and returns the frame to append
+    Bytes putAll(const std::vector<std::pair<std::string, Bytes>> records, unsigned int threads=0);    //adds or changes the records in order and returns their frames to append (encrypted in parallel, 0 threads = all cores)
+    std::optional<Bytes> remove(const std::string name);        //removes the record and returns the tombstone frame to append (nothing if the record does not exist)
+    std::optional<Bytes> get(const std::string name) const;
+    std::vector<std::string> getNames() const;                  //names of all records (sorted)
+    std::vector<std::pair<std::string, unsigned long>> getOffsets() const;    //names of all records with the position of their latest frame
+    unsigned long getRecordNumber() const noexcept;
+    unsigned long getLogLen() const noexcept;
+    unsigned long getNextSeq() const noexcept;
+    unsigned long getGarbageLen() const noexcept;               //length of old versions and tombstones
+    bool needsCompaction() const noexcept;                      //returns true if the garbage passes the threshold (settings.h)
+    Bytes getCompacted() const;                                 //encodes only the latest versions as a new log
+    void setCompacted(const unsigned long len);                 //the compacted log of this length replaced the log
+};
+
+#endif //RECORDLOG_H
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef SEARCHFILTER_H
+#define SEARCHFILTER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bytes.h"
+#include "settings.h"
+
+struct SearchSegment{
+    /*
+    one segment of the log in the search filters
+    */
+    unsigned long begin = 0;                //position of the first frame in the log
+    unsigned long end = 0;                  //position behind the last frame
+    std::vector<unsigned long> offsets;     //positions of the latest frames in the segment (old versions are not searched)
+    std::vector<uint64_t> filter;           //bloom filter of the keyed trigram hashes
+};
+
+class SearchFilter{
+    /*
+    encrypted bloom filters of a record log vault, stored next to the vault (<vault>.flt, see docs/record_log.md)
+    the log is split into segments of about SEARCH_SEGMENT_LEN bytes, each segment has a bloom filter of the trigrams of the searchable text
+    of its records (name and the title, username, url and notes of entry records, never the secret or other values)
+    the trigrams are hashed with a key derived from the data key (HMAC-SHA256), so the filters do not leak text even without the encryption
+    a search decrypts the filters and only the frames of the segments that may contain all trigrams of the query
+    */
+public:
+    static const constexpr int PROBES = 7;          //bits that are set for each trigram
+    static const constexpr int BITS_PER_TOKEN = 10; //about 1% false positives
+    static const constexpr int PREFIX_LEN = 4 + 8 + 8 + 32;     //magic, covered length, next sequence number, log id (readable without the key)
+
+private:
+    unsigned char cipher_mode;                      //authenticated cipher mode of the vault
+    Bytes enc_key;                                  //key that encrypts the filters
+    Bytes token_key;                                //key of the trigram hashes
+    std::vector<SearchSegment> segments;
+    unsigned long covered_len;                      //length of the log that is covered by the segments
+    unsigned long next_seq;                         //sequence number of the first frame behind the covered log
+    Bytes log_id;
+    std::unordered_map<uint32_t, uint64_t> token_cache;     //hashes of the trigrams that were added
+
+private:
+    uint64_t hashToken(uint32_t trigram) const;
+
+public:
+    SearchFilter(unsigned char const cipher_mode, const Bytes datakey);
+    void addSegment(unsigned long begin, unsigned long end, const std::vector<unsigned long> offsets, const std::vector<std::string> texts);    //adds the next segment with the searchable texts of its records
+    Bytes encode(unsigned long covered_len, unsigned long next_seq, const Bytes log_id) const;    //encrypted filter file
+    void load(const BytesView file);                                    //decrypts the filter file (throws runtime_error if it was modified or is corrupted)
+    std::vector<unsigned long> getCandidates(const std::string query) const;   //segments that may contain the query (all segments for queries below three chars)
+    const SearchSegment& getSegment(unsigned long index) const;
+    unsigned long getSegmentNumber() const noexcept;
+    unsigned long getCoveredLen() const noexcept;
+    unsigned long getNextSeq() const noexcept;
+    Bytes getLogId() const noexcept;
+
+    static std::vector<std::string> getSearchText(const std::string name, const BytesView value);     //searchable texts of a record
+    static bool matches(const std::string name, const BytesView value, const std::string query);      //true if a searchable text contains the query (ignoring the case)
+    static std::filesystem::path getFilterPath(const std::filesystem::path vault_path);
+};
+
+#endif //SEARCHFILTER_H
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef SECUREBUFFER_H
+#define SECUREBUFFER_H
+
+#include "bytes.h"
+
+class SecureBuffer{
+    /*
+    holds secret bytes (keys, decrypted data) in memory that is locked (never swapped to disk),
+    excluded from core dumps and overwritten with zeros when the buffer is destroyed
+    each buffer gets its own pages, so unlocking one buffer never unlocks the pages of another buffer
+    */
+private:
+    unsigned char* data;    //begin of the locked pages (nullptr for an empty buffer)
+    unsigned long len;      //number of secret bytes
+    unsigned long cap;      //length of the locked pages
+    bool locked;            //true if mlock succeeded (it can fail if the lock limit is reached)
+
+private:
+    void release() noexcept;
+    void allocate(unsigned long min_len);   //gets locked pages for at least min_len bytes (the buffer has to be empty)
+
+public:
+    SecureBuffer() noexcept;
+    SecureBuffer(const BytesView bytes);            //copies the bytes into locked memory
+    SecureBuffer(const SecureBuffer&) = delete;
+    SecureBuffer& operator=(const SecureBuffer&) = delete;
+    SecureBuffer(SecureBuffer&& other) noexcept;
+    SecureBuffer& operator=(SecureBuffer&& other) noexcept;
+    ~SecureBuffer();                                //zeroizes and unlocks the memory
+
+    BytesView getView() const noexcept;             //view on the secret bytes (valid as long as the buffer lives)
+    unsigned long getLen() const noexcept;
+    bool isEmpty() const noexcept;
+    bool isLocked() const noexcept;
+    void append(const BytesView bytes);             //adds the bytes at the end (if the pages are full, the bytes move to pages of twice the length and the old pages are zeroized)
+    void clear() noexcept;                          //zeroizes the bytes and frees the memory
+};
+
+#endif //SECUREBUFFER_H
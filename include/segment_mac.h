@@ -0,0 +1,49 @@
+#pragma once
+#ifndef SEGMENTMAC_H
+#define SEGMENTMAC_H
+
+#include <filesystem>
+#include <vector>
+#include "bytes.h"
+#include "settings.h"
+
+struct ScrubReport{
+    /*
+    result of a scrub over the encoded data
+    */
+    unsigned long segments = 0;         //number of checked segments
+    unsigned long bytes = 0;            //number of checked bytes
+    double seconds = 0;                 //time the check needed
+    std::vector<unsigned long> damaged; //offsets (in the encoded data) of the segments whose mac does not match
+    unsigned long unchecked = 0;        //bytes behind the data that the macs cover (appended after the mac table was written)
+
+    bool isIntact() const noexcept{return this->damaged.empty();}
+    double getThroughput() const noexcept{return this->seconds > 0 ? this->bytes / this->seconds / 1000000 : 0;}   //MB/s
+};
+
+class SegmentMac{
+    /*
+    this class protects the encoded data of a file with a HMAC-SHA256 for each segment
+    the macs are stored in a trailer table behind the encoded data (see docs/segment_mac.md)
+    the macs are calculated over the encoded bytes, so the data can be checked without decrypting it
+    files that are only written once (shards) carry the trailer at their end, an append-only vault file keeps it
+    in a mac table next to it (<vault>.mac: covered length and trailer), which is written together with its name index
+    */
+public:
+    static const constexpr int MAC_LEN = 32;        //length of one mac
+    static const constexpr int TRAILER_FOOTER_LEN = 16;     //segment size (4), segment count (8), magic (4)
+
+    static Bytes calcMac(const Bytes key, unsigned long index, const unsigned char* segment, unsigned long len);    //calculates the mac of one segment
+    static Bytes createTrailer(const Bytes key, const Bytes data, unsigned long segment_size=SEGMENT_SIZE);         //calculates the macs of all segments and returns the trailer table
+    static Bytes createTrailer(const Bytes key, const BytesView data, unsigned long segment_size, unsigned int threads);    //calculates the macs in parallel (0 threads = all cores)
+    static unsigned long getTrailerLen(const Bytes data);                   //returns the length of the trailer at the end of the data (0 if there is no trailer)
+    static unsigned long getTrailerLen(const BytesView data);
+    static ScrubReport scrub(const Bytes key, const Bytes data, unsigned int threads=0);    //checks the encoded data with the trailer at its end in parallel (0 threads = all cores)
+    static ScrubReport scrub(const Bytes key, const BytesView data, const BytesView trailer, unsigned int threads=0);   //checks the data with a trailer that is stored somewhere else (throws if the trailer does not match with the data length)
+
+    static Bytes createTable(const Bytes key, const BytesView data, unsigned int threads=0);   //mac table of a file: covered length (8) and the trailer of the data
+    static ScrubReport scrubTable(const Bytes key, const BytesView file, const BytesView table, unsigned int threads=0);    //checks the covered part of the file with its mac table (a file shorter than the covered length is damaged at its end)
+    static std::filesystem::path getTablePath(const std::filesystem::path vault_path);    //<vault>.mac
+};
+
+#endif //SEGMENTMAC_H
@@ -9,6 +9,26 @@ const constexpr unsigned char MAX_HASHMODE_NUMBER = 3;
 const constexpr unsigned char STANDARD_HASHMODE = 3;
 const constexpr unsigned char MAX_CHAINHASHMODE_NUMBER = 4;
 const constexpr unsigned char STANDARD_CHAINHASHMODE = 4;
+const constexpr unsigned char MAX_CIPHERMODE_NUMBER = 3;
+const constexpr unsigned char STANDARD_CIPHERMODE = 2;
+const constexpr unsigned long CIPHER_CHUNK_SIZE = 1048576;    //plain bytes per authenticated chunk (1 MiB)
+const constexpr unsigned char MAX_COMPRESSIONMODE_NUMBER = 1;
+const constexpr unsigned char STANDARD_COMPRESSIONMODE = 1;
+const constexpr unsigned char MAX_KEYSLOTS = 8;
+const constexpr unsigned long SEGMENT_SIZE = 65536;           //encoded bytes per segment (integrity checks work on segments)
+const constexpr unsigned long MIN_COMPACTION_LEN = 65536;     //record logs below this length are never compacted
+const constexpr unsigned int COMPACTION_GARBAGE_PERCENT = 50;   //a record log is compacted if more than this percent is garbage (old versions and tombstones)
+const constexpr unsigned long MAX_UNINDEXED_LEN = 65536;      //the name index of a vault is written again when more of the log is not indexed
+const constexpr unsigned long SEARCH_SEGMENT_LEN = 65536;     //log bytes per segment of the search filters
+const constexpr unsigned long SEARCH_FILTER_MAX_BITS = 65536; //largest bloom filter of one segment
+const constexpr unsigned long SESSION_CACHE_LEN = 8388608;    //decrypted bytes that a vault session keeps in memory (8 MiB)
+const constexpr unsigned long BLOB_CHUNK_LEN = 1048576;       //plain bytes per encrypted chunk of an attachment
+const constexpr long BLOB_GRACE_SECONDS = 3600;               //unreferenced attachments are removed when they are older (a reference may be appended soon)
+const constexpr unsigned long STANDARD_SHARD_NUMBER = 16;     //shards of a new sharded vault directory
+const constexpr unsigned long MAX_SHARD_NUMBER = 4096;
+const constexpr unsigned long IMPORT_QUEUE_LEN = 1024;        //entries that wait between two stages of an import
+const constexpr unsigned long IMPORT_BATCH_LEN = 4096;        //records that an import writes at once (one append and sync of a vault file)
+const constexpr long LOCK_TIMEOUT_MS = 10000;                 //time a process waits for the lock of a file before it gives up
 const constexpr unsigned long STANDARD_PASS_VAL_ITERATIONS = 1000;    //we should test how many we need
 const constexpr unsigned long MIN_ITERATIONS = 1;
 const constexpr unsigned long MAX_ITERATIONS = 1000000000;
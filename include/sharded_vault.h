@@ -0,0 +1,100 @@
+#pragma once
+#ifndef SHARDEDVAULT_H
+#define SHARDEDVAULT_H
+
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include "dataHeader.h"
+#include "record_log.h"
+#include "atomic_writer.h"
+#include "entry_store.h"
+#include "file_lock.h"
+#include "segment_mac.h"
+
+struct ShardLoadReport{
+    /*
+    result of loading the shards of a sharded vault
+    */
+    unsigned long shards = 0;       //number of shards
+    unsigned long bytes = 0;        //number of decrypted log bytes
+    unsigned int threads = 0;       //threads that decrypted the shards
+    double seconds = 0;
+};
+
+struct Shard{
+    /*
+    one shard of a sharded vault in memory
+    */
+    RecordLog log;                  //records of the shard
+    unsigned long generation = 0;   //generation of the manifest that wrote the shard file
+    bool dirty = false;             //true if the records changed since the shard was written
+};
+
+class ShardedVault : public EntryStore{
+    /*
+    a vault directory with a manifest and N shard files (see docs/sharded_vault.md)
+    the manifest holds the data header (it is unlocked once) and the generation and length of every shard,
+    each shard is a record log (record_log.h) with a key derived from the data key, the shard index and its generation
+    a record belongs to the shard of its keyed name hash, so the records are spread evenly and the names are not revealed
+    the shards are decrypted in parallel, changes are kept in memory until save rewrites only the dirty shards and the manifest
+    (the destructor does not save, changes that were not saved are dropped)
+    a shard file is never changed: save writes the new generation into a new file and removes the old file after the manifest was replaced,
+    so a crash leaves the old vault and an old shard file cannot be put back (its key does not match)
+    each shard file ends with the mac trailer of its log (segment_mac.h), so pman scrub can check the shards without decrypting them
+    other processes can use the same directory (file_lock.h on the manifest), save fails if another process changed a dirty shard
+    */
+public:
+    static const constexpr int MANIFEST_PREFIX_LEN = 4 + 8 + 4;     //magic, generation, number of shards
+    static const constexpr int SHARD_ENTRY_LEN = 8 + 8;             //generation and log length of a shard
+    static const constexpr int MAC_LEN = 32;                        //HMAC-SHA256 behind the shard entries
+
+private:
+    std::filesystem::path dir;      //directory of the vault
+    Bytes header;                   //serialized data header at the begin of the manifest
+    unsigned char cipher_mode;      //authenticated cipher mode of the vault
+    unsigned char compression_mode; //compression of the record values (record_log.h)
+    Bytes shard_key;                //key that the keys of the shards are derived from
+    Bytes name_key;                 //key of the name hashes (shard of a record)
+    Bytes manifest_key;             //key of the mac of the manifest
+    Bytes mac_key;                  //key of the segment macs of the shard files
+    std::vector<Shard> shards;
+    unsigned long generation;       //generation of the manifest that was read or written last
+    mutable std::mutex mutex;       //guards the shards
+    ShardLoadReport last_load;
+    SaveReport last_save;
+    long lock_timeout;              //time to wait for the lock of the manifest (ms)
+
+private:
+    RecordLog newShardLog(unsigned long index, unsigned long generation) const;    //empty log with the key of the shard generation
+    std::vector<std::pair<unsigned long, unsigned long>> readManifest() const;     //reads and checks the manifest, returns (generation, log length) of each shard and sets nothing
+    void loadShards(const std::vector<std::pair<unsigned long, unsigned long>> entries, const std::vector<unsigned long> indices, unsigned int threads);  //decrypts the given shards in parallel
+    ShardedVault(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, const std::optional<std::string> only_name, unsigned int threads);    //loads only the shard of the name (all shards without a name)
+
+public:
+    ShardedVault(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, unsigned int threads=0);     //loads all shards of the vault directory (0 threads = all cores)
+    ShardedVault(const ShardedVault&) = delete;
+    ShardedVault& operator=(const ShardedVault&) = delete;
+
+    void put(const std::string name, const Bytes value);   //adds or changes a record in memory (the shard is dirty until save)
+    bool remove(const std::string name);                    //removes a record in memory, returns false if it does not exist
+    std::optional<Bytes> get(const std::string name) const;
+    std::vector<std::string> getNames() const;
+    unsigned long getRecordNumber() const;
+    unsigned long getShardNumber() const noexcept;
+    unsigned long getShardOf(const std::string name) const;     //index of the shard that holds the record
+    std::vector<unsigned long> getDirtyShards() const;
+    ShardLoadReport getLastLoad() const;
+    SaveReport getLastSave() const;
+    void setLockTimeout(long timeout_ms) noexcept;
+    SaveReport save(unsigned int threads=0);    //writes the dirty shards in parallel and replaces the manifest (throws runtime_error if another process changed a dirty shard)
+
+    static std::optional<Bytes> lookup(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, const std::string name);    //reads one record and decrypts only the shard of its name
+    static std::vector<std::pair<std::filesystem::path, ScrubReport>> scrub(const std::filesystem::path dir, const Bytes datakey, unsigned int threads=0);    //checks every shard file with its mac trailer without decrypting it (throws runtime_error for a shard without trailer)
+    static void create(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, unsigned long shard_number=STANDARD_SHARD_NUMBER);   //creates the directory with a manifest of empty shards (throws if a vault exists there)
+    static bool isShardedVault(const std::filesystem::path path) noexcept;     //returns true if the path is a directory with a manifest
+    static std::filesystem::path getManifestPath(const std::filesystem::path dir);
+    static std::filesystem::path getShardPath(const std::filesystem::path dir, unsigned long index, unsigned long generation);
+};
+
+#endif //SHARDEDVAULT_H
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef UNIXSOCKET_H
+#define UNIXSOCKET_H
+
+#include <filesystem>
+
+class UnixSocket{
+    /*
+    helper functions for the local unix sockets of pman-agent (agent.h) and pman serve (vault_server.h)
+    the sockets are only for the owner: they are created with 0600 and the peers are checked with SO_PEERCRED
+    */
+public:
+    static int listenOn(const std::filesystem::path path, int backlog);      //creates the socket file and listens on it (a stale socket is replaced, throws if another process listens)
+    static int connectTo(const std::filesystem::path path) noexcept;        //returns the connected socket or -1
+    static bool isSameUser(int fd) noexcept;                                //true if the peer runs with the same user id
+    static bool hasPrivateDir(const std::filesystem::path path) noexcept;   //true if the directory of the socket is no link, belongs to this user and has mode 0700 (no other user can place a socket there)
+    static void setTimeout(int fd, int ms) noexcept;                        //timeout for send and recv
+    static bool sendAll(int fd, const unsigned char* data, unsigned long len) noexcept;
+    static bool recvAll(int fd, unsigned char* data, unsigned long len) noexcept;
+};
+
+#endif //UNIXSOCKET_H
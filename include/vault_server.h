@@ -0,0 +1,89 @@
+#pragma once
+#ifndef VAULTSERVER_H
+#define VAULTSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "entry_store.h"
+#include "log_vault.h"
+
+struct LatencyReport{
+    unsigned long requests = 0;     //number of answered requests
+    double p50 = 0;                 //median time to answer a request (microseconds)
+    double p99 = 0;                 //99th percentile (microseconds)
+};
+
+class VaultServer : public EntryStore{
+    /*
+    pman serve: one process keeps an unlocked vault and answers many local clients on a unix socket (see docs/serve.md)
+    the clients send the batch commands (batch.h), one thread polls all connections and queues a connection for the pool of worker threads
+    only when it has received data, a worker answers the received commands and gives the connection back to the poll loop,
+    so idle connections do not hold a worker and a few threads serve many clients
+    reads use an immutable snapshot of all entries that is loaded with one atomic pointer load, so readers never wait for each other or for a writer
+    writes are serialized by the writer lock: the change is appended to the vault file, then a new snapshot is published with an atomic pointer swap (rcu),
+    the old snapshot is freed when its last reader is done
+    if the vault read its file again because another process changed it, the whole snapshot is built again from the vault,
+    the poll loop checks the file for such changes every REFRESH_MS
+    */
+public:
+    static const constexpr unsigned long MAX_LINE_LEN = 65536;      //longer commands are rejected and the client is dropped
+    static const constexpr unsigned long MAX_SAMPLES = 65536;       //latency samples that are kept per worker (the newest)
+    static const constexpr long REFRESH_MS = 1000;                  //interval in which the poll loop reads the changes of other processes
+
+private:
+    typedef std::map<std::string, Bytes> Snapshot;
+    struct Connection{
+        int fd;
+        std::string buffer;             //received bytes behind the last complete command
+        std::chrono::steady_clock::time_point last_request;
+    };
+    struct LatencySamples{
+        std::mutex mutex;               //only the worker and getLatencyReport take it
+        std::vector<double> samples;    //ring of the newest samples (microseconds)
+        unsigned long count = 0;        //all samples of the worker
+    };
+    LogVault& vault;                                //the vault file, only changed by the writer
+    std::shared_ptr<const Snapshot> snapshot;       //current entries, only accessed with std::atomic_load and std::atomic_store
+    std::mutex writer;                              //serializes the writes
+    unsigned long vault_reloads;                    //reload count of the vault that the snapshot has seen (guarded by the writer lock)
+    std::filesystem::path socket_path;
+    int listen_fd;
+    unsigned int threads;                           //number of worker threads
+    std::atomic<bool> running;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::unique_ptr<Connection>> ready;          //connections with received data that wait for a worker
+    std::vector<std::unique_ptr<Connection>> served;        //connections that a worker gave back to the poll loop
+    int wake_fds[2];                                        //pipe that wakes the poll loop when a connection is given back
+    std::vector<std::unique_ptr<LatencySamples>> latencies;    //one per worker
+
+private:
+    void work(LatencySamples& samples);                     //worker thread: serves the ready connections until the server stops
+    bool serveRequests(Connection& connection, LatencySamples& samples);   //reads the received data and answers the complete commands (false if the connection has to be closed)
+    void answer(const std::string line, std::ostream& out); //answers one command (batch commands and stats)
+    void publishAll();                                      //publishes a snapshot of all records of the vault (the writer lock has to be held)
+
+public:
+    VaultServer(const std::filesystem::path socket_path, LogVault& vault, unsigned int threads=0);  //creates the socket and the first snapshot (0 threads: one per core, at least 4)
+    VaultServer(const VaultServer&) = delete;
+    VaultServer& operator=(const VaultServer&) = delete;
+    ~VaultServer();                             //closes and removes the socket
+
+    void run();                                 //accepts clients until stop is called, then waits for the workers
+    void stop() noexcept;                       //stops the server (can be called from a signal handler or another thread)
+    LatencyReport getLatencyReport();
+
+    void put(const std::string name, const Bytes value);   //saves the change and publishes a new snapshot
+    bool remove(const std::string name);                    //saves the change and publishes a new snapshot
+    bool refresh();                                         //reads the changes of other processes and publishes them (returns true if a new snapshot was published)
+    std::optional<Bytes> get(const std::string name) const;        //reads from the current snapshot (no lock)
+    std::vector<std::string> getNames() const;                      //reads from the current snapshot (no lock)
+};
+
+#endif //VAULTSERVER_H
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef VAULTSESSION_H
+#define VAULTSESSION_H
+
+#include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include "dataHeader.h"
+#include "entry_store.h"
+#include "file_lock.h"
+#include "mapped_vault.h"
+#include "name_index.h"
+#include "record_log.h"
+#include "search_filter.h"
+#include "secure_buffer.h"
+#include "settings.h"
+
+struct CacheStats{
+    /*
+    counters of the segment cache of a vault session
+    */
+    unsigned long hits = 0;             //reads of a segment that was cached
+    unsigned long misses = 0;           //reads of a segment that had to be decrypted
+    unsigned long evictions = 0;        //segments that were dropped to stay below the cache length
+    unsigned long cached_segments = 0;
+    unsigned long cached_len = 0;       //decrypted bytes in the cache
+    unsigned long segments = 0;         //segments of the vault
+};
+
+class VaultSession : public EntryStore{
+    /*
+    an unlocked record log vault for long running processes that decrypts a segment (search_filter.h) only when a record in it is read
+    the name index tells the segment of a record, the decrypted segments are kept in locked and zeroized memory (secure_buffer.h)
+    in a cache of SESSION_CACHE_LEN bytes, the least recently used segment is dropped first
+    changes are appended to the file like in LogVault, the records behind the index (the tail) are held in one locked buffer
+    if the tail passes MAX_UNINDEXED_LEN or the garbage passes the threshold, the vault is compacted (or only the index is written)
+    with a LogVault under the exclusive lock, so the tail and the garbage stay bounded. A vault without a valid index is decrypted once to write it
+    */
+private:
+    struct TailRecord{
+        std::optional<std::pair<unsigned long, unsigned long>> value;   //position and length of the value in tail_values (nothing for a removed record)
+        unsigned long frame_len = 0;                                    //length of the latest frame (garbage when the record changes again)
+    };
+
+    struct CachedSegment{
+        SecureBuffer values;                                                //decrypted values of the latest frames of the segment
+        std::map<std::string, std::pair<unsigned long, unsigned long>> positions;  //position and length of each value in the buffer
+        std::list<unsigned long>::iterator lru_pos;                         //position in the lru list
+    };
+
+    std::filesystem::path path;     //path of the vault file
+    DataHeader header;              //data header of the vault
+    SecureBuffer datakey;           //data key (needed if the index has to be written)
+    RecordLog log;                  //encodes and decodes the frames (no records are loaded)
+    NameIndex index;                //name index of the vault
+    SearchFilter filter;            //segments of the vault
+    MappedVault vault;              //mapping of the file when it was last read
+    FileStamp stamp;                //stamp of the file when it was last read or written by this session
+    long lock_timeout;              //time to wait for the file lock (ms)
+    unsigned long log_len;          //length of the valid log (index and records behind it)
+    unsigned long next_seq;         //sequence number of the next frame
+    std::map<std::string, TailRecord> tail;     //records that changed behind the index
+    SecureBuffer tail_values;       //values of the tail frames one after another (old versions stay until the index is written again)
+    unsigned long garbage_len;      //length of the frames that the tail made garbage (old versions and tombstones)
+    unsigned long max_cache_len;    //decrypted bytes that are cached at most
+    mutable std::optional<std::set<std::string>> indexed_names;    //names of the indexed records (known after the first getNames)
+    mutable std::list<unsigned long> lru;                       //cached segments, most recently used first
+    mutable std::unordered_map<unsigned long, CachedSegment> cache;
+    mutable CacheStats stats;
+    mutable std::mutex mutex;       //guards the cache and the file
+
+private:
+    bool open();                    //maps the file and loads the index and the segments (false if there is no valid index, the file lock has to be held)
+    void readTail();                //reads the frames behind log_len from the mapping
+    void addTail(const std::string& name, unsigned char type, const BytesView value, unsigned long frame_len);    //adds a frame behind the index to the tail and counts the garbage it makes
+    bool needsMaintenance() const noexcept;     //true if the tail or the garbage passes its threshold
+    void maintain();                //compacts the vault or writes its index and opens it again (the mutex has to be held, not the file lock)
+    bool refreshLocked();           //reads the changes of other processes (the locks have to be held)
+    const CachedSegment& loadSegment(unsigned long segment) const;     //returns the cached segment or decrypts it (the lock has to be held)
+    std::optional<unsigned long> findSegment(const std::string name) const;    //segment of the latest indexed frame of the name
+
+public:
+    VaultSession(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, unsigned long max_cache_len=SESSION_CACHE_LEN);   //opens the vault (throws runtime_error if the key does not match)
+    VaultSession(const VaultSession&) = delete;
+    VaultSession& operator=(const VaultSession&) = delete;
+
+    void put(const std::string name, const Bytes value);   //adds or changes a record (one append, a compaction if the tail or the garbage is too long)
+    bool remove(const std::string name);                    //removes a record (one append, a compaction if the tail or the garbage is too long), returns false if it does not exist
+    std::optional<Bytes> get(const std::string name) const; //decrypts the segment of the record if it is not cached
+    std::vector<std::string> getNames() const;              //decrypts every segment once
+    bool refresh();                                         //reads the changes of other processes (returns true if the file changed)
+    void setLockTimeout(long timeout_ms) noexcept;
+    CacheStats getCacheStats() const;
+};
+
+#endif //VAULTSESSION_H
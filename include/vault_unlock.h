@@ -0,0 +1,49 @@
+#pragma once
+#ifndef VAULTUNLOCK_H
+#define VAULTUNLOCK_H
+
+#include <atomic>
+#include <future>
+#include <optional>
+#include <thread>
+#include "mapped_vault.h"
+#include "dataHeader.h"
+#include "record_log.h"
+
+struct UnlockedVault{
+    /*
+    result of a successful unlock
+    */
+    Bytes datakey;      //unwrapped data key of the vault
+    RecordLog log;      //decrypted records of the body
+};
+
+class VaultUnlock{
+    /*
+    unlocks a vault while hiding the disk latency behind the chainhashes:
+    the constructor parses the header and starts reading the whole file on an i/o thread (while the user types the password),
+    unlockAsync computes the chainhashes while the i/o thread keeps reading the body
+    and decrypts the body as soon as the data key is unwrapped
+    the VaultUnlock has to live until the future of unlockAsync is ready
+    */
+private:
+    MappedVault vault;                      //mapped vault file
+    DataHeader header;                      //parsed header of the vault
+    std::thread prefetcher;                 //touches every page of the file, so it is read before it is decrypted
+    std::atomic<unsigned long> prefetched;  //number of bytes that are read by the prefetcher
+
+public:
+    static DataHeader parseHeader(const MappedVault& vault);    //parses the header at the begin of the vault (throws if the vault is empty)
+
+    VaultUnlock(MappedVault vault);         //parses the header and starts the prefetch (throws if the vault is empty or the header is invalid)
+    VaultUnlock(const VaultUnlock&) = delete;
+    VaultUnlock& operator=(const VaultUnlock&) = delete;
+    ~VaultUnlock();                         //waits for the prefetch
+
+    const DataHeader& getHeader() const noexcept;
+    unsigned long getPrefetchedLen() const noexcept;
+    std::future<std::optional<UnlockedVault>> unlockAsync(const std::string password) const;    //unlocks the data key and decrypts the body (nothing if the password is wrong)
+    std::future<std::optional<UnlockedVault>> unlockWithKeyAsync(const Bytes datakey) const;    //decrypts the body with a known data key (from the agent), nothing if the key does not match the key check value of the header
+};
+
+#endif //VAULTUNLOCK_H
@@ -0,0 +1,280 @@
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+#include "agent.h"
+#include "unix_socket.h"
+#include "sha256.h"
+
+static const int CLIENT_TIMEOUT_MS = 1000;      //a client that does not send or read its message in this time is dropped
+
+static std::vector<unsigned char> createMessage(unsigned char type, const BytesView payload){
+    //the message is allocated once, so no copy of a key is left in freed memory
+    std::vector<unsigned char> msg;
+    msg.reserve(5 + payload.getLen());
+    msg.push_back(type);
+    for(int i=3; i >= 0; i--){
+        msg.push_back((payload.getLen() >> (8 * i)) & 0xFF);
+    }
+    msg.insert(msg.end(), payload.data(), payload.data() + payload.getLen());
+    return msg;
+}
+
+static bool sendMessage(int fd, std::vector<unsigned char> msg){
+    bool ok = UnixSocket::sendAll(fd, msg.data(), msg.size());
+    OPENSSL_cleanse(msg.data(), msg.size());    //the message can contain a key
+    return ok;
+}
+
+static std::optional<std::vector<unsigned char>> recvMessage(int fd){
+    //returns type and payload in one vector
+    unsigned char head[5];
+    if(!UnixSocket::recvAll(fd, head, sizeof(head))){
+        return {};
+    }
+    unsigned long len = toLong(BytesView(head + 1, 4));
+    if(len > Agent::MAX_MESSAGE_LEN){
+        return {};
+    }
+    std::vector<unsigned char> msg(1 + len);
+    msg[0] = head[0];
+    if(!UnixSocket::recvAll(fd, msg.data() + 1, len)){
+        return {};
+    }
+    return msg;
+}
+
+Agent::Agent(const std::filesystem::path socket_path, unsigned long default_ttl){
+    this->socket_path = socket_path;
+    this->default_ttl = default_ttl;
+    this->running = false;
+    this->listen_fd = UnixSocket::listenOn(socket_path, 16);
+    if(!UnixSocket::hasPrivateDir(socket_path)){
+        //checked after listening, the directory could be created by someone else in between
+        close(this->listen_fd);
+        unlink(socket_path.c_str());
+        throw std::runtime_error("the directory of the socket has to be a 0700 directory of this user: " + socket_path.parent_path().string());
+    }
+}
+
+Agent::~Agent(){
+    close(this->listen_fd);
+    unlink(this->socket_path.c_str());
+    this->keys.clear();     //the secure buffers zeroize the keys
+}
+
+void Agent::purgeExpired() noexcept{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for(std::map<std::string, CachedKey>::iterator it = this->keys.begin(); it != this->keys.end();){
+        if(it->second.expiry <= now){
+            it = this->keys.erase(it);
+        }else{
+            it++;
+        }
+    }
+}
+
+std::vector<unsigned char> Agent::handle(const BytesView request){
+    unsigned char cmd = request[0];
+    BytesView payload = request.slice(1, request.getLen() - 1);
+    if(cmd == CMD_ADD){
+        if(payload.getLen() < 2 || payload.getLen() < 10 + toLong(payload.slice(0, 2))){
+            return createMessage(STATUS_ERROR, BytesView());
+        }
+        unsigned long id_len = toLong(payload.slice(0, 2));
+        unsigned long key_len = payload.getLen() - 10 - id_len;
+        if(key_len != 32 && key_len != 48 && key_len != 64){
+            return createMessage(STATUS_ERROR, BytesView());     //data keys have the size of a hash (sha256, sha384 or sha512)
+        }
+        std::string id(payload.data() + 2, payload.data() + 2 + id_len);
+        unsigned long ttl = toLong(payload.slice(2 + id_len, 8));
+        CachedKey& cached = this->keys[id];
+        cached.key = SecureBuffer(payload.slice(10 + id_len, key_len));
+        cached.expiry = std::chrono::steady_clock::now() + std::chrono::seconds(ttl == 0 ? this->default_ttl : ttl);
+        return createMessage(STATUS_OK, BytesView());
+    }else if(cmd == CMD_GET){
+        std::map<std::string, CachedKey>::iterator it = this->keys.find(std::string(payload.data(), payload.data() + payload.getLen()));
+        if(it == this->keys.end()){
+            return createMessage(STATUS_NOT_FOUND, BytesView());
+        }
+        return createMessage(STATUS_OK, it->second.key.getView());     //the key is copied once, from the locked memory into the message
+    }else if(cmd == CMD_REMOVE){
+        bool removed = this->keys.erase(std::string(payload.data(), payload.data() + payload.getLen())) > 0;
+        return createMessage(removed ? STATUS_OK : STATUS_NOT_FOUND, BytesView());
+    }else if(cmd == CMD_CLEAR){
+        this->keys.clear();
+        return createMessage(STATUS_OK, BytesView());
+    }
+    return createMessage(STATUS_ERROR, BytesView());
+}
+
+bool Agent::serveClient(Client& client){
+    //reads only what is there, so a slow client does not block the others
+    ssize_t len = recv(client.fd, client.message.data() + client.received, client.message.size() - client.received, MSG_DONTWAIT);
+    if(len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)){
+        return false;
+    }
+    if(len <= 0){
+        return true;    //closed or failed
+    }
+    client.received += len;
+    if(client.received == 5 && client.message.size() == 5){
+        unsigned long payload_len = toLong(BytesView(client.message.data() + 1, 4));
+        if(payload_len > MAX_MESSAGE_LEN){
+            return true;
+        }
+        client.message.resize(5 + payload_len);    //only the header is in the old memory
+    }
+    if(client.received < client.message.size()){
+        return false;
+    }
+    //the handler gets type and payload in one view, the type is moved next to the payload
+    client.message[4] = client.message[0];
+    this->purgeExpired();
+    std::vector<unsigned char> response = this->handle(BytesView(client.message.data() + 4, client.message.size() - 4));
+    sendMessage(client.fd, std::move(response));      //cleanses the response
+    return true;
+}
+
+void Agent::run(){
+    this->running = true;
+    std::vector<Client> clients;
+    std::vector<pollfd> pfds;
+    while(this->running){
+        //wake up for new clients, for requests, for stop, for the next expiring key and for the next client timeout
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        long timeout = 500;
+        for(const std::pair<const std::string, CachedKey>& key : this->keys){
+            timeout = std::min<long>(timeout, std::chrono::duration_cast<std::chrono::milliseconds>(key.second.expiry - now).count() + 1);
+        }
+        for(const Client& client : clients){
+            timeout = std::min<long>(timeout, std::chrono::duration_cast<std::chrono::milliseconds>(client.start + std::chrono::milliseconds(CLIENT_TIMEOUT_MS) - now).count() + 1);
+        }
+        pfds.clear();
+        pfds.push_back({this->listen_fd, POLLIN, 0});
+        for(const Client& client : clients){
+            pfds.push_back({client.fd, POLLIN, 0});
+        }
+        int ready = poll(pfds.data(), pfds.size(), std::max(0L, timeout));
+        this->purgeExpired();
+        if(ready < 0){
+            continue;   //interrupted by a signal
+        }
+        now = std::chrono::steady_clock::now();
+        std::vector<Client> open;
+        for(unsigned long i=0; i < clients.size(); i++){
+            Client& client = clients[i];
+            bool done = pfds[i + 1].revents != 0 ? this->serveClient(client) : false;
+            if(!done && now - client.start < std::chrono::milliseconds(CLIENT_TIMEOUT_MS)){
+                open.push_back(std::move(client));
+                continue;
+            }
+            OPENSSL_cleanse(client.message.data(), client.message.size());     //the request can contain a key
+            close(client.fd);
+        }
+        clients.swap(open);
+        if(pfds[0].revents == 0){
+            continue;
+        }
+        int fd = accept(this->listen_fd, nullptr, nullptr);
+        if(fd < 0){
+            continue;
+        }
+        UnixSocket::setTimeout(fd, CLIENT_TIMEOUT_MS);     //the response is small, the timeout only matters for a full socket buffer
+        if(!UnixSocket::isSameUser(fd)){
+            close(fd);      //only the owner gets keys
+            continue;
+        }
+        clients.push_back(Client{fd, std::vector<unsigned char>(5), 0, std::chrono::steady_clock::now()});
+    }
+    for(Client& client : clients){
+        OPENSSL_cleanse(client.message.data(), client.message.size());
+        close(client.fd);
+    }
+}
+
+void Agent::stop() noexcept{
+    this->running = false;
+}
+
+unsigned long Agent::getKeyNumber() const noexcept{
+    return this->keys.size();
+}
+
+std::filesystem::path Agent::getDefaultSocketPath(){
+    const char* sock = std::getenv("PMAN_AGENT_SOCK");
+    if(sock != nullptr && sock[0] != '\0'){
+        return sock;
+    }
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if(runtime != nullptr && runtime[0] != '\0'){
+        return std::filesystem::path(runtime) / "pman-agent.sock";
+    }
+    return std::filesystem::temp_directory_path() / ("pman-" + std::to_string(getuid())) / "agent.sock";
+}
+
+std::string Agent::getVaultId(const Bytes header){
+    return toHex(sha256().hash(header));
+}
+
+AgentClient::AgentClient(const std::filesystem::path socket_path){
+    this->socket_path = socket_path;
+}
+
+std::optional<Bytes> AgentClient::request(unsigned char cmd, const Bytes payload) const{
+    if(!UnixSocket::hasPrivateDir(this->socket_path)){
+        return {};  //another user could have placed the socket
+    }
+    int fd = UnixSocket::connectTo(this->socket_path);
+    if(fd < 0){
+        return {};  //no agent
+    }
+    if(!UnixSocket::isSameUser(fd)){
+        close(fd);
+        return {};  //the keys are only sent to an agent of this user
+    }
+    UnixSocket::setTimeout(fd, CLIENT_TIMEOUT_MS);
+    std::optional<std::vector<unsigned char>> response;
+    if(sendMessage(fd, createMessage(cmd, payload.getView()))){
+        response = recvMessage(fd);
+    }
+    close(fd);
+    if(!response.has_value() || response->at(0) != Agent::STATUS_OK){
+        return {};  //no agent or the agent has no key
+    }
+    Bytes ret;
+    ret.setBytes(std::vector<unsigned char>(response->begin() + 1, response->end()));
+    OPENSSL_cleanse(response->data(), response->size());
+    return ret;
+}
+
+std::optional<Bytes> AgentClient::getKey(const std::string vault_id) const{
+    Bytes payload;
+    payload.setBytes(std::vector<unsigned char>(vault_id.begin(), vault_id.end()));
+    return this->request(Agent::CMD_GET, payload);
+}
+
+bool AgentClient::addKey(const std::string vault_id, const Bytes key, unsigned long ttl) const{
+    if(vault_id.size() > 0xFFFF){
+        throw std::length_error("vault id is too long");
+    }
+    Bytes payload = fromLong(vault_id.size(), 2);
+    for(char c : vault_id){
+        payload.addByte(c);
+    }
+    payload.addBytes(fromLong(ttl));
+    payload.addBytes(key);
+    return this->request(Agent::CMD_ADD, payload).has_value();
+}
+
+bool AgentClient::removeKey(const std::string vault_id) const{
+    Bytes payload;
+    payload.setBytes(std::vector<unsigned char>(vault_id.begin(), vault_id.end()));
+    return this->request(Agent::CMD_REMOVE, payload).has_value();
+}
+
+bool AgentClient::clear() const{
+    return this->request(Agent::CMD_CLEAR, Bytes()).has_value();
+}
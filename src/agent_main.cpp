@@ -0,0 +1,100 @@
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+#include "agent.h"
+
+static Agent* running_agent = nullptr;
+
+static void stopAgent(int){
+    if(running_agent != nullptr){
+        running_agent->stop();
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::filesystem::path socket_path = Agent::getDefaultSocketPath();
+    unsigned long ttl = Agent::STANDARD_TTL;
+    bool foreground = false;
+    for(int i=1; i < argc; i++){
+        if(std::strcmp(argv[i], "--socket") == 0 && i+1 < argc){
+            socket_path = argv[++i];
+        }else if(std::strcmp(argv[i], "--ttl") == 0 && i+1 < argc){
+            try{
+                ttl = std::stoul(argv[++i]);
+            }catch(std::exception&){
+                std::cerr << "invalid ttl: " << argv[i] << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--foreground") == 0){
+            foreground = true;
+        }else{
+            std::cerr << "usage: " << argv[0] << " [--socket path] [--ttl seconds] [--foreground]" << std::endl;
+            return 1;
+        }
+    }
+    //like ssh-agent the agent detaches, so eval $(pman-agent) returns: the parent prints the variables when the child listens and exits
+    int ready[2] = {-1, -1};
+    if(!foreground){
+        if(pipe(ready) != 0){
+            std::cerr << "pman-agent: cannot create a pipe" << std::endl;
+            return 1;
+        }
+        pid_t pid = fork();
+        if(pid < 0){
+            std::cerr << "pman-agent: cannot fork" << std::endl;
+            return 1;
+        }
+        if(pid > 0){
+            close(ready[1]);
+            char status = 1;
+            if(read(ready[0], &status, 1) != 1 || status != 0){
+                return 1;   //the child printed the error
+            }
+            std::cout << "PMAN_AGENT_SOCK=" << socket_path.string() << "; export PMAN_AGENT_SOCK;" << std::endl;
+            std::cout << "PMAN_AGENT_PID=" << pid << "; export PMAN_AGENT_PID;" << std::endl;
+            return 0;
+        }
+        close(ready[0]);
+        setsid();   //no controlling terminal, a closed shell does not stop the agent
+    }
+#if defined(__linux__)
+    prctl(PR_SET_DUMPABLE, 0);      //other processes of the user cannot read the keys with ptrace or core dumps
+#endif
+    try{
+        Agent agent(socket_path, ttl);
+        running_agent = &agent;
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = stopAgent;  //no SA_RESTART, so poll returns at once
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        signal(SIGPIPE, SIG_IGN);
+        if(foreground){
+            std::cout << "PMAN_AGENT_SOCK=" << socket_path.string() << "; export PMAN_AGENT_SOCK;" << std::endl;
+        }else{
+            char status = 0;
+            if(write(ready[1], &status, 1) != 1){
+                return 1;   //the parent is gone, nobody knows the socket
+            }
+            close(ready[1]);
+            int null_fd = open("/dev/null", O_RDWR);
+            if(null_fd >= 0){
+                dup2(null_fd, STDIN_FILENO);    //the output of the eval is closed, so the caller does not wait for the agent
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+                close(null_fd);
+            }
+        }
+        agent.run();
+        running_agent = nullptr;
+    }catch(std::exception& e){
+        std::cerr << "pman-agent: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,7 +1,18 @@
+#include <fstream>
 #include "app.h"
 #include "utility.h"
 #include "pwfunc.h"
 #include "dataHeader.h"
+#include "vault_unlock.h"
+#include "batch.h"
+#include "vault_session.h"
+#include "blob_store.h"
+#if !defined(_WIN32)
+#include <csignal>
+#include <cstring>
+#include "agent.h"
+#include "vault_server.h"
+#endif
 #include "settings.h"
 
 bool App::isValidHashMode(std::string mode, bool accept_blank) const noexcept{
@@ -46,15 +57,15 @@ bool App::isValidNumber(std::string number, bool accept_blank) const noexcept{
 }
 
 App::App(){
-    this->filePath = this->FH.getEncryptionFilePath();
+    //nothing is read here, the file location is read when the app starts (see printStart)
 }
 
 bool App::run(){
     this->printStart();     //get the file location from the user (if not in the app data)
+    this->FH.flushAppSettings();    //the changed file location is written once
     std::cout << std::endl;
-    try{
-        this->FH.getFirstBytes(1);      //try to get the first byte of the file
-    }catch(std::length_error){
+    MappedVault vault = this->FH.mapEncryptionFile();   //the file is mapped once, the header is parsed from the mapping
+    if(vault.isEmpty()){
         //file is empty
         //construct a basic file header with a password from the user
         std::cout << "It seems that the encrypted file is empty. Let`s set up this file" << std::endl;
@@ -67,17 +78,472 @@ bool App::run(){
         return false; //DEBUGONLY
 
     }
-    return false; //DEBUGONLY
-    unsigned char mode = this->FH.getFirstBytes(1).getBytes()[0];      //get the mode for the encrypted file
-    DataHeader DH(mode);
-    Bytes header = this->FH.getFirstBytes(DH.getHeaderLength());  
-    DH.setHeaderBytes(header);
-    std::string pw = this->askForPasswd();
+    VaultUnlock unlock(std::move(vault));   //parses the header and reads the file while the user types the password
+    std::optional<UnlockedVault> unlocked = this->unlockVault(unlock, [this]() -> std::optional<std::string>{
+        return this->askForPasswd();
+    });
+    if(!unlocked.has_value()){
+        std::cout << "Wrong password" << std::endl;
+        return false;
+    }
+    std::cout << "File unlocked (" << unlocked->log.getRecordNumber() << " entries)" << std::endl;
     return true;
 }
 
+std::unique_ptr<LogVault> App::openVault(std::string vault_path, int password_fd) const{
+    if(!std::filesystem::exists(vault_path)){
+        std::cerr << "vault not found: " << vault_path << std::endl;
+        return nullptr;
+    }
+    if(std::filesystem::is_directory(vault_path)){
+        std::cerr << "not supported for sharded vaults: " << vault_path << std::endl;
+        return nullptr;
+    }
+    MappedVault vault(vault_path);
+    if(vault.isEmpty()){
+        std::cerr << "vault is empty: " << vault_path << std::endl;
+        return nullptr;
+    }
+    VaultUnlock unlock(std::move(vault));
+    std::optional<UnlockedVault> unlocked = this->unlockVault(unlock, [password_fd]() -> std::optional<std::string>{
+        if(password_fd < 0){
+            return {};  //only the agent can unlock the vault
+        }
+        return Batch::readPassword(password_fd);
+    });
+    if(!unlocked.has_value()){
+        std::cerr << "vault cannot be unlocked (wrong password or no password given)" << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<LogVault>(vault_path, unlock.getHeader(), unlocked.value());     //the vault is decrypted once for all commands
+}
+
+int App::runBatch(std::string vault_path, int password_fd){
+    if(ShardedVault::isShardedVault(vault_path)){
+        return this->runShardedBatch(vault_path, password_fd);
+    }
+    if(!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    std::unique_ptr<VaultSession> session;
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(vault_path));
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            session = std::make_unique<VaultSession>(vault_path, header, datakey);     //only the segments of the used records are decrypted
+        })){
+            return 1;
+        }
+    }catch(std::exception& e){
+        std::cerr << "vault cannot be opened: " << e.what() << std::endl;
+        return 1;
+    }
+    return Batch::run(*session, std::cin, std::cout) == 0 ? 0 : 2;
+}
+
+int App::runShardedBatch(std::string vault_dir, int password_fd){
+    std::unique_ptr<ShardedVault> vault;
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(ShardedVault::getManifestPath(vault_dir)));
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            vault = std::make_unique<ShardedVault>(vault_dir, header, datakey);    //all shards are decrypted in parallel
+        })){
+            return 1;
+        }
+    }catch(std::exception& e){
+        std::cerr << "vault cannot be opened: " << e.what() << std::endl;
+        return 1;
+    }
+    unsigned long failed = Batch::run(*vault, std::cin, std::cout);
+    try{
+        vault->save();      //only the changed shards are written
+    }catch(std::exception& e){
+        std::cerr << "vault cannot be saved: " << e.what() << std::endl;
+        return 1;
+    }
+    return failed == 0 ? 0 : 2;
+}
+
+int App::runImport(std::string vault_path, int password_fd, std::string file_path, std::string format_name){
+    std::optional<unsigned char> format = Importer::getFormat(format_name.empty() ? file_path : format_name);
+    if(!format.has_value()){
+        std::cerr << "unknown import format (use --format csv or --format json)" << std::endl;
+        return 1;
+    }
+    bool sharded = ShardedVault::isShardedVault(vault_path);
+    if(!sharded && (!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0)){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    std::ifstream file;
+    if(file_path != "-"){
+        file.open(file_path, std::ios::binary);
+        if(!file){
+            std::cerr << "file not found: " << file_path << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = file_path == "-" ? std::cin : file;
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(sharded ? ShardedVault::getManifestPath(vault_path) : std::filesystem::path(vault_path)));
+        std::unique_ptr<EntryStore> store;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            if(sharded){
+                store = std::make_unique<ShardedVault>(vault_path, header, datakey);
+            }else{
+                store = std::make_unique<LogVault>(vault_path, header, datakey);
+            }
+        })){
+            return 1;
+        }
+        ImportReport report = Importer::run(in, format.value(), *store);
+        if(sharded){
+            static_cast<ShardedVault&>(*store).save();
+        }
+        std::cerr << report.entries << " entries imported (" << report.renamed << " renamed, " << report.skipped << " skipped) in " << report.seconds << " s" << std::endl;
+    }catch(std::exception& e){
+        std::cerr << "pman import: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int App::runShard(std::string vault_path, int password_fd, std::string vault_dir, unsigned long shards){
+    if(!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(vault_path));
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            LogVault vault(vault_path, header, datakey);
+            ShardedVault::create(vault_dir, header, datakey, shards);
+            ShardedVault sharded(vault_dir, header, datakey);
+            for(const std::string& name : vault.getNames()){
+                sharded.put(name, vault.get(name).value());
+            }
+            SaveReport report = sharded.save();
+            std::cout << sharded.getRecordNumber() << " records in " << sharded.getShardNumber() << " shards (" << report.bytes << " bytes)" << std::endl;
+        })){
+            return 1;
+        }
+    }catch(std::exception& e){
+        std::cerr << "vault cannot be sharded: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+bool App::withDataKey(const DataHeader& header, int password_fd, const std::function<void(const Bytes)> use) const{
+#if !defined(_WIN32)
+    AgentClient agent;
+    std::string vault_id = Agent::getVaultId(header.getHeaderBytes());
+    std::optional<Bytes> datakey = agent.getKey(vault_id);
+    if(datakey.has_value() && !header.isDataKeyValid(datakey.value())){
+        datakey.reset();    //the key of the agent does not match, the password is used
+    }
+#else
+    std::optional<Bytes> datakey;
+#endif
+    if(!datakey.has_value()){
+        if(password_fd < 0){
+            std::cerr << "vault cannot be unlocked (no password given)" << std::endl;
+            return false;
+        }
+        datakey = header.getDataKey(Batch::readPassword(password_fd));
+        if(!datakey.has_value()){
+            std::cerr << "vault cannot be unlocked (wrong password)" << std::endl;
+            return false;
+        }
+#if !defined(_WIN32)
+        agent.addKey(vault_id, datakey.value());
+#endif
+    }
+    use(datakey.value());   //called once with a checked key, its errors are not mistaken for a wrong key
+    return true;
+}
+
+int App::runGet(std::string vault_path, int password_fd, std::string name){
+    bool sharded = ShardedVault::isShardedVault(vault_path);
+    if(!sharded && (!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0)){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(sharded ? ShardedVault::getManifestPath(vault_path) : std::filesystem::path(vault_path)));
+        NameLookup found;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            if(sharded){
+                found.value = ShardedVault::lookup(vault_path, header, datakey, name);     //only the shard of the name is decrypted
+            }else{
+                found = LogVault::lookup(vault_path, header, datakey, name);
+                if(!found.value.has_value()){
+                    //the name can also be the title or url of an entry, the entry index needs all records
+                    LogVault vault(vault_path, header, datakey);
+                    std::optional<std::string> entry = vault.findEntry(name);
+                    if(entry.has_value()){
+                        found.value = vault.get(entry.value());
+                    }
+                }
+            }
+        })){
+            return 1;
+        }
+        if(!found.value.has_value()){
+            std::cerr << "not found: " << name << std::endl;
+            return 2;
+        }
+        BytesView value = found.value->getView();
+        if(EntryView::isRecord(value)){
+            value = EntryView(value).getField(EntryView::FIELD_SECRET);    //entries (e.g. imported ones) print their secret
+        }
+        std::cout << std::string(value.data(), value.data() + value.getLen()) << std::endl;
+    }catch(std::exception& e){
+        std::cerr << "pman get: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int App::runSearch(std::string vault_path, int password_fd, std::string query){
+    bool sharded = ShardedVault::isShardedVault(vault_path);
+    if(!sharded && (!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0)){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(sharded ? ShardedVault::getManifestPath(vault_path) : std::filesystem::path(vault_path)));
+        SearchResult result;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            if(sharded){
+                //the shards have no search filters, all records are decrypted (in parallel per shard)
+                ShardedVault vault(vault_path, header, datakey);
+                for(const std::string& name : vault.getNames()){
+                    if(SearchFilter::matches(name, vault.get(name).value().getView(), query)){
+                        result.names.push_back(name);
+                    }
+                }
+            }else{
+                result = LogVault::search(vault_path, header, datakey, query);
+            }
+        })){
+            return 1;
+        }
+        for(const std::string& name : result.names){
+            std::cout << name << std::endl;
+        }
+        if(result.used_filters){
+            std::cerr << result.scanned_segments << " of " << result.segments << " segments scanned, " << result.decrypted_len << " bytes decrypted" << std::endl;
+        }
+        if(result.names.empty()){
+            return 2;
+        }
+    }catch(std::exception& e){
+        std::cerr << "pman search: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int App::runAttach(std::string vault_path, int password_fd, std::string name, std::string file_path){
+    if(std::filesystem::is_directory(vault_path)){
+        std::cerr << "pman attach: not supported for sharded vaults" << std::endl;
+        return 1;
+    }
+    if(!std::filesystem::exists(vault_path) || std::filesystem::file_size(vault_path) == 0){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    std::ifstream file(file_path, std::ios::binary);
+    if(!file){
+        std::cerr << "file not found: " << file_path << std::endl;
+        return 1;
+    }
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(vault_path));
+        BlobRef ref;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            VaultSession session(vault_path, header, datakey);     //checks the key before the blob is written
+            ref = BlobStore(vault_path, header.getCipherMode(), datakey).write(file);
+            session.put(name, BlobStore::encodeRef(ref));
+        })){
+            return 1;
+        }
+        std::cerr << ref.len << " bytes attached as " << name << std::endl;
+    }catch(std::exception& e){
+        std::cerr << "pman attach: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int App::runExport(std::string vault_path, int password_fd, std::string name, std::string file_path){
+    if(std::filesystem::is_directory(vault_path)){
+        std::cerr << "pman export: not supported for sharded vaults" << std::endl;
+        return 1;
+    }
+    if(!std::filesystem::exists(vault_path) || std::filesystem::file_size(vault_path) == 0){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(vault_path));
+        NameLookup found;
+        Bytes key;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            found = LogVault::lookup(vault_path, header, datakey, name);
+            key = datakey;
+        })){
+            return 1;
+        }
+        std::optional<BlobRef> ref = found.value.has_value() ? BlobStore::decodeRef(found.value->getView()) : std::nullopt;
+        if(!ref.has_value()){
+            std::cerr << "no attachment: " << name << std::endl;
+            return 2;
+        }
+        BlobStore blobs(vault_path, header.getCipherMode(), key);
+        if(file_path == "-"){
+            blobs.read(ref.value(), std::cout);
+            std::cout.flush();
+        }else{
+            std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+            blobs.read(ref.value(), file);
+        }
+    }catch(std::exception& e){
+        std::cerr << "pman export: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static void printScrubReport(const std::string file, const ScrubReport& report){
+    std::cout << file << ": " << report.segments << " segments, " << report.bytes << " bytes checked in " << report.seconds << " s (" << report.getThroughput() << " MB/s)" << std::endl;
+    for(unsigned long offset : report.damaged){
+        std::cout << "damaged segment at offset " << offset << std::endl;
+    }
+    if(report.unchecked > 0){
+        std::cout << report.unchecked << " bytes behind the mac table are not checked (written after the last index)" << std::endl;
+    }
+}
+
+int App::runScrub(std::string vault_path, int password_fd){
+    bool sharded = ShardedVault::isShardedVault(vault_path);
+    if(!sharded && (!std::filesystem::exists(vault_path) || std::filesystem::is_directory(vault_path) || std::filesystem::file_size(vault_path) == 0)){
+        std::cerr << "vault not found or empty: " << vault_path << std::endl;
+        return 1;
+    }
+    bool intact = true;
+    try{
+        DataHeader header = VaultUnlock::parseHeader(MappedVault(sharded ? ShardedVault::getManifestPath(vault_path) : std::filesystem::path(vault_path)));
+        Bytes key;
+        if(!this->withDataKey(header, password_fd, [&](const Bytes datakey){
+            key = datakey;      //the mac key is derived from the data key, nothing is decrypted
+        })){
+            return 1;
+        }
+        if(sharded){
+            for(const std::pair<std::filesystem::path, ScrubReport>& shard : ShardedVault::scrub(vault_path, key)){
+                printScrubReport(shard.first.filename().string(), shard.second);
+                intact = intact && shard.second.isIntact();
+            }
+        }else{
+            ScrubReport report = LogVault::scrub(vault_path, key);
+            printScrubReport(vault_path, report);
+            intact = report.isIntact();
+        }
+    }catch(std::exception& e){
+        std::cerr << "pman scrub: " << e.what() << std::endl;
+        return 1;
+    }
+    return intact ? 0 : 2;
+}
+
+#if !defined(_WIN32)
+static VaultServer* running_server = nullptr;
+
+static void stopServer(int){
+    if(running_server != nullptr){
+        running_server->stop();
+    }
+}
+#endif
+
+int App::runServe(std::string vault_path, int password_fd, std::string socket_path, unsigned int threads){
+#if defined(_WIN32)
+    std::cerr << "pman serve needs unix sockets" << std::endl;
+    return 1;
+#else
+    std::unique_ptr<LogVault> vault = this->openVault(vault_path, password_fd);
+    if(!vault){
+        return 1;
+    }
+    if(socket_path.empty()){
+        socket_path = vault_path + ".sock";
+    }
+    try{
+        VaultServer server(socket_path, *vault, threads);
+        running_server = &server;
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = stopServer;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        signal(SIGPIPE, SIG_IGN);
+        std::cerr << "serving " << vault_path << " on " << socket_path << std::endl;
+        server.run();
+        running_server = nullptr;
+        LatencyReport report = server.getLatencyReport();
+        std::cerr << report.requests << " requests, p50 " << report.p50 << " us, p99 " << report.p99 << " us" << std::endl;
+    }catch(std::exception& e){
+        running_server = nullptr;
+        std::cerr << "pman serve: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+std::optional<UnlockedVault> App::unlockVault(const VaultUnlock& unlock, const std::function<std::optional<std::string>()> getPassword) const{
+    std::optional<UnlockedVault> unlocked;
+#if !defined(_WIN32)
+    AgentClient agent;
+    std::string vault_id = Agent::getVaultId(unlock.getHeader().getHeaderBytes());
+    std::optional<Bytes> cached_key = agent.getKey(vault_id);
+    if(cached_key.has_value()){
+        unlocked = unlock.unlockWithKeyAsync(cached_key.value()).get();     //the agent has the key, no chainhashes needed
+        if(unlocked.has_value()){
+            return unlocked;
+        }
+    }
+#endif
+    std::optional<std::string> password = getPassword();
+    if(!password.has_value()){
+        return {};
+    }
+    unlocked = unlock.unlockAsync(password.value()).get();
+#if !defined(_WIN32)
+    if(unlocked.has_value()){
+        agent.addKey(vault_id, unlocked->datakey);     //later calls skip the chainhashes (if an agent runs)
+    }
+#endif
+    return unlocked;
+}
+
 void App::printStart(){
     std::cout << "Welcome to the local encryption system" << std::endl;
+    if(!this->FH.isAppDataValid()){
+        std::cout << "The AppDataFile is not in the right format" << std::endl;
+        std::cout << "Do you wanna reset the appData (y/n): ";
+        std::string tmp;
+        getline(std::cin, tmp);
+        if(tmp == "y"){
+            this->FH.resetAppData();
+        }
+    }
+    this->filePath = this->FH.getEncryptionFilePath();
+    if(!this->filePath.empty() && !std::filesystem::exists(this->filePath)){
+        this->filePath = "";    //the saved file was moved or deleted
+    }
     if(this->filePath.empty()){
         std::cout << "The current encryption file location is: " << "not set" << std::endl;
         std::cout << "The new file location will be set to the current directory." << std::endl;
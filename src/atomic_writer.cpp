@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#include "atomic_writer.h"
+
+#if !defined(_WIN32)
+static void writeParts(int fd, const std::vector<BytesView>& parts){
+    //writes all parts with writev, continues after partial writes
+    std::vector<struct iovec> iov;
+    for(const BytesView& part : parts){
+        if(!part.isEmpty()){
+            iov.push_back({const_cast<unsigned char*>(part.data()), part.getLen()});
+        }
+    }
+    size_t first = 0;
+    while(first < iov.size()){
+        int count = std::min<size_t>(iov.size() - first, IOV_MAX);
+        ssize_t written = writev(fd, iov.data() + first, count);
+        if(written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw std::runtime_error(std::string("Error while writing the temp file: ") + std::strerror(errno));
+        }
+        //skip the fully written parts and move the begin of a partially written part
+        size_t done = written;
+        while(first < iov.size() && done >= iov[first].iov_len){
+            done -= iov[first].iov_len;
+            first++;
+        }
+        if(first < iov.size()){
+            iov[first].iov_base = static_cast<unsigned char*>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+}
+
+static void syncFile(int fd){
+#if defined(__APPLE__)
+    if(fcntl(fd, F_FULLFSYNC) == 0){
+        return;     //fsync on macOS does not flush the drive cache
+    }
+#endif
+    if(fsync(fd) != 0){
+        throw std::runtime_error(std::string("Error while syncing the file: ") + std::strerror(errno));
+    }
+}
+#endif
+
+static std::filesystem::path createTemp(const std::filesystem::path path, const std::function<void(const std::function<void(const std::vector<BytesView>&)>&)> produce){
+    //produce calls write with the parts of the new file (once or many times), returns the synced temp file
+#if defined(_WIN32)
+    std::filesystem::path tmp_path = path;
+    tmp_path += ".tmp";
+    try{
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        produce([&file](const std::vector<BytesView>& parts){
+            for(const BytesView& part : parts){
+                file.write(reinterpret_cast<const char*>(part.data()), part.getLen());
+            }
+        });
+        file.flush();
+        if(!file){
+            throw std::runtime_error("Error while writing the temp file");
+        }
+    }catch(...){
+        std::filesystem::remove(tmp_path);
+        throw;
+    }
+    return tmp_path;
+#else
+    std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    std::string tmp_name = (dir / ("." + path.filename().string() + ".tmpXXXXXX")).string();
+    int fd = mkstemp(tmp_name.data());     //temp file in the same directory, so the rename stays on one filesystem
+    if(fd < 0){
+        throw std::runtime_error(std::string("Cannot create a temp file: ") + std::strerror(errno));
+    }
+    try{
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0){
+            fchmod(fd, st.st_mode & 07777);     //the new file keeps the permissions of the old file
+        }
+        produce([fd](const std::vector<BytesView>& parts){
+            writeParts(fd, parts);
+        });
+        syncFile(fd);
+        if(close(fd) != 0){
+            fd = -1;
+            throw std::runtime_error(std::string("Error while closing the temp file: ") + std::strerror(errno));
+        }
+    }catch(...){
+        if(fd >= 0){
+            close(fd);
+        }
+        unlink(tmp_name.c_str());   //the old file is untouched
+        throw;
+    }
+    return tmp_name;
+#endif
+}
+
+static void commitTemp(const std::filesystem::path path, const std::filesystem::path tmp_path){
+#if defined(_WIN32)
+    try{
+        std::filesystem::rename(tmp_path, path);
+    }catch(...){
+        std::filesystem::remove(tmp_path);
+        throw;
+    }
+#else
+    if(rename(tmp_path.c_str(), path.c_str()) != 0){
+        int error = errno;
+        unlink(tmp_path.c_str());   //the old file is untouched
+        throw std::runtime_error(std::string("Cannot replace the file: ") + std::strerror(error));
+    }
+    std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dir_fd >= 0){
+        //the rename is only durable after the directory is synced (some network filesystems do not support it, then the rename is already durable)
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+#endif
+}
+
+static void replaceFile(const std::filesystem::path path, const std::function<void(const std::function<void(const std::vector<BytesView>&)>&)> produce){
+    commitTemp(path, createTemp(path, produce));
+}
+
+SaveReport AtomicWriter::writeFile(const std::filesystem::path path, const std::vector<BytesView> parts){
+    auto start = std::chrono::steady_clock::now();
+    SaveReport report;
+    for(const BytesView& part : parts){
+        report.bytes += part.getLen();
+    }
+    replaceFile(path, [&parts](const std::function<void(const std::vector<BytesView>&)>& write){
+        write(parts);   //one writev for all parts
+    });
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+SaveReport AtomicWriter::writeStream(const std::filesystem::path path, const std::function<std::optional<Bytes>()> next){
+    auto start = std::chrono::steady_clock::now();
+    SaveReport report;
+    replaceFile(path, [&next, &report](const std::function<void(const std::vector<BytesView>&)>& write){
+        for(std::optional<Bytes> part = next(); part.has_value(); part = next()){
+            write({part->getView()});     //only one part is in memory
+            report.bytes += part->getLen();
+        }
+    });
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::filesystem::path AtomicWriter::writeTemp(const std::filesystem::path path, const std::vector<BytesView> parts){
+    return createTemp(path, [&parts](const std::function<void(const std::vector<BytesView>&)>& write){
+        write(parts);
+    });
+}
+
+void AtomicWriter::replaceWithTemp(const std::filesystem::path path, const std::filesystem::path tmp_path){
+    commitTemp(path, tmp_path);
+}
+
+SaveReport AtomicWriter::writeFile(const std::filesystem::path path, const std::string content){
+    return AtomicWriter::writeFile(path, {BytesView(reinterpret_cast<const unsigned char*>(content.data()), content.size())});
+}
+
+SaveReport AtomicWriter::appendFile(const std::filesystem::path path, const unsigned long offset, const std::vector<BytesView> parts){
+    auto start = std::chrono::steady_clock::now();
+    SaveReport report;
+    for(const BytesView& part : parts){
+        report.bytes += part.getLen();
+    }
+#if defined(_WIN32)
+    std::filesystem::resize_file(path, offset);
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    for(const BytesView& part : parts){
+        file.write(reinterpret_cast<const char*>(part.data()), part.getLen());
+    }
+    file.flush();
+    if(!file){
+        throw std::runtime_error("Error while appending to the file");
+    }
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if(fd < 0){
+        throw std::runtime_error(std::string("Cannot open the file: ") + std::strerror(errno));
+    }
+    try{
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (unsigned long)st.st_size < offset){
+            throw std::runtime_error("file is shorter than the append offset");
+        }
+        if((unsigned long)st.st_size != offset && ftruncate(fd, offset) != 0){
+            throw std::runtime_error(std::string("Cannot cut the file: ") + std::strerror(errno));
+        }
+        if(lseek(fd, offset, SEEK_SET) < 0){
+            throw std::runtime_error(std::string("Cannot seek in the file: ") + std::strerror(errno));
+        }
+        writeParts(fd, parts);
+        syncFile(fd);
+    }catch(...){
+        close(fd);
+        throw;
+    }
+    close(fd);
+#endif
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::vector<unsigned char> AtomicWriter::readFile(const std::filesystem::path path){
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
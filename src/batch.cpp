@@ -0,0 +1,123 @@
+#include <cerrno>
+#include <sstream>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "batch.h"
+#include "entry_record.h"
+
+std::string Batch::getText(const BytesView value){
+    BytesView text = EntryView::isRecord(value) ? EntryView(value).getField(EntryView::FIELD_SECRET) : value;
+    for(unsigned long i=0; i < text.getLen(); i++){
+        if((text[i] < 0x20 && text[i] != '\t') || text[i] == 0x7F){
+            //an answer is one line, attachments (blob references) and multi-line values are read with pman get or pman export
+            throw std::runtime_error("value is binary or has line breaks");
+        }
+    }
+    return std::string(text.data(), text.data() + text.getLen());
+}
+
+bool Batch::execute(EntryStore& store, const std::string line, std::ostream& out){
+    std::istringstream iss(line);
+    std::string command, name;
+    iss >> command;
+    if(command == "get" || command == "del"){
+        //the name is the rest of the line after one space, so names with spaces (e.g. of imported entries) can be used
+        if(iss.peek() == ' '){
+            iss.get();
+        }
+        std::getline(iss, name);
+    }else if(command == "set" && line.find('\t') != std::string::npos){
+        //set <name><tab><value>: the name is everything up to the first tab, so it can have spaces
+        if(iss.peek() == ' '){
+            iss.get();
+        }
+        std::getline(iss, name, '\t');
+    }else{
+        iss >> name;
+    }
+    try{
+        if(command == "get" && !name.empty()){
+            std::optional<Bytes> value = store.get(name);
+            if(!value.has_value()){
+                out << "err not found" << '\n';
+                return false;
+            }
+            std::string text = Batch::getText(value->getView());     //before the answer begins, it can throw
+            out << "ok " << text << '\n';
+        }else if(command == "set" && !name.empty()){
+            //the value is the rest of the line after one space (or after the tab)
+            std::string value;
+            if(line.find('\t') == std::string::npos && iss.peek() == ' '){
+                iss.get();
+            }
+            std::getline(iss, value);
+            Bytes bytes;
+            bytes.setBytes(std::vector<unsigned char>(value.begin(), value.end()));
+            store.put(name, bytes);
+            out << "ok" << '\n';
+        }else if(command == "del" && !name.empty()){
+            if(!store.remove(name)){
+                out << "err not found" << '\n';
+                return false;
+            }
+            out << "ok" << '\n';
+        }else if(command == "list" && name.empty()){
+            std::vector<std::string> names = store.getNames();
+            out << "ok " << names.size() << '\n';
+            for(const std::string& n : names){
+                out << n << '\n';
+            }
+        }else{
+            out << "err unknown command" << '\n';
+            return false;
+        }
+    }catch(std::exception& e){
+        out << "err " << e.what() << '\n';
+        return false;
+    }
+    return true;
+}
+
+unsigned long Batch::run(EntryStore& store, std::istream& in, std::ostream& out){
+    unsigned long failed = 0;
+    std::string line;
+    while(std::getline(in, line)){
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        if(line.empty()){
+            continue;
+        }
+        if(!Batch::execute(store, line, out)){
+            failed++;
+        }
+        out.flush();    //the caller can read each answer before it sends the next command
+    }
+    return failed;
+}
+
+std::string Batch::readPassword(int fd){
+    std::string password;
+    char c;
+    while(true){
+#if defined(_WIN32)
+        int got = _read(fd, &c, 1);
+#else
+        ssize_t got = read(fd, &c, 1);
+#endif
+        if(got < 0 && errno == EINTR){
+            continue;
+        }
+        if(got <= 0 || c == '\n'){
+            break;      //one byte at a time, so nothing behind the first line is consumed
+        }
+        password += c;
+    }
+    if(!password.empty() && password.back() == '\r'){
+        password.pop_back();
+    }
+    return password;
+}
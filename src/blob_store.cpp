@@ -0,0 +1,192 @@
+#include <chrono>
+#include <fstream>
+#include <openssl/crypto.h>
+#include "blob_store.h"
+#include "atomic_writer.h"
+#include "cipher_modes.h"
+#include "rng.h"
+
+static const std::string BLOB_MAGIC = "PBLB";
+static const std::string REF_MAGIC = "PREF";
+
+BlobStore::BlobStore(const std::filesystem::path vault_path, unsigned char const cipher_mode, const Bytes datakey){
+    if(!CipherModes::isAuthenticated(cipher_mode)){
+        throw std::invalid_argument("attachments need an authenticated cipher mode");
+    }
+    this->dir = BlobStore::getBlobDir(vault_path);
+    this->cipher_mode = cipher_mode;
+    this->key = CipherModes::deriveKey(datakey, "blob");
+}
+
+Bytes BlobStore::getBlobKey(const Bytes id) const{
+    return CipherModes::deriveKey(this->key, toHex(id));
+}
+
+std::filesystem::path BlobStore::getBlobPath(const Bytes id) const{
+    return this->dir / toHex(id);
+}
+
+BlobRef BlobStore::write(std::istream& in, unsigned long chunk_len) const{
+    if(chunk_len == 0 || chunk_len > 0xFFFFFFFF){
+        throw std::range_error("chunk length has to fit into 4 bytes and cannot be zero");
+    }
+    BlobRef ref;
+    ref.id.setBytes(RNG::get_random_bytes(ID_LEN));
+    ref.chunk_len = chunk_len;
+    Bytes blob_key = this->getBlobKey(ref.id);
+    std::filesystem::create_directories(this->dir);
+    std::vector<unsigned char> chunk(CHUNK_PREFIX_LEN + chunk_len);
+    unsigned long index = 0;
+    bool header = true;
+    bool last = false;
+    AtomicWriter::writeStream(this->getBlobPath(ref.id), [&]() -> std::optional<Bytes>{
+        if(header){
+            header = false;
+            Bytes h;
+            h.setBytes(std::vector<unsigned char>(BLOB_MAGIC.begin(), BLOB_MAGIC.end()));
+            h.addBytes(fromLong(ref.chunk_len, 4));
+            h.addBytes(ref.id);
+            return h;
+        }
+        if(last){
+            return {};
+        }
+        in.read(reinterpret_cast<char*>(chunk.data() + CHUNK_PREFIX_LEN), ref.chunk_len);
+        unsigned long read = in.gcount();
+        if(in.bad()){
+            throw std::runtime_error("Error while reading the attachment");
+        }
+        last = read < ref.chunk_len || in.peek() == std::char_traits<char>::eof();
+        std::vector<unsigned char> prefix = fromLong(index++).getBytes();
+        std::copy(prefix.begin(), prefix.end(), chunk.begin());
+        chunk[8] = last ? 1 : 0;
+        ref.len += read;
+        Bytes plain;
+        plain.setBytes(std::vector<unsigned char>(chunk.begin(), chunk.begin() + CHUNK_PREFIX_LEN + read));
+        Bytes encrypted = CipherModes::encrypt(this->cipher_mode, blob_key, plain);
+        OPENSSL_cleanse(chunk.data(), chunk.size());
+        return encrypted;
+    });
+    return ref;
+}
+
+void BlobStore::checkHeader(std::istream& file, const BlobRef& ref) const{
+    std::vector<unsigned char> header(HEADER_LEN);
+    if(!file.read(reinterpret_cast<char*>(header.data()), HEADER_LEN) || std::string(header.begin(), header.begin() + 4) != BLOB_MAGIC){
+        throw std::runtime_error("attachment is corrupted (no blob header)");
+    }
+    BytesView h(header);
+    if(toLong(h.slice(4, 4)) != ref.chunk_len || !(h.slice(8, ID_LEN).toBytes() == ref.id)){
+        throw std::runtime_error("attachment does not match with its reference");
+    }
+}
+
+Bytes BlobStore::readChunk(std::istream& file, const BlobRef& ref, unsigned long index) const{
+    unsigned long count = BlobStore::getChunkNumber(ref);
+    unsigned long plain_len = index + 1 < count ? ref.chunk_len : ref.len - index * ref.chunk_len;
+    std::vector<unsigned char> encrypted(CipherModes::getEncryptedLen(this->cipher_mode, CHUNK_PREFIX_LEN + plain_len));
+    if(!file.read(reinterpret_cast<char*>(encrypted.data()), encrypted.size())){
+        throw std::runtime_error("attachment is cut off");
+    }
+    Bytes enc;
+    enc.setBytes(encrypted);
+    Bytes plain = CipherModes::decrypt(this->cipher_mode, this->getBlobKey(ref.id), enc);  //throws if the chunk was modified
+    BytesView p = plain.getView();
+    if(p.getLen() != CHUNK_PREFIX_LEN + plain_len || toLong(p.slice(0, 8)) != index || p[8] != (index + 1 == count ? 1 : 0)){
+        throw std::runtime_error("attachment is corrupted (chunks are missing or reordered)");
+    }
+    return p.slice(CHUNK_PREFIX_LEN, plain_len).toBytes();
+}
+
+Bytes BlobStore::readChunk(const BlobRef& ref, unsigned long index) const{
+    if(index >= BlobStore::getChunkNumber(ref)){
+        throw std::range_error("chunk does not exist");
+    }
+    std::ifstream file(this->getBlobPath(ref.id), std::ios::binary);
+    if(!file){
+        throw std::runtime_error("attachment not found");
+    }
+    this->checkHeader(file, ref);
+    //all chunks before the last one have the same encrypted length
+    file.seekg(HEADER_LEN + index * CipherModes::getEncryptedLen(this->cipher_mode, CHUNK_PREFIX_LEN + ref.chunk_len));
+    return this->readChunk(file, ref, index);
+}
+
+void BlobStore::read(const BlobRef& ref, std::ostream& out) const{
+    std::ifstream file(this->getBlobPath(ref.id), std::ios::binary);
+    if(!file){
+        throw std::runtime_error("attachment not found");
+    }
+    this->checkHeader(file, ref);
+    for(unsigned long i=0; i < BlobStore::getChunkNumber(ref); i++){
+        Bytes chunk = this->readChunk(file, ref, i);
+        BytesView view = chunk.getView();
+        out.write(reinterpret_cast<const char*>(view.data()), view.getLen());
+        if(!out){
+            throw std::runtime_error("Error while writing the attachment");
+        }
+    }
+    if(file.peek() != std::char_traits<char>::eof()){
+        throw std::runtime_error("attachment is corrupted (data behind the last chunk)");
+    }
+}
+
+unsigned long BlobStore::getChunkNumber(const BlobRef& ref) noexcept{
+    if(ref.chunk_len == 0 || ref.len == 0){
+        return 1;
+    }
+    return (ref.len + ref.chunk_len - 1) / ref.chunk_len;
+}
+
+Bytes BlobStore::encodeRef(const BlobRef& ref){
+    if(ref.id.getLen() != ID_LEN || ref.chunk_len == 0 || ref.chunk_len > 0xFFFFFFFF){
+        throw std::invalid_argument("reference has no valid id or chunk length");
+    }
+    Bytes encoded;
+    encoded.setBytes(std::vector<unsigned char>(REF_MAGIC.begin(), REF_MAGIC.end()));
+    encoded.addBytes(ref.id);
+    encoded.addBytes(fromLong(ref.len));
+    encoded.addBytes(fromLong(ref.chunk_len, 4));
+    return encoded;
+}
+
+std::optional<BlobRef> BlobStore::decodeRef(const BytesView value) noexcept{
+    if(value.getLen() != REF_LEN || std::string(value.data(), value.data() + 4) != REF_MAGIC){
+        return {};
+    }
+    BlobRef ref;
+    ref.id = value.slice(4, ID_LEN).toBytes();
+    ref.len = toLong(value.slice(4 + ID_LEN, 8));
+    ref.chunk_len = toLong(value.slice(12 + ID_LEN, 4));
+    if(ref.chunk_len == 0){
+        return {};
+    }
+    return ref;
+}
+
+std::filesystem::path BlobStore::getBlobDir(const std::filesystem::path vault_path){
+    std::filesystem::path dir = vault_path;
+    dir += ".blobs";
+    return dir;
+}
+
+unsigned long BlobStore::removeUnreferenced(const std::filesystem::path vault_path, const std::set<std::string> ids, long grace_seconds){
+    std::filesystem::path dir = BlobStore::getBlobDir(vault_path);
+    if(!std::filesystem::is_directory(dir)){
+        return 0;
+    }
+    unsigned long removed = 0;
+    auto now = std::filesystem::file_time_type::clock::now();
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)){
+        std::string name = entry.path().filename().string();
+        if(!entry.is_regular_file() || name.size() != 2*ID_LEN || ids.count(name) != 0){
+            continue;   //temp files of running writes and referenced blobs
+        }
+        if(now - entry.last_write_time() < std::chrono::seconds(grace_seconds)){
+            continue;   //the reference of a new blob may not be appended yet
+        }
+        std::filesystem::remove(entry.path());
+        removed++;
+    }
+    return removed;
+}
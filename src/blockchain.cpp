@@ -0,0 +1,215 @@
+#include "blockchain.h"
+
+BlockChain::BlockChain(const Hash* hash, Bytes passwordhash, Bytes salt){
+    if(hash == nullptr){
+        throw std::invalid_argument("no hash function given");
+    }
+    if(passwordhash.getLen() != hash->getHashSize() || salt.getLen() != hash->getHashSize()){
+        //every block has the length of the hash size
+        throw std::length_error("length of the passwordhash or salt does not match with the hash size");
+    }
+    this->hash = hash;
+    this->passwordhash = passwordhash;
+    this->first_salt = salt;
+    this->data_len = 0;
+}
+
+Bytes BlockChain::calcNextSalt(const Bytes prev_salt) const{
+    Bytes salt_input = prev_salt;
+    salt_input.addBytes(this->passwordhash);
+    return prev_salt + this->hash->hash(salt_input);     //bytes operator overload
+}
+
+unsigned int BlockChain::getBlockLen() const noexcept{
+    return this->passwordhash.getLen();
+}
+
+unsigned long BlockChain::getBlockNumber() const noexcept{
+    return this->chain.size();
+}
+
+unsigned long BlockChain::getDataLen() const noexcept{
+    return this->data_len;
+}
+
+unsigned long BlockChain::getEncodedLen() const noexcept{
+    return this->getBlockNumber() * this->getBlockLen();
+}
+
+void BlockChain::resizeChain(unsigned long block_num){
+    while(this->chain.size() < block_num){
+        //new blocks get the next salt of the chain and are filled with zeros
+        Bytes salt = this->chain.empty() ? this->first_salt : this->calcNextSalt(this->chain.back().getSalt());
+        Bytes zeros;
+        zeros.setBytes(std::vector<unsigned char>(this->getBlockLen(), 0));
+        this->chain.push_back(Block(this->getBlockLen(), zeros, salt, this->passwordhash));
+        this->dirty.insert(this->chain.size()-1);
+    }
+    if(this->chain.size() > block_num){
+        //removed blocks dont have to be written anymore
+        this->chain.resize(block_num);
+        this->dirty.erase(this->dirty.lower_bound(block_num), this->dirty.end());
+    }
+}
+
+void BlockChain::writeData(unsigned long pos, const Bytes data){
+    if(pos > this->data_len){
+        //there would be a gap in the data
+        throw std::range_error("position is behind the end of the data");
+    }
+    if(data.isEmpty()){
+        return;
+    }
+    unsigned long block_len = this->getBlockLen();
+    unsigned long new_len = std::max(this->data_len, pos + data.getLen());
+    this->resizeChain((new_len + block_len - 1) / block_len);
+
+    std::vector<unsigned char> input = data.getBytes();
+    unsigned long written = 0;
+    while(written < input.size()){
+        unsigned long index = (pos + written) / block_len;          //block that contains the current position
+        unsigned long offset = (pos + written) % block_len;         //position inside of this block
+        unsigned long num = std::min(block_len - offset, input.size() - written);
+        std::vector<unsigned char> block_data = this->chain[index].getData().getBytes();
+        std::copy(input.begin() + written, input.begin() + written + num, block_data.begin() + offset);
+        Bytes new_data;
+        new_data.setBytes(block_data);
+        this->chain[index].setData(new_data);
+        this->dirty.insert(index);
+        written += num;
+    }
+    this->data_len = new_len;
+}
+
+void BlockChain::encodeDirty(){
+    for(unsigned long index : this->dirty){
+        this->chain[index].calcEncoded();
+    }
+}
+
+void BlockChain::setData(const Bytes data){
+    this->resizeChain(0);
+    this->data_len = 0;
+    this->writeData(0, data);
+}
+
+Bytes BlockChain::getData() const{
+    return this->getDataFrom(0);
+}
+
+Bytes BlockChain::getDataFrom(unsigned long pos) const{
+    unsigned long block_len = this->getBlockLen();
+    std::vector<unsigned char> data;
+    data.reserve(this->data_len - pos);
+    for(unsigned long index = pos / block_len; index < this->chain.size(); index++){
+        //only the blocks from pos on are copied
+        std::vector<unsigned char> block_data = this->chain[index].getData().getBytes();
+        data.insert(data.end(), block_data.begin(), block_data.end());
+    }
+    data.erase(data.begin(), data.begin() + pos % block_len);
+    data.resize(this->data_len - pos);    //removes the fill up bytes of the last block
+    Bytes ret;
+    ret.setBytes(data);
+    return ret;
+}
+
+void BlockChain::setEncoded(const Bytes encoded){
+    unsigned long block_len = this->getBlockLen();
+    if(encoded.getLen() % block_len != 0){
+        throw std::length_error("length of the encoded data is not a multiple of the block length");
+    }
+    this->chain.clear();
+    this->dirty.clear();
+    std::vector<unsigned char> enc = encoded.getBytes();
+    Bytes salt = this->first_salt;
+    for(unsigned long pos = 0; pos < enc.size(); pos += block_len){
+        if(pos != 0){
+            salt = this->calcNextSalt(salt);
+        }
+        Bytes block_enc;
+        block_enc.setBytes(std::vector<unsigned char>(enc.begin() + pos, enc.begin() + pos + block_len));
+        Block block(block_enc);
+        block.setSalt(salt);
+        block.setPasswordHash(this->passwordhash);
+        block.calcData();
+        this->chain.push_back(block);
+    }
+    this->data_len = enc.size();
+}
+
+Bytes BlockChain::getEncoded(){
+    this->encodeDirty();
+    std::vector<unsigned char> encoded;
+    encoded.reserve(this->getEncodedLen());
+    for(const Block& block : this->chain){
+        std::vector<unsigned char> block_enc = block.getEncoded().getBytes();
+        encoded.insert(encoded.end(), block_enc.begin(), block_enc.end());
+    }
+    Bytes ret;
+    ret.setBytes(encoded);
+    return ret;
+}
+
+void BlockChain::changeData(unsigned long pos, const Bytes data){
+    this->writeData(pos, data);
+}
+
+void BlockChain::insertData(unsigned long pos, const Bytes data){
+    if(pos > this->data_len){
+        throw std::range_error("position is behind the end of the data");
+    }
+    //all bytes behind pos are shifted, so the suffix has to be written again
+    Bytes shifted = data;
+    shifted.addBytes(this->getDataFrom(pos));
+    this->writeData(pos, shifted);
+}
+
+void BlockChain::removeData(unsigned long pos, unsigned long len){
+    if(pos + len > this->data_len){
+        throw std::range_error("range to remove is behind the end of the data");
+    }
+    if(len == 0){
+        return;
+    }
+    Bytes shifted = this->getDataFrom(pos + len);
+    this->data_len = pos;
+    this->writeData(pos, shifted);
+    unsigned long block_len = this->getBlockLen();
+    this->resizeChain((this->data_len + block_len - 1) / block_len);
+    if(this->data_len % block_len != 0){
+        //the removed bytes in the last block are filled up with zeros again
+        unsigned long index = this->chain.size() - 1;
+        std::vector<unsigned char> block_data = this->chain[index].getData().getBytes();
+        std::fill(block_data.begin() + this->data_len % block_len, block_data.end(), 0);
+        Bytes new_data;
+        new_data.setBytes(block_data);
+        this->chain[index].setData(new_data);
+        this->dirty.insert(index);
+    }
+}
+
+bool BlockChain::isDirty() const noexcept{
+    return !this->dirty.empty();
+}
+
+std::vector<unsigned long> BlockChain::getDirtyBlocks() const noexcept{
+    return std::vector<unsigned long>(this->dirty.begin(), this->dirty.end());
+}
+
+std::vector<std::pair<unsigned long, Bytes>> BlockChain::getDirtyEncoded(){
+    this->encodeDirty();
+    std::vector<std::pair<unsigned long, Bytes>> ranges;
+    unsigned long block_len = this->getBlockLen();
+    unsigned long last_index = 0;
+    for(unsigned long index : this->dirty){
+        if(!ranges.empty() && last_index + 1 == index){
+            //block follows directly on the previous dirty block, so the range is extended
+            ranges.back().second.addBytes(this->chain[index].getEncoded());
+        }else{
+            ranges.push_back({index * block_len, this->chain[index].getEncoded()});
+        }
+        last_index = index;
+    }
+    this->dirty.clear();
+    return ranges;
+}
@@ -28,6 +28,10 @@ std::vector<unsigned char> Bytes::getBytes() const noexcept{
     return this->bytes;
 }
 
+BytesView Bytes::getView() const noexcept{
+    return BytesView(this->bytes);
+}
+
 int Bytes::getLen() const noexcept{
     return this->bytes.size();
 }
@@ -143,6 +147,51 @@ Bytes operator-(Bytes b1, Bytes b2){
     return ret;
 }
 
+BytesView::BytesView() noexcept{
+    this->bytes = nullptr;
+    this->len = 0;
+}
+
+BytesView::BytesView(const unsigned char* bytes, unsigned long len) noexcept{
+    this->bytes = bytes;
+    this->len = len;
+}
+
+BytesView::BytesView(const std::vector<unsigned char>& bytes) noexcept{
+    this->bytes = bytes.data();
+    this->len = bytes.size();
+}
+
+const unsigned char* BytesView::data() const noexcept{
+    return this->bytes;
+}
+
+unsigned long BytesView::getLen() const noexcept{
+    return this->len;
+}
+
+bool BytesView::isEmpty() const noexcept{
+    return this->len == 0;
+}
+
+unsigned char BytesView::operator[](unsigned long i) const noexcept{
+    return this->bytes[i];
+}
+
+BytesView BytesView::slice(unsigned long pos, unsigned long len) const{
+    if(pos > this->len || len > this->len - pos){
+        //the slice would reach behind the viewed bytes
+        throw std::range_error("The slice is out of range");
+    }
+    return BytesView(this->bytes + pos, len);
+}
+
+Bytes BytesView::toBytes() const noexcept{
+    Bytes ret;
+    ret.setBytes(std::vector<unsigned char>(this->bytes, this->bytes + this->len));
+    return ret;
+}
+
 std::string toHex(const unsigned char byte) noexcept{
     char hex[] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
     std::string ret{};
@@ -175,3 +224,30 @@ unsigned long toLong(Bytes b) noexcept{
     }
     return ret;
 }
+
+unsigned long toLong(BytesView b) noexcept{
+    unsigned long ret = 0;
+    for(unsigned long i=0; i < b.getLen(); i++){
+        //same as toLong(Bytes) but without copying the bytes
+        ret = ret*256 + b[i];
+    }
+    return ret;
+}
+
+Bytes fromLong(unsigned long num, const int len){
+    if(len < 0 || len > 8){
+        throw std::range_error("The provided len is not between 0 and 8");
+    }
+    std::vector<unsigned char> v(len);
+    for(int i=len-1; i >= 0; i--){
+        //the lowest byte is at the end
+        v[i] = num % 256;
+        num /= 256;
+    }
+    if(num != 0){
+        throw std::range_error("The number does not fit into the provided len");
+    }
+    Bytes ret;
+    ret.setBytes(v);
+    return ret;
+}
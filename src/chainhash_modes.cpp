@@ -1,4 +1,5 @@
 #include "chainhash_modes.h"
+#include "pwfunc.h"
 
 bool ChainHashModes::isModeValid(unsigned char const chainhash_mode) noexcept{
     return (1 <= chainhash_mode <= MAX_CHAINHASHMODE_NUMBER);
@@ -36,35 +37,35 @@ bool ChainHashModes::isChainHashValid(unsigned char const chainhash_mode, unsign
     }
 }
 
-Bytes ChainHashModes::performChainHash(unsigned char const chainhash_mode, unsigned long iters, Hash *hash, Bytes data){
-    switch (chainhash_mode){
-    case 1: //normal chainhash
-        return Bytes();
-    case 2: //constant salt
-        return Bytes();
-    case 3: //count salt
-        return Bytes();
-    case 4: //constant + count salt
-        return Bytes();
-    case 5: //Quadratic count salt
-        return Bytes();
-    default:
-        throw std::invalid_argument("chainhash mode does not exist");
-    }
+Bytes ChainHashModes::performChainHash(unsigned char const chainhash_mode, unsigned long iters, Bytes datablock, Hash *hash, Bytes data, const std::atomic<bool>* stop){
+    std::vector<unsigned char> v = data.getBytes();
+    return ChainHashModes::performChainHash(chainhash_mode, iters, datablock, hash, std::string(v.begin(), v.end()), stop);
 }
 
-Bytes ChainHashModes::performChainHash(unsigned char const chainhash_mode, unsigned long iters, Hash *hash, std::string data){
+Bytes ChainHashModes::performChainHash(unsigned char const chainhash_mode, unsigned long iters, Bytes datablock, Hash *hash, std::string data, const std::atomic<bool>* stop){
+    if(!ChainHashModes::isChainHashValid(chainhash_mode, iters, datablock)){
+        throw std::invalid_argument("given chainhash data is not valid");
+    }
+    PwFunc pwfunc(hash);
+    pwfunc.setStopFlag(stop);
+    std::vector<unsigned char> block = datablock.getBytes();
     switch (chainhash_mode){
     case 1: //normal chainhash
-        return Bytes();
+        return pwfunc.chainhash(data, iters);
     case 2: //constant salt
-        return Bytes();
+        return pwfunc.chainhashWithConstantSalt(data, iters, std::string(block.begin(), block.end()));
     case 3: //count salt
-        return Bytes();
+        return pwfunc.chainhashWithCountSalt(data, iters, toLong(datablock.getFirstBytes(8).value()));
     case 4: //constant + count salt
-        return Bytes();
+        return pwfunc.chainhashWithCountAndConstantSalt(data, iters, toLong(datablock.getFirstBytes(8).value()), std::string(block.begin() + 8, block.end()));
     case 5: //quadratic count salt
-        return Bytes();
+        {
+            unsigned long args[4];
+            for(int i=0; i < 4; i++){
+                args[i] = toLong(datablock.popFirstBytes(8).value());  //SN, A, B, C
+            }
+            return pwfunc.chainhashWithQuadraticCountSalt(data, iters, args[0], args[1], args[2], args[3]);
+        }
     default:
         throw std::invalid_argument("chainhash mode does not exist");
     }
@@ -0,0 +1,161 @@
+#include <memory>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include "cipher_modes.h"
+#include "rng.h"
+
+static const EVP_CIPHER* getCipher(unsigned char const cipher_mode){
+    switch(cipher_mode){
+        case 2: //AES-256-GCM (uses AES-NI if the cpu supports it)
+            return EVP_aes_256_gcm();
+        case 3: //ChaCha20-Poly1305
+            return EVP_chacha20_poly1305();
+        default:
+            throw std::invalid_argument("cipher mode is not an openssl cipher");
+    }
+}
+
+static void setChunkNonce(const unsigned char* base_nonce, unsigned long index, unsigned char* nonce){
+    //the chunk index is xored into the last 8 bytes of the random nonce, so no nonce is used twice
+    std::copy(base_nonce, base_nonce + CipherModes::NONCE_LEN, nonce);
+    for(int i=0; i < 8; i++){
+        nonce[CipherModes::NONCE_LEN-1-i] ^= (index >> (8*i)) & 0xFF;
+    }
+}
+
+static void setChunkAad(unsigned long index, bool last, unsigned char* aad){
+    //the index and the last flag are authenticated, so chunks cannot be reordered or cut off
+    for(int i=0; i < 8; i++){
+        aad[7-i] = (index >> (8*i)) & 0xFF;
+    }
+    aad[8] = last ? 1 : 0;
+}
+
+bool CipherModes::isModeValid(unsigned char const cipher_mode) noexcept{
+    return (1 <= cipher_mode && cipher_mode <= MAX_CIPHERMODE_NUMBER);
+}
+
+bool CipherModes::isAuthenticated(unsigned char const cipher_mode) noexcept{
+    return (cipher_mode == 2 || cipher_mode == 3);
+}
+
+Bytes CipherModes::deriveKey(const Bytes passwordhash, const std::string purpose){
+    if(passwordhash.isEmpty()){
+        throw std::invalid_argument("passwordhash is empty");
+    }
+    std::vector<unsigned char> pwhash = passwordhash.getBytes();
+    unsigned char key[EVP_MAX_MD_SIZE];
+    unsigned int key_len = 0;
+    if(HMAC(EVP_sha256(), pwhash.data(), pwhash.size(), reinterpret_cast<const unsigned char*>(purpose.data()), purpose.size(), key, &key_len) == nullptr){
+        throw std::runtime_error("Error occured in deriveKey");
+    }
+    Bytes ret;
+    ret.setBytes(std::vector<unsigned char>(key, key + key_len));
+    return ret;
+}
+
+unsigned long CipherModes::getEncryptedLen(unsigned char const cipher_mode, unsigned long data_len){
+    if(!CipherModes::isAuthenticated(cipher_mode)){
+        throw std::invalid_argument("cipher mode is not an openssl cipher");
+    }
+    unsigned long chunks = data_len == 0 ? 1 : (data_len + CIPHER_CHUNK_SIZE - 1) / CIPHER_CHUNK_SIZE;
+    return NONCE_LEN + data_len + chunks*TAG_LEN;
+}
+
+Bytes CipherModes::encrypt(unsigned char const cipher_mode, const Bytes key, const Bytes data){
+    const EVP_CIPHER* cipher = getCipher(cipher_mode);
+    if(key.getLen() != KEY_LEN){
+        throw std::length_error("length of the key does not match with the key length of the cipher");
+    }
+    std::vector<unsigned char> k = key.getBytes();
+    std::vector<unsigned char> in = data.getBytes();
+    std::vector<unsigned char> out(CipherModes::getEncryptedLen(cipher_mode, in.size()));
+    std::vector<unsigned char> base_nonce = RNG::get_random_bytes(NONCE_LEN);
+    std::copy(base_nonce.begin(), base_nonce.end(), out.begin());
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if(!ctx || EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr) != 1){
+        throw std::runtime_error("Error occured while initializing the cipher");
+    }
+    unsigned long in_pos = 0;
+    unsigned long out_pos = NONCE_LEN;
+    unsigned long index = 0;
+    do{
+        //encrypts one chunk and appends its tag
+        unsigned long chunk_len = std::min(CIPHER_CHUNK_SIZE, in.size() - in_pos);
+        bool last = (in_pos + chunk_len == in.size());
+        unsigned char nonce[NONCE_LEN];
+        unsigned char aad[9];
+        setChunkNonce(base_nonce.data(), index, nonce);
+        setChunkAad(index, last, aad);
+        int len = 0;
+        if(EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr, k.data(), nonce) != 1
+            || EVP_EncryptUpdate(ctx.get(), nullptr, &len, aad, sizeof(aad)) != 1
+            || EVP_EncryptUpdate(ctx.get(), out.data() + out_pos, &len, in.data() + in_pos, chunk_len) != 1
+            || EVP_EncryptFinal_ex(ctx.get(), out.data() + out_pos + len, &len) != 1
+            || EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_GET_TAG, TAG_LEN, out.data() + out_pos + chunk_len) != 1){
+            throw std::runtime_error("Error occured while encrypting the data");
+        }
+        in_pos += chunk_len;
+        out_pos += chunk_len + TAG_LEN;
+        index++;
+    }while(in_pos < in.size());
+
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
+
+Bytes CipherModes::decrypt(unsigned char const cipher_mode, const Bytes key, const Bytes encrypted){
+    const EVP_CIPHER* cipher = getCipher(cipher_mode);
+    if(key.getLen() != KEY_LEN){
+        throw std::length_error("length of the key does not match with the key length of the cipher");
+    }
+    if(encrypted.getLen() < NONCE_LEN + TAG_LEN){
+        throw std::length_error("encrypted data is too short");
+    }
+    std::vector<unsigned char> k = key.getBytes();
+    std::vector<unsigned char> in = encrypted.getBytes();
+    std::vector<unsigned char> out;
+    out.resize(in.size() - NONCE_LEN - TAG_LEN);    //upper bound, the tags of the other chunks are removed at the end
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if(!ctx || EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr) != 1){
+        throw std::runtime_error("Error occured while initializing the cipher");
+    }
+    unsigned long in_pos = NONCE_LEN;
+    unsigned long out_pos = 0;
+    unsigned long index = 0;
+    bool last = false;
+    while(!last){
+        //every chunk except the last one has the full chunk size
+        unsigned long remaining = in.size() - in_pos;
+        if(remaining < TAG_LEN){
+            throw std::length_error("encrypted data is cut off");
+        }
+        last = (remaining <= CIPHER_CHUNK_SIZE + TAG_LEN);
+        unsigned long chunk_len = last ? remaining - TAG_LEN : CIPHER_CHUNK_SIZE;
+        unsigned char nonce[NONCE_LEN];
+        unsigned char aad[9];
+        setChunkNonce(in.data(), index, nonce);
+        setChunkAad(index, last, aad);
+        int len = 0;
+        if(EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, k.data(), nonce) != 1
+            || EVP_DecryptUpdate(ctx.get(), nullptr, &len, aad, sizeof(aad)) != 1
+            || EVP_DecryptUpdate(ctx.get(), out.data() + out_pos, &len, in.data() + in_pos, chunk_len) != 1
+            || EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, TAG_LEN, in.data() + in_pos + chunk_len) != 1){
+            throw std::runtime_error("Error occured while decrypting the data");
+        }
+        if(EVP_DecryptFinal_ex(ctx.get(), out.data() + out_pos + len, &len) != 1){
+            //the tag does not match, so the key is wrong or the data was modified
+            throw std::runtime_error("Authentication of the encrypted data failed (chunk " + std::to_string(index) + ")");
+        }
+        in_pos += chunk_len + TAG_LEN;
+        out_pos += chunk_len;
+        index++;
+    }
+    out.resize(out_pos);
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
@@ -0,0 +1,219 @@
+#include <cstring>
+#include "compression.h"
+
+static const constexpr unsigned long MIN_MATCH = 4;         //shortest match that is encoded
+static const constexpr unsigned long MAX_OFFSET = 65535;    //offsets are stored in two bytes
+static const constexpr int HASH_BITS = 14;                  //size of the match finder table
+
+static uint32_t read32(const unsigned char* p){
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void writeLength(std::vector<unsigned char>& out, unsigned long len){
+    //lengths >= 15 are continued with bytes of 255 and a last byte < 255
+    while(len >= 255){
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(len);
+}
+
+static void writeSequence(std::vector<unsigned char>& out, const unsigned char* literals, unsigned long literal_len, unsigned long offset, unsigned long match_len){
+    //one sequence: token, literal length, literals, offset, match length
+    unsigned long match_code = match_len - MIN_MATCH;
+    unsigned char token = (std::min(literal_len, 15UL) << 4) | (match_len == 0 ? 0 : std::min(match_code, 15UL));
+    out.push_back(token);
+    if(literal_len >= 15){
+        writeLength(out, literal_len - 15);
+    }
+    out.insert(out.end(), literals, literals + literal_len);
+    if(match_len == 0){
+        return;     //last sequence has no match
+    }
+    out.push_back(offset & 0xFF);
+    out.push_back((offset >> 8) & 0xFF);
+    if(match_code >= 15){
+        writeLength(out, match_code - 15);
+    }
+}
+
+static unsigned long readLength(const std::vector<unsigned char>& in, unsigned long& pos){
+    unsigned long len = 0;
+    unsigned char byte;
+    do{
+        if(pos >= in.size()){
+            throw std::runtime_error("compressed data is corrupted (length is cut off)");
+        }
+        byte = in[pos++];
+        len += byte;
+    }while(byte == 255);
+    return len;
+}
+
+bool Compression::isModeValid(unsigned char const compression_mode) noexcept{
+    return (compression_mode <= MAX_COMPRESSIONMODE_NUMBER);
+}
+
+Bytes Compression::compressBlock(const Bytes data){
+    std::vector<unsigned char> v = data.getBytes();
+    const unsigned char* in = v.data();
+    unsigned long n = v.size();
+    std::vector<unsigned char> out;
+    out.reserve(n + n/255 + 16);
+    std::vector<long> table(1 << HASH_BITS, -1);   //last position of each hashed 4 byte sequence
+
+    unsigned long anchor = 0;   //begin of the literals that are not written yet
+    unsigned long pos = 0;
+    while(pos + MIN_MATCH <= n){
+        uint32_t seq = read32(in + pos);
+        uint32_t h = (seq * 2654435761u) >> (32 - HASH_BITS);
+        long candidate = table[h];
+        table[h] = pos;
+        if(candidate >= 0 && pos - candidate <= MAX_OFFSET && read32(in + candidate) == seq){
+            //match found, extend it as far as possible
+            unsigned long len = MIN_MATCH;
+            while(pos + len < n && in[candidate + len] == in[pos + len]){
+                len++;
+            }
+            writeSequence(out, in + anchor, pos - anchor, pos - candidate, len);
+            pos += len;
+            anchor = pos;
+        }else{
+            pos++;
+        }
+    }
+    writeSequence(out, in + anchor, n - anchor, 0, 0);     //remaining literals
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
+
+Bytes Compression::decompressBlock(const Bytes data, unsigned long plain_len){
+    std::vector<unsigned char> in = data.getBytes();
+    std::vector<unsigned char> out;
+    out.reserve(plain_len);
+    unsigned long pos = 0;
+    while(pos < in.size()){
+        unsigned char token = in[pos++];
+        unsigned long literal_len = token >> 4;
+        if(literal_len == 15){
+            literal_len += readLength(in, pos);
+        }
+        if(pos + literal_len > in.size() || out.size() + literal_len > plain_len){
+            throw std::runtime_error("compressed data is corrupted (literals are too long)");
+        }
+        out.insert(out.end(), in.begin() + pos, in.begin() + pos + literal_len);
+        pos += literal_len;
+        if(pos == in.size()){
+            break;  //last sequence has no match
+        }
+        if(pos + 2 > in.size()){
+            throw std::runtime_error("compressed data is corrupted (offset is cut off)");
+        }
+        unsigned long offset = in[pos] | (in[pos+1] << 8);
+        pos += 2;
+        unsigned long match_len = (token & 15) + MIN_MATCH;
+        if((token & 15) == 15){
+            match_len += readLength(in, pos);
+        }
+        if(offset == 0 || offset > out.size() || out.size() + match_len > plain_len){
+            throw std::runtime_error("compressed data is corrupted (invalid match)");
+        }
+        unsigned long from = out.size() - offset;
+        for(unsigned long i=0; i < match_len; i++){
+            //byte by byte because the match can overlap with itself
+            out.push_back(out[from + i]);
+        }
+    }
+    if(out.size() != plain_len){
+        throw std::runtime_error("compressed data is corrupted (wrong length)");
+    }
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
+
+Bytes Compression::compress(unsigned char const compression_mode, const Bytes data, unsigned long segment_size){
+    if(!Compression::isModeValid(compression_mode)){
+        throw std::invalid_argument("compression mode does not exist");
+    }
+    if(compression_mode == 0){
+        return data;
+    }
+    if(segment_size == 0 || segment_size > 0xFFFFFFFF){
+        throw std::range_error("segment size has to fit into 4 bytes and cannot be zero");
+    }
+    std::vector<unsigned char> v = data.getBytes();
+    Bytes ret;
+    for(unsigned long pos = 0; pos < v.size(); pos += segment_size){
+        Bytes segment;
+        segment.setBytes(std::vector<unsigned char>(v.begin() + pos, v.begin() + std::min(v.size(), pos + segment_size)));
+        Bytes compressed = Compression::compressBlock(segment);
+        if(compressed.getLen() >= segment.getLen()){
+            //segment does not get smaller, it is stored (stored length = plain length)
+            compressed = segment;
+        }
+        ret.addBytes(fromLong(segment.getLen(), 4));
+        ret.addBytes(fromLong(compressed.getLen(), 4));
+        ret.addBytes(compressed);
+    }
+    return ret;
+}
+
+std::vector<unsigned long> Compression::getSegmentOffsets(const Bytes data){
+    std::vector<unsigned char> v = data.getBytes();
+    std::vector<unsigned long> offsets;
+    unsigned long pos = 0;
+    while(pos < v.size()){
+        if(pos + FRAME_HEADER_LEN > v.size()){
+            throw std::runtime_error("compressed data is corrupted (frame header is cut off)");
+        }
+        unsigned long stored_len = (unsigned long)v[pos+4] << 24 | v[pos+5] << 16 | v[pos+6] << 8 | v[pos+7];
+        if(pos + FRAME_HEADER_LEN + stored_len > v.size()){
+            throw std::runtime_error("compressed data is corrupted (frame is cut off)");
+        }
+        offsets.push_back(pos);
+        pos += FRAME_HEADER_LEN + stored_len;
+    }
+    return offsets;
+}
+
+static Bytes decodeFrame(const std::vector<unsigned char>& v, unsigned long pos){
+    //decodes the frame at pos (the frame bounds have been checked by getSegmentOffsets)
+    unsigned long plain_len = (unsigned long)v[pos] << 24 | v[pos+1] << 16 | v[pos+2] << 8 | v[pos+3];
+    unsigned long stored_len = (unsigned long)v[pos+4] << 24 | v[pos+5] << 16 | v[pos+6] << 8 | v[pos+7];
+    Bytes stored;
+    stored.setBytes(std::vector<unsigned char>(v.begin() + pos + Compression::FRAME_HEADER_LEN, v.begin() + pos + Compression::FRAME_HEADER_LEN + stored_len));
+    if(stored_len == plain_len){
+        return stored;      //segment was stored without compression
+    }
+    return Compression::decompressBlock(stored, plain_len);
+}
+
+Bytes Compression::decompressSegment(const Bytes data, unsigned long index){
+    std::vector<unsigned long> offsets = Compression::getSegmentOffsets(data);
+    if(index >= offsets.size()){
+        throw std::range_error("segment does not exist");
+    }
+    return decodeFrame(data.getBytes(), offsets[index]);
+}
+
+Bytes Compression::decompress(unsigned char const compression_mode, const Bytes data){
+    if(!Compression::isModeValid(compression_mode)){
+        throw std::invalid_argument("compression mode does not exist");
+    }
+    if(compression_mode == 0){
+        return data;
+    }
+    std::vector<unsigned char> v = data.getBytes();
+    std::vector<unsigned char> out;
+    for(unsigned long offset : Compression::getSegmentOffsets(data)){
+        std::vector<unsigned char> segment = decodeFrame(v, offset).getBytes();
+        out.insert(out.end(), segment.begin(), segment.end());
+    }
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
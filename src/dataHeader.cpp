@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <openssl/crypto.h>
 #include "dataHeader.h"
 
+static const std::string KEY_CHECK_PURPOSE = "check";
+
 DataHeader::DataHeader(unsigned char const hash_mode){
     this->hash_mode = hash_mode;
     if(!HashModes::isModeValid(hash_mode)){
@@ -11,48 +17,342 @@ DataHeader::DataHeader(unsigned char const hash_mode){
     Hash* hash = HashModes::getHash(hash_mode);
     this->hash_size = hash->getHashSize();
     delete hash;
+    this->cipher_mode = 0;
+    this->compression_mode = 0;
+    this->keyslots.push_back(KeySlot(hash_mode));
+}
+
+class HeaderCursor{
+    /*
+    reads the fields of the data header one after another from the buffer
+    every read is checked against the end of the buffer, nothing is copied
+    */
+private:
+    BytesView buf;
+    unsigned long pos;
+public:
+    HeaderCursor(const BytesView buf) noexcept{
+        this->buf = buf;
+        this->pos = 0;
+    }
+    BytesView read(unsigned long len){
+        if(len > this->buf.getLen() - this->pos){
+            throw std::length_error("data header is cut off");
+        }
+        BytesView ret = this->buf.slice(this->pos, len);
+        this->pos += len;
+        return ret;
+    }
+    unsigned char readByte(){
+        return this->read(1)[0];
+    }
+    unsigned long readLong(){
+        return toLong(this->read(8));
+    }
+    unsigned long getPos() const noexcept{
+        return this->pos;
+    }
+};
+
+class HeaderWriter{
+    /*
+    writes the fields of the data header one after another into the preallocated buffer
+    the buffer length has been checked before, so the writes are not checked again
+    */
+private:
+    unsigned char* buf;
+    unsigned long pos;
+public:
+    HeaderWriter(unsigned char* buf) noexcept{
+        this->buf = buf;
+        this->pos = 0;
+    }
+    void write(const Bytes& b) noexcept{
+        BytesView view = b.getView();
+        std::copy(view.data(), view.data() + view.getLen(), this->buf + this->pos);
+        this->pos += view.getLen();
+    }
+    void writeByte(unsigned char c) noexcept{
+        this->buf[this->pos++] = c;
+    }
+    void writeLong(unsigned long num) noexcept{
+        for(int i=7; i >= 0; i--){
+            this->buf[this->pos++] = (num >> (8*i)) & 0xFF;     //big endian like toLong
+        }
+    }
+};
+
+unsigned int DataHeader::readHeaderLength(const BytesView buf){
+    HeaderCursor cursor(buf);
+    unsigned char hash_mode = cursor.readByte();
+    if(!HashModes::isModeValid(hash_mode)){
+        throw std::invalid_argument("hash mode of the data header does not exist");
+    }
+    Hash* hash = HashModes::getHash(hash_mode);
+    unsigned int hash_size = hash->getHashSize();
+    delete hash;
+    cursor.read(2);     //cipher and compression mode
+    unsigned char slot_number = cursor.readByte();
+    for(unsigned char i=0; i < slot_number; i++){
+        //skip over the keyslot, only the datablock lengths are needed
+        cursor.read(9);
+        cursor.read(cursor.readByte());
+        cursor.read(9);
+        cursor.read(cursor.readByte());
+        cursor.read(hash_size + KeyWrap::getWrappedLen(hash_size));
+    }
+    cursor.read(hash_size);     //encrypted salt
+    cursor.read(KEY_CHECK_LEN);
+    return cursor.getPos();
+}
+
+void DataHeader::setHeaderBytes(Bytes headerBytes){
+    this->setHeaderBytes(headerBytes.getView());
+    if(this->header_bytes.getLen() != headerBytes.getLen()){
+        throw std::length_error("header bytes contain more bytes than the data header");
+    }
+}
+
+void DataHeader::setHeaderBytes(const BytesView buf){
+    //the fields are parsed into a new header first, so this header only changes if the whole header is valid
+    HeaderCursor cursor(buf);
+    if(cursor.readByte() != this->hash_mode){
+        throw std::invalid_argument("hash mode of the header bytes does not match with the hash mode of the data header");
+    }
+    DataHeader parsed(this->hash_mode);
+    parsed.setCipherMode(cursor.readByte());
+    parsed.setCompressionMode(cursor.readByte());
+    unsigned char slot_number = cursor.readByte();
+    if(slot_number == 0 || slot_number > MAX_KEYSLOTS){
+        throw std::length_error("number of keyslots in the data header is not valid");
+    }
+    parsed.keyslots.clear();
+    for(unsigned char i=0; i < slot_number; i++){
+        KeySlot keyslot(this->hash_mode);
+        unsigned char mode = cursor.readByte();
+        unsigned long iters = cursor.readLong();
+        unsigned char len = cursor.readByte();
+        keyslot.setChainHash1(mode, iters, len, cursor.read(len).toBytes());
+        mode = cursor.readByte();
+        iters = cursor.readLong();
+        len = cursor.readByte();
+        keyslot.setChainHash2(mode, iters, len, cursor.read(len).toBytes());
+        keyslot.setValidPasswordHashBytes(cursor.read(this->hash_size).toBytes());
+        keyslot.setWrappedDataKey(cursor.read(KeyWrap::getWrappedLen(this->hash_size)).toBytes());
+        parsed.keyslots.push_back(keyslot);
+    }
+    parsed.setEncryptedSalt(cursor.read(this->hash_size).toBytes());
+    parsed.key_check = cursor.read(KEY_CHECK_LEN).toBytes();
+    parsed.header_bytes = buf.slice(0, cursor.getPos()).toBytes();
+    *this = parsed;
+}
+
+Bytes DataHeader::getHeaderBytes() const{
+    if(this->header_bytes.getLen() > 0){
+        return this->header_bytes;      //header has not changed since it was parsed
+    }
+    std::vector<unsigned char> buf(this->getHeaderLength());
+    this->writeHeaderBytes(buf.data(), buf.size());
+    Bytes ret;
+    ret.setBytes(buf);
+    return ret;
+}
+
+void DataHeader::writeHeaderBytes(unsigned char* buf, unsigned long len) const{
+    if(!CipherModes::isModeValid(this->cipher_mode)){
+        throw std::logic_error("cipher mode is not set");
+    }
+    if(this->enc_salt.isEmpty()){
+        throw std::logic_error("encrypted salt is not set");
+    }
+    if(this->key_check.isEmpty()){
+        throw std::logic_error("key check value is not set");
+    }
+    for(const KeySlot& keyslot : this->keyslots){
+        if(!keyslot.isComplete()){
+            throw std::logic_error("keyslot is not complete");
+        }
+    }
+    if(len < this->getHeaderLength()){
+        throw std::length_error("buffer is too small for the data header");
+    }
+    HeaderWriter writer(buf);
+    writer.writeByte(this->hash_mode);
+    writer.writeByte(this->cipher_mode);
+    writer.writeByte(this->compression_mode);
+    writer.writeByte(this->keyslots.size());
+    for(const KeySlot& keyslot : this->keyslots){
+        writer.writeByte(keyslot.getChainHash1Mode());
+        writer.writeLong(keyslot.getChainHash1Iters());
+        writer.writeByte(keyslot.getChainHash1Datablock().getLen());
+        writer.write(keyslot.getChainHash1Datablock());
+        writer.writeByte(keyslot.getChainHash2Mode());
+        writer.writeLong(keyslot.getChainHash2Iters());
+        writer.writeByte(keyslot.getChainHash2Datablock().getLen());
+        writer.write(keyslot.getChainHash2Datablock());
+        writer.write(keyslot.getValidPasswordHash());
+        writer.write(keyslot.getWrappedDataKey());
+    }
+    writer.write(this->enc_salt);
+    writer.write(this->key_check);
 }
 
 unsigned int DataHeader::getHeaderLength() const noexcept{
     if(this->header_bytes.getLen() > 0){
         return this->header_bytes.getLen();     //header bytes are set, so we get this length
     }
-    if(this->chainhash1_mode != 0 && this->chainhash2_mode != 0){   //all data set to calculate the header length
-        return 21 + 2*this->hash_size + this->chainhash1_datablock_len + this->chainhash2_datablock_len;    //dataheader.md
-    }else{
-        return 0;   //not enough infos to get the header length
+    unsigned int len = 4 + this->hash_size + KEY_CHECK_LEN;     //modes, keyslot number, the encrypted salt and the key check value
+    for(const KeySlot& keyslot : this->keyslots){
+        if(keyslot.getChainHash1Mode() == 0 || keyslot.getChainHash2Mode() == 0){
+            return 0;   //not enough infos to get the header length
+        }
+        len += keyslot.getLength();
     }
+    return len;     //dataheader.md
 }
 
 void DataHeader::setChainHash1(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock){
-    if(len != datablock.getLen()){
-        throw std::invalid_argument("length of the datablock does not match with the given length");
+    this->getKeySlot(0).setChainHash1(mode, iters, len, datablock);
+}
+
+void DataHeader::setValidPasswordHashBytes(Bytes validBytes){
+    this->getKeySlot(0).setValidPasswordHashBytes(validBytes);
+}
+
+void DataHeader::setChainHash2(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock){
+    this->getKeySlot(0).setChainHash2(mode, iters, len, datablock);
+}
+
+void DataHeader::setEncryptedSalt(Bytes salt){
+    if(salt.getLen() != this->hash_size){
+        throw std::length_error("Length of the encrypted salt does not match with the hash size");
     }
-    if(!ChainHashModes::isChainHashValid(mode, iters, datablock)){
-        throw std::invalid_argument("given data is not valid");
+    this->enc_salt = salt;
+    this->header_bytes.clear();
+}
+
+Bytes DataHeader::getEncryptedSalt() const noexcept{
+    return this->enc_salt;
+}
+
+void DataHeader::setCipherMode(unsigned char mode){
+    if(!CipherModes::isModeValid(mode)){
+        throw std::invalid_argument("cipher mode does not exist");
     }
-    this->chainhash1_mode = mode;
-    this->chainhash1_datablock = datablock;
-    this->chainhash1_datablock_len = len;
-    this->chainhash1_iters = iters;
+    this->cipher_mode = mode;
+    this->header_bytes.clear();
 }
 
-void DataHeader::setValidPasswordHashBytes(Bytes validBytes){
-    if(validBytes.getLen() != this->hash_size){
-        throw std::length_error("Length of the given validBytes does not match with the hash size");
+unsigned char DataHeader::getCipherMode() const noexcept{
+    return this->cipher_mode;
+}
+
+void DataHeader::setCompressionMode(unsigned char mode){
+    if(!Compression::isModeValid(mode)){
+        throw std::invalid_argument("compression mode does not exist");
     }
-    this->valid_passwordhash = validBytes;
+    this->compression_mode = mode;
+    this->header_bytes.clear();
 }
 
-void DataHeader::setChainHash2(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock){
-    if(len != datablock.getLen()){
-        throw std::invalid_argument("length of the datablock does not match with the given length");
+unsigned char DataHeader::getCompressionMode() const noexcept{
+    return this->compression_mode;
+}
+
+void DataHeader::setWrappedDataKey(Bytes wrapped){
+    this->getKeySlot(0).setWrappedDataKey(wrapped);
+}
+
+Bytes DataHeader::getWrappedDataKey() const noexcept{
+    return this->keyslots[0].getWrappedDataKey();
+}
+
+unsigned char DataHeader::getHashMode() const noexcept{
+    return this->hash_mode;
+}
+
+unsigned char DataHeader::getHashSize() const noexcept{
+    return this->hash_size;
+}
+
+unsigned int DataHeader::getKeySlotNumber() const noexcept{
+    return this->keyslots.size();
+}
+
+KeySlot& DataHeader::getKeySlot(unsigned int index){
+    if(index >= this->keyslots.size()){
+        throw std::range_error("keyslot does not exist");
+    }
+    this->header_bytes.clear();     //the keyslot can be changed, so the header bytes are outdated
+    return this->keyslots[index];
+}
+
+void DataHeader::addKeySlot(KeySlot keyslot){
+    if(this->keyslots.size() >= MAX_KEYSLOTS){
+        throw std::length_error("maximum number of keyslots reached");
+    }
+    if(keyslot.getHashMode() != this->hash_mode){
+        throw std::invalid_argument("hash mode of the keyslot does not match with the hash mode of the header");
+    }
+    this->keyslots.push_back(keyslot);
+    this->header_bytes.clear();
+}
+
+void DataHeader::removeKeySlot(unsigned int index){
+    if(index >= this->keyslots.size()){
+        throw std::range_error("keyslot does not exist");
+    }
+    if(this->keyslots.size() == 1){
+        throw std::logic_error("the last keyslot cannot be removed");
     }
-    if(!ChainHashModes::isChainHashValid(mode, iters, datablock)){
-        throw std::invalid_argument("given data is not valid");
+    this->keyslots.erase(this->keyslots.begin() + index);
+    this->header_bytes.clear();
+}
+
+std::optional<Bytes> DataHeader::getDataKey(std::string password) const{
+    if(this->keyslots.size() == 1){
+        return this->keyslots[0].getDataKey(password);
+    }
+    //each keyslot performs its chainhashes on its own thread, the first matching keyslot stops the others
+    std::atomic<bool> found{false};
+    std::optional<Bytes> datakey;
+    std::mutex datakey_mutex;
+    std::vector<std::thread> workers;
+    for(const KeySlot& keyslot : this->keyslots){
+        if(!keyslot.isComplete()){
+            continue;
+        }
+        workers.emplace_back([&keyslot, &password, &found, &datakey, &datakey_mutex](){
+            std::optional<Bytes> key = keyslot.getDataKey(password, &found);
+            if(key.has_value()){
+                std::lock_guard<std::mutex> lock(datakey_mutex);
+                if(!datakey.has_value()){
+                    datakey = key;
+                }
+                found = true;
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    return datakey;
+}
+
+void DataHeader::setPassword(std::string password, Bytes datakey, unsigned int index){
+    //only the header changes, the data stays encrypted with the same data key
+    Bytes key_check = CipherModes::deriveKey(datakey, KEY_CHECK_PURPOSE);
+    if(!this->key_check.isEmpty() && !this->isDataKeyValid(datakey)){
+        throw std::invalid_argument("data key does not match with the data key of the header");
+    }
+    this->getKeySlot(index).setPassword(password, datakey);
+    this->key_check = key_check;
+}
+
+bool DataHeader::isDataKeyValid(const Bytes datakey) const{
+    if(this->key_check.isEmpty() || datakey.isEmpty()){
+        return false;
     }
-    this->chainhash2_mode = mode;
-    this->chainhash2_datablock = datablock;
-    this->chainhash2_datablock_len = len;
-    this->chainhash2_iters = iters;
+    Bytes key_check = CipherModes::deriveKey(datakey, KEY_CHECK_PURPOSE);
+    return CRYPTO_memcmp(key_check.getView().data(), this->key_check.getView().data(), KEY_CHECK_LEN) == 0;
 }
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <functional>
+#include "entry_index.h"
+
+static unsigned long getCapacityFor(unsigned long keys){
+    //smallest power of two that holds the keys with at most 70% load
+    unsigned long capacity = EntryIndex::MIN_CAPACITY;
+    while(capacity * 7 < keys * 10){
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+EntryIndex::EntryIndex(unsigned long expected){
+    this->size = 0;
+    this->removed = 0;
+    this->slots.resize(getCapacityFor(expected));
+}
+
+unsigned long EntryIndex::findSlot(const std::string& key) const noexcept{
+    unsigned long mask = this->slots.size() - 1;
+    for(unsigned long i = std::hash<std::string>()(key) & mask;; i = (i + 1) & mask){
+        //there is always a free slot (load <= 70%), so the probing ends
+        const Slot& slot = this->slots[i];
+        if(slot.state == 0){
+            return this->slots.size();
+        }
+        if(slot.state == 1 && slot.key == key){
+            return i;
+        }
+    }
+}
+
+void EntryIndex::rehash(unsigned long capacity){
+    std::vector<Slot> old(capacity);
+    old.swap(this->slots);
+    unsigned long mask = capacity - 1;
+    for(Slot& slot : old){
+        if(slot.state != 1){
+            continue;   //removed slots are dropped
+        }
+        unsigned long i = std::hash<std::string>()(slot.key) & mask;
+        while(this->slots[i].state != 0){
+            i = (i + 1) & mask;
+        }
+        this->slots[i] = std::move(slot);
+    }
+    this->removed = 0;
+}
+
+void EntryIndex::put(const std::string key, const std::string value){
+    unsigned long pos = this->findSlot(key);
+    if(pos != this->slots.size()){
+        //only the holders change, the sorted keys stay
+        std::vector<std::string>& values = this->slots[pos].values;
+        values.erase(std::remove(values.begin(), values.end(), value), values.end());
+        values.push_back(value);
+        return;
+    }
+    if((this->size + this->removed + 1) * 10 > this->slots.size() * 7){
+        //grows if the used slots need it, otherwise the removed slots are cleaned up
+        this->rehash(getCapacityFor(this->size + 1) > this->slots.size() ? this->slots.size() * 2 : this->slots.size());
+    }
+    unsigned long mask = this->slots.size() - 1;
+    unsigned long i = std::hash<std::string>()(key) & mask;
+    while(this->slots[i].state == 1){
+        i = (i + 1) & mask;
+    }
+    if(this->slots[i].state == 2){
+        this->removed--;    //a removed slot is used again
+    }
+    this->slots[i].key = key;
+    this->slots[i].values = {value};
+    this->slots[i].state = 1;
+    this->size++;
+    this->sorted.insert(key);
+}
+
+bool EntryIndex::remove(const std::string key){
+    unsigned long pos = this->findSlot(key);
+    if(pos == this->slots.size()){
+        return false;
+    }
+    this->slots[pos].state = 2;
+    this->slots[pos].key.clear();
+    this->slots[pos].values.clear();
+    this->size--;
+    this->removed++;
+    this->sorted.erase(key);
+    return true;
+}
+
+bool EntryIndex::remove(const std::string key, const std::string value){
+    unsigned long pos = this->findSlot(key);
+    if(pos == this->slots.size()){
+        return false;
+    }
+    std::vector<std::string>& values = this->slots[pos].values;
+    std::vector<std::string>::iterator it = std::find(values.begin(), values.end(), value);
+    if(it == values.end()){
+        return false;
+    }
+    if(values.size() == 1){
+        return this->remove(key);
+    }
+    values.erase(it);
+    return true;
+}
+
+std::optional<std::string> EntryIndex::find(const std::string key) const{
+    unsigned long pos = this->findSlot(key);
+    if(pos == this->slots.size()){
+        return {};
+    }
+    return this->slots[pos].values.back();
+}
+
+std::vector<std::pair<std::string, std::string>> EntryIndex::findPrefix(const std::string prefix, unsigned long limit) const{
+    std::vector<std::pair<std::string, std::string>> found;
+    for(std::set<std::string>::const_iterator it = this->sorted.lower_bound(prefix);
+            it != this->sorted.end() && found.size() < limit && it->compare(0, prefix.size(), prefix) == 0; it++){
+        found.emplace_back(*it, this->slots[this->findSlot(*it)].values.back());
+    }
+    return found;
+}
+
+unsigned long EntryIndex::getSize() const noexcept{
+    return this->size;
+}
+
+unsigned long EntryIndex::getCapacity() const noexcept{
+    return this->slots.size();
+}
+
+void EntryIndex::clear(){
+    for(Slot& slot : this->slots){
+        slot = Slot();
+    }
+    this->sorted.clear();
+    this->size = 0;
+    this->removed = 0;
+}
@@ -0,0 +1,114 @@
+#include <stdexcept>
+#include "entry_record.h"
+
+static const unsigned long VERSION_POS = 4;
+static const unsigned long CREATED_POS = 8;
+static const unsigned long MODIFIED_POS = 16;
+static const unsigned long OFFSETS_POS = 24;
+
+static void writeNumber(std::vector<unsigned char>& out, unsigned long pos, unsigned long num, int len){
+    //highest byte first (like fromLong)
+    for(int i = len-1; i >= 0; i--){
+        out[pos + i] = num & 0xFF;
+        num >>= 8;
+    }
+}
+
+EntryView::EntryView(const BytesView buffer){
+    //all offsets are checked once here, so the getters do not need checks
+    if(buffer.getLen() < HEADER_LEN){
+        throw std::length_error("entry record is cut off (header)");
+    }
+    unsigned long len = toLong(buffer.slice(0, 4));
+    if(len < HEADER_LEN || len > buffer.getLen()){
+        throw std::length_error("entry record is cut off or has an invalid length");
+    }
+    if(buffer[VERSION_POS] != VERSION){
+        throw std::runtime_error("entry record has an unknown version");
+    }
+    unsigned long last = HEADER_LEN;
+    for(unsigned char i=0; i <= FIELD_NUMBER; i++){
+        unsigned long offset = toLong(buffer.slice(OFFSETS_POS + 4*i, 4));
+        if(offset < last || offset > len || (i == 0 && offset != HEADER_LEN) || (i == FIELD_NUMBER && offset != len)){
+            throw std::runtime_error("entry record has invalid field offsets");
+        }
+        last = offset;
+    }
+    this->record = buffer.slice(0, len);
+}
+
+unsigned long EntryView::getLen() const noexcept{
+    return this->record.getLen();
+}
+
+BytesView EntryView::getField(unsigned char field) const{
+    if(field >= FIELD_NUMBER){
+        throw std::range_error("field does not exist");
+    }
+    unsigned long begin = toLong(BytesView(this->record.data() + OFFSETS_POS + 4*field, 4));
+    unsigned long end = toLong(BytesView(this->record.data() + OFFSETS_POS + 4*(field+1), 4));
+    return BytesView(this->record.data() + begin, end - begin);
+}
+
+std::string EntryView::getFieldString(unsigned char field) const{
+    BytesView view = this->getField(field);
+    return std::string(view.data(), view.data() + view.getLen());
+}
+
+unsigned long EntryView::getCreated() const noexcept{
+    return toLong(BytesView(this->record.data() + CREATED_POS, 8));
+}
+
+unsigned long EntryView::getModified() const noexcept{
+    return toLong(BytesView(this->record.data() + MODIFIED_POS, 8));
+}
+
+BytesView EntryView::getRecord() const noexcept{
+    return this->record;
+}
+
+Entry EntryView::toEntry() const{
+    Entry entry;
+    entry.title = this->getFieldString(FIELD_TITLE);
+    entry.username = this->getFieldString(FIELD_USERNAME);
+    entry.secret = this->getFieldString(FIELD_SECRET);
+    entry.url = this->getFieldString(FIELD_URL);
+    entry.notes = this->getFieldString(FIELD_NOTES);
+    entry.created = this->getCreated();
+    entry.modified = this->getModified();
+    return entry;
+}
+
+unsigned long EntryView::getEncodedLen(const Entry& entry) noexcept{
+    return HEADER_LEN + entry.title.size() + entry.username.size() + entry.secret.size() + entry.url.size() + entry.notes.size();
+}
+
+bool EntryView::isRecord(const BytesView value) noexcept{
+    try{
+        return EntryView(value).getLen() == value.getLen();
+    }catch(std::exception&){
+        return false;
+    }
+}
+
+Bytes EntryView::encode(const Entry& entry){
+    unsigned long len = EntryView::getEncodedLen(entry);
+    if(len > 0xFFFFFFFF){
+        throw std::length_error("entry is too long for one record");
+    }
+    std::vector<unsigned char> out(HEADER_LEN, 0);
+    out.reserve(len);
+    writeNumber(out, 0, len, 4);
+    out[VERSION_POS] = VERSION;
+    writeNumber(out, CREATED_POS, entry.created, 8);
+    writeNumber(out, MODIFIED_POS, entry.modified, 8);
+    const std::string* fields[FIELD_NUMBER] = {&entry.title, &entry.username, &entry.secret, &entry.url, &entry.notes};
+    for(unsigned char i=0; i < FIELD_NUMBER; i++){
+        writeNumber(out, OFFSETS_POS + 4*i, out.size(), 4);
+        out.insert(out.end(), fields[i]->begin(), fields[i]->end());
+    }
+    writeNumber(out, OFFSETS_POS + 4*FIELD_NUMBER, out.size(), 4);
+    Bytes ret;
+    ret.setBytes(out);
+    return ret;
+}
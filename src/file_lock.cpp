@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+#include "file_lock.h"
+
+static bool tryLock(int fd, bool exclusive){
+    //returns false if another lock holds the file, throws on other errors
+#if defined(_WIN32)
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED overlapped = {};
+    DWORD flags = LOCKFILE_FAIL_IMMEDIATELY | (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0);
+    if(LockFileEx(handle, flags, 0, MAXDWORD, MAXDWORD, &overlapped)){
+        return true;
+    }
+    if(GetLastError() == ERROR_LOCK_VIOLATION){
+        return false;
+    }
+    throw std::runtime_error("Cannot lock the file");
+#else
+    while(true){
+#if defined(F_OFD_SETLK)
+        struct flock fl;
+        std::memset(&fl, 0, sizeof(fl));
+        fl.l_type = exclusive ? F_WRLCK : F_RDLCK;
+        fl.l_whence = SEEK_SET;     //start 0 and length 0 lock the whole file
+        int ret = fcntl(fd, F_OFD_SETLK, &fl);
+#else
+        int ret = flock(fd, (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB);
+#endif
+        if(ret == 0){
+            return true;
+        }
+        if(errno == EINTR){
+            continue;
+        }
+        if(errno == EAGAIN || errno == EACCES || errno == EWOULDBLOCK){
+            return false;
+        }
+        throw std::runtime_error(std::string("Cannot lock the file: ") + std::strerror(errno));
+    }
+#endif
+}
+
+FileLock::FileLock(const std::filesystem::path file, bool exclusive, long timeout_ms){
+    this->exclusive = exclusive;
+    std::filesystem::path lock_path = FileLock::getLockPath(file);
+#if defined(_WIN32)
+    this->fd = _wopen(lock_path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    this->fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+#endif
+    if(this->fd < 0){
+        throw std::runtime_error("Cannot open the lock file " + lock_path.string() + ": " + std::strerror(errno));
+    }
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0L, timeout_ms));
+    std::chrono::milliseconds wait(1);
+    try{
+        //the lock is tried again with a growing pause (up to 50 ms), so a waiting process can give up after the timeout
+        while(!tryLock(this->fd, exclusive)){
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if(timeout_ms != WAIT_FOREVER && now >= deadline){
+                throw std::runtime_error("timeout while waiting for the lock of " + file.string());
+            }
+            std::this_thread::sleep_for(timeout_ms == WAIT_FOREVER ? wait : std::min<std::chrono::steady_clock::duration>(wait, deadline - now));
+            wait = std::min(wait * 2, std::chrono::milliseconds(50));
+        }
+    }catch(...){
+        close(this->fd);
+        throw;
+    }
+}
+
+FileLock::FileLock(FileLock&& other) noexcept{
+    this->fd = other.fd;
+    this->exclusive = other.exclusive;
+    other.fd = -1;
+}
+
+FileLock& FileLock::operator=(FileLock&& other) noexcept{
+    if(this != &other){
+        if(this->fd >= 0){
+            close(this->fd);
+        }
+        this->fd = other.fd;
+        this->exclusive = other.exclusive;
+        other.fd = -1;
+    }
+    return *this;
+}
+
+FileLock::~FileLock(){
+    if(this->fd >= 0){
+        close(this->fd);    //closing the last descriptor of the lock file releases the lock
+    }
+}
+
+bool FileLock::isExclusive() const noexcept{
+    return this->exclusive;
+}
+
+std::filesystem::path FileLock::getLockPath(const std::filesystem::path file){
+    std::filesystem::path lock_path = file;
+    lock_path += ".lock";
+    return lock_path;
+}
+
+FileStamp FileLock::getStamp(const std::filesystem::path file){
+    FileStamp stamp;
+#if defined(_WIN32)
+    std::error_code ec;
+    stamp.size = std::filesystem::file_size(file, ec);
+    if(ec){
+        return FileStamp();
+    }
+    stamp.mtime = std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+#else
+    struct stat st;
+    if(stat(file.c_str(), &st) != 0){
+        return stamp;
+    }
+    stamp.dev = st.st_dev;
+    stamp.ino = st.st_ino;
+    stamp.size = st.st_size;
+#if defined(__APPLE__)
+    stamp.mtime = (long long)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtime = (long long)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return stamp;
+}
@@ -2,21 +2,33 @@
 
 const std::string FileHandler::extension = ".enc";
 
-FileHandler::FileHandler(){
-    this->createAppDataDir();
-    if(!this->isAppDataFile()){
-        this->createAppDataFile();
-    }
-    this->encryption_filepath = "";
-    std::optional<std::string> encryption_filepath = getAppSetting("filePath");
-    if(encryption_filepath.has_value()){
-        if(!std::filesystem::exists(encryption_filepath.value())){
-            this->removeAppSetting("filePath");
-        }else{
-            this->encryption_filepath = encryption_filepath.value();
+static std::optional<std::unordered_map<std::string, std::string>> readSettings(const std::filesystem::path path){
+    //reads the settings of the app data file (nothing if the file is not in the right format, an empty map if there is no file)
+    std::unordered_map<std::string, std::string> settings;
+    std::ifstream file(path.c_str());
+    std::string line;
+    while (std::getline(file, line)){
+        std::istringstream iss(line);
+        std::string setting, value;
+        if (!(iss >> setting) || !std::getline(iss >> std::ws, value) || value.empty()){
+            return {};
         }
+        settings[setting] = value;
     }
+    return settings;
+}
 
+FileHandler::FileHandler(){
+    //only the location of the app data is read here, the settings are loaded when they are needed first
+    //and the app data dir is created when the settings are written first
+    this->getAppDataDir();
+    this->app_settings_loaded = false;
+    this->app_settings_valid = true;
+    this->encryption_filepath = "";
+}
+
+FileHandler::~FileHandler(){
+    this->flushAppSettings();
 }
 
 void FileHandler::getAppDataDir(){
@@ -63,13 +75,6 @@ void FileHandler::createAppDataDir(){
     }
 }
 
-void FileHandler::createAppDataFile(){
-    std::filesystem::path appdatapath = this->getAppDataFilePath();
-    if(!std::filesystem::exists(appdatapath)){
-        std::ofstream(appdatapath.c_str());
-    }
-}
-
 std::filesystem::path FileHandler::getAppDataFilePath() const noexcept{
     return std::filesystem::path(this->appDataDir) / std::filesystem::path(this->appDataName);
 }
@@ -78,146 +83,157 @@ void FileHandler::resetAppData() const noexcept{
     //WORK
 }
 
-bool FileHandler::removeAppSetting(std::string setting_name) const{
+void FileHandler::loadAppSettings(){
+    if(this->app_settings_loaded){
+        return;     //the file is only read once
+    }
+    this->app_settings_loaded = true;
     if(!this->isAppDataFile()){
-        throw std::runtime_error("App data file not found");
+        return;     //no app data file yet (it is created with the first setting)
     }
-    std::fstream file(this->getAppDataFilePath().c_str());
-    std::stringstream file_content;     //stores the data of the file
-    std::string line;
-    while (std::getline(file, line)){
-        std::istringstream iss(line);
-        std::string setting, value;
-        if (!(iss >> setting >> value)){
-            std::cout << "The AppDataFile is not in the right format" << std::endl; // error occured, not in right format
-            std::cout << "Do you wanna reset the appData (y/n): ";
-            std::string tmp;
-            std::cin >> tmp;
-            if(tmp == "y"){
-                this->resetAppData();
+    std::optional<std::unordered_map<std::string, std::string>> settings;
+    {
+        FileLock lock(this->getAppDataFilePath(), false);      //a flush of another process is not read half
+        settings = readSettings(this->getAppDataFilePath());
+    }
+    if(!settings.has_value()){
+        this->app_settings_valid = false;   //the interactive app asks if it should be reset (isAppDataValid), the other commands ignore it
+        return;
+    }
+    this->app_settings = settings.value();
+}
+
+bool FileHandler::flushAppSettings(){
+    if(this->app_settings_changed.empty()){
+        return true;    //nothing changed since the last write
+    }
+    this->createAppDataDir();
+    try{
+        //other processes can have written settings since they were loaded, so only the changed settings are merged into the current file
+        FileLock lock(this->getAppDataFilePath(), true);
+        std::unordered_map<std::string, std::string> merged = readSettings(this->getAppDataFilePath()).value_or(std::unordered_map<std::string, std::string>());
+        for(const std::string& name : this->app_settings_changed){
+            std::unordered_map<std::string, std::string>::const_iterator it = this->app_settings.find(name);
+            if(it == this->app_settings.end()){
+                merged.erase(name);
+            }else{
+                merged[name] = it->second;
             }
-            return false;
-        } 
-        std::cout << setting << "|" << value << std::endl;  //DEBUGONLY
-        if(!(setting == setting_name)){
-            //a setting found that is not equal to the setting that should be deleted (we will save it)
-            file_content << line << std::endl;
         }
+        std::stringstream file_content;     //stores the new data of the file
+        for(const std::pair<const std::string, std::string>& setting : merged){
+            file_content << setting.first << " " << setting.second << std::endl;
+        }
+        AtomicWriter::writeFile(this->getAppDataFilePath(), file_content.str());    //all changes are written at once (a crash leaves the old file)
+        this->app_settings = merged;
+    }catch(std::runtime_error&){
+        return false;   //the old file is still there
     }
-    std::ofstream write_file;
-    write_file.open(this->getAppDataFilePath().c_str(), std::ofstream::out | std::ofstream::trunc);
-    write_file << file_content.str();       //writes the file again with the read content without the deleted setting
+    this->app_settings_changed.clear();
     return true;
 }
 
-std::optional<std::string> FileHandler::getAppSetting(std::string setting_name) const{
-    if(!this->isAppDataFile()){
-        throw std::runtime_error("App data file not found");
+bool FileHandler::removeAppSetting(std::string setting_name){
+    this->loadAppSettings();
+    if(this->app_settings.erase(setting_name) > 0){
+        this->app_settings_changed.insert(setting_name);
     }
-    std::fstream file(this->getAppDataFilePath().c_str());
-    std::string line;
-    while (std::getline(file, line)){
-        std::istringstream iss(line);
-        std::string setting, value;
-        if (!(iss >> setting >> value)){
-            std::cout << "The AppDataFile is not in the right format" << std::endl; // error occured, not in right format
-            std::cout << "Do you wanna reset the appData (y/n): ";
-            std::string tmp;
-            std::cin >> tmp;
-            if(tmp == "y"){
-                this->resetAppData();
-            }
-            return{};
-        } 
-        std::cout << setting << "|" << value << std::endl;  //DEBUGONLY
-        if(setting == setting_name){
-            //setting is set in the appdata, return the value
-            return value;
-        }
+    return true;
+}
+
+std::optional<std::string> FileHandler::getAppSetting(std::string setting_name){
+    this->loadAppSettings();
+    std::unordered_map<std::string, std::string>::const_iterator it = this->app_settings.find(setting_name);
+    if(it == this->app_settings.end()){
+        return{};
     }
-    return{};
+    return it->second;
 }
 
 bool FileHandler::isAppDataFile() const noexcept{
     return std::filesystem::exists(this->getAppDataFilePath().c_str());
 }
 
-bool FileHandler::setAppSetting(std::string setting_name, std::string setting_value) const{
+bool FileHandler::setAppSetting(std::string setting_name, std::string setting_value){
     /*
     APP SETTINGS
     filePath -> Path to the current encryption file
     */
-    if(!this->isAppDataFile()){
-        throw std::runtime_error("App data file not found");
+    this->loadAppSettings();
+    std::string& value = this->app_settings[setting_name];
+    if(value != setting_value){
+        value = setting_value;
+        this->app_settings_changed.insert(setting_name);    //written back with flushAppSettings
     }
-    std::fstream file(this->getAppDataFilePath().c_str());
-    std::stringstream file_content;     //stores the data of the file
-    std::string line;
-    int line_number = -1;
-    while (std::getline(file, line)){
-        line_number++;
-        std::istringstream iss(line);
-        std::string setting, value;
-        if (!(iss >> setting >> value)){
-            std::cout << "The AppDataFile is not in the right format" << std::endl; // error occured, not in right format
-            std::cout << "Do you wanna reset the appData (y/n): ";
-            std::string tmp;
-            std::cin >> tmp;
-            if(tmp == "y"){
-                this->resetAppData();
-            }
-            return false;
-        } 
-        std::cout << setting << "|" << value << std::endl;  //DEBUGONLY
-        if(!(setting == setting_name)){
-            //setting was not set previously, we have to save it, delete if it is the setting we wanna change
-            file_content << line << std::endl;
-        }
-    }
-    //add the new setting to the file content stream
-    file_content << setting_name << " " << setting_value << std::endl;
-
-    std::ofstream write_file;
-    write_file.open(this->getAppDataFilePath().c_str(), std::ofstream::out | std::ofstream::trunc);
-    write_file << file_content.str();       //writes the file again with the read content and the added setting
     return true;
 }
 
+bool FileHandler::isAppDataValid() noexcept{
+    try{
+        this->loadAppSettings();
+    }catch(std::exception&){
+        return true;    //the file could not be read (e.g. the lock timed out), so nothing is known about its format
+    }
+    return this->app_settings_valid;
+}
+
 bool FileHandler::setEncryptionFilePath(std::string path) noexcept{
-    std::filesystem::path fp{path};
-    bool exist = std::filesystem::exists(fp);
+    std::error_code error;
+    bool exist = std::filesystem::exists(std::filesystem::path(path), error);
     if(exist){
-        this->setAppSetting("filePath", path);
         this->encryption_filepath = path;
+        try{
+            this->setAppSetting("filePath", path);
+        }catch(std::exception&){
+            //the app data could not be read, the path is used but not saved
+        }
     }
     return exist;
 }
 
-std::string FileHandler::getEncryptionFilePath() const noexcept{
+std::string FileHandler::getEncryptionFilePath() noexcept{
+    if(this->encryption_filepath.empty()){
+        //the path is read from the settings when it is needed first (the caller checks if the file still exists)
+        try{
+            std::optional<std::string> encryption_filepath = this->getAppSetting("filePath");
+            if(encryption_filepath.has_value()){
+                this->encryption_filepath = encryption_filepath.value();
+            }
+        }catch(std::exception&){
+            return "";      //the app data could not be read (e.g. the lock timed out), so the path is not set
+        }
+    }
     return this->encryption_filepath;
 }
 
 Bytes FileHandler::getFirstBytes(int num) const{
+    FileLock lock = this->lockEncryptionFile(false);
+    MappedVault vault = this->mapEncryptionFile();
+    if(num < 0 || vault.getLen() < (unsigned long)num){
+        //not enough characters to read
+        throw std::length_error("File contains to few characters");
+    }
+    return vault.getView().slice(0, num).toBytes();
+}
+
+FileLock FileHandler::lockEncryptionFile(bool exclusive) const{
     if(this->encryption_filepath.empty()){
         throw std::runtime_error("Encrypted filepath is empty");
     }
-    std::ifstream file(this->encryption_filepath.c_str()); 
-    if(!file){
-        throw std::runtime_error("Encrypted file not found in filepath");
-    }
-    // get length of file:
-    file.seekg (0, file.end);
-    int length = file.tellg();
-    file.seekg (0, file.beg);
-    if(length < num){
-        //not enough characters to read
-        throw std::length_error("File contains to few characters");
+    return FileLock(this->encryption_filepath, exclusive);
+}
+
+MappedVault FileHandler::mapEncryptionFile() const{
+    if(this->encryption_filepath.empty()){
+        throw std::runtime_error("Encrypted filepath is empty");
     }
-    char buf[num];
-    file.read(buf, num);
-    Bytes ret = Bytes();
-    for(char c : buf){
-        ret.addByte(static_cast<unsigned char>(c));
+    return MappedVault(this->encryption_filepath);
+}
+
+SaveReport FileHandler::writeEncryptionFile(const std::vector<BytesView> parts) const{
+    if(this->encryption_filepath.empty()){
+        throw std::runtime_error("Encrypted filepath is empty");
     }
-    return ret;
-}
\ No newline at end of file
+    FileLock lock(this->encryption_filepath, true);    //only held for the write
+    return AtomicWriter::writeFile(this->encryption_filepath, parts);
+}
@@ -0,0 +1,541 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "importer.h"
+#include "bounded_queue.h"
+#include "settings.h"
+
+//column names of the csv exports (bitwarden, lastpass, keepass, chrome, firefox, 1password), compared in lower case
+static const std::vector<std::string> TITLE_KEYS = {"name", "title"};
+static const std::vector<std::string> USERNAME_KEYS = {"username", "login_username", "user", "login"};
+static const std::vector<std::string> SECRET_KEYS = {"password", "login_password", "secret"};
+static const std::vector<std::string> URL_KEYS = {"url", "login_uri", "uri", "website"};
+static const std::vector<std::string> NOTES_KEYS = {"notes", "extra", "note", "comments"};
+
+static std::string toLower(std::string text){
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c){return std::tolower(c);});
+    return text;
+}
+
+static std::string getEntryName(const Entry& entry){
+    //a name is one line of a batch answer (list), so control characters become spaces and the ends are trimmed
+    for(const std::string* field : {&entry.title, &entry.url, &entry.username}){
+        std::string name = *field;
+        std::replace_if(name.begin(), name.end(), [](unsigned char c){return c < 0x20 || c == 0x7F;}, ' ');
+        unsigned long begin = name.find_first_not_of(' ');
+        if(begin != std::string::npos){
+            return name.substr(begin, name.find_last_not_of(' ') - begin + 1);
+        }
+    }
+    return "imported";
+}
+
+static bool isSameEntry(const Entry& entry, const std::optional<Bytes>& value){
+    //the fields are compared, the timestamps are set by each import
+    if(!value.has_value() || !EntryView::isRecord(value->getView())){
+        return false;
+    }
+    Entry stored = EntryView(value->getView()).toEntry();
+    return stored.title == entry.title && stored.username == entry.username && stored.secret == entry.secret && stored.url == entry.url && stored.notes == entry.notes;
+}
+
+static Entry newEntry(){
+    Entry entry;
+    entry.created = std::time(nullptr);
+    entry.modified = entry.created;
+    return entry;
+}
+
+std::optional<unsigned char> Importer::getFormat(const std::string name) noexcept{
+    std::string lower = toLower(name);
+    if(lower == "csv" || (lower.size() > 4 && lower.compare(lower.size() - 4, 4, ".csv") == 0)){
+        return FORMAT_CSV;
+    }
+    if(lower == "json" || (lower.size() > 5 && lower.compare(lower.size() - 5, 5, ".json") == 0)){
+        return FORMAT_JSON;
+    }
+    return {};
+}
+
+static bool readCsvRow(std::streambuf* buf, std::vector<std::string>& fields, unsigned long& line){
+    //reads one row (rfc 4180: quoted fields can contain commas, quotes as "" and line breaks), returns false at the end of the stream
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+    bool any = false;
+    for(int c = buf->sbumpc(); c != EOF; c = buf->sbumpc()){
+        any = true;
+        if(quoted){
+            if(c == '"'){
+                if(buf->sgetc() == '"'){
+                    field += '"';
+                    buf->sbumpc();
+                }else{
+                    quoted = false;
+                }
+            }else{
+                line += c == '\n';
+                field += (char)c;
+            }
+        }else if(c == '"'){
+            quoted = true;
+        }else if(c == ','){
+            fields.push_back(field);
+            field.clear();
+        }else if(c == '\n'){
+            line++;
+            fields.push_back(field);
+            return true;
+        }else if(c != '\r'){
+            field += (char)c;
+        }
+    }
+    if(quoted){
+        throw std::runtime_error("csv is corrupted (quote is not closed in line " + std::to_string(line) + ")");
+    }
+    if(any){
+        fields.push_back(field);    //last row without a line break
+    }
+    return any;
+}
+
+static long findColumn(const std::vector<std::string>& columns, const std::vector<std::string>& keys){
+    for(const std::string& key : keys){
+        std::vector<std::string>::const_iterator it = std::find(columns.begin(), columns.end(), key);
+        if(it != columns.end()){
+            return it - columns.begin();
+        }
+    }
+    return -1;
+}
+
+void Importer::parseCsv(std::istream& in, const std::function<bool(Entry)> onEntry){
+    std::streambuf* buf = in.rdbuf();
+    if(buf->sgetc() == 0xEF){
+        //utf-8 byte order mark
+        buf->sbumpc();
+        buf->sbumpc();
+        buf->sbumpc();
+    }
+    unsigned long line = 1;
+    std::vector<std::string> columns;
+    if(!readCsvRow(buf, columns, line)){
+        throw std::runtime_error("csv is empty (no header row)");
+    }
+    for(std::string& column : columns){
+        column.erase(0, column.find_first_not_of(" \t"));
+        column.erase(column.find_last_not_of(" \t") + 1);
+        column = toLower(column);
+    }
+    long title = findColumn(columns, TITLE_KEYS);
+    long username = findColumn(columns, USERNAME_KEYS);
+    long secret = findColumn(columns, SECRET_KEYS);
+    long url = findColumn(columns, URL_KEYS);
+    long notes = findColumn(columns, NOTES_KEYS);
+    if(title < 0 && url < 0){
+        throw std::runtime_error("csv header has no name, title or url column");
+    }
+    std::vector<std::string> fields;
+    while(readCsvRow(buf, fields, line)){
+        if(fields.size() == 1 && fields[0].empty()){
+            continue;   //empty line
+        }
+        auto get = [&fields](long column){return column >= 0 && column < (long)fields.size() ? fields[column] : std::string();};
+        Entry entry = newEntry();
+        entry.title = get(title);
+        entry.username = get(username);
+        entry.secret = get(secret);
+        entry.url = get(url);
+        entry.notes = get(notes);
+        if(!onEntry(std::move(entry))){
+            return;
+        }
+    }
+}
+
+struct JsonValue{
+    /*
+    a parsed json value (only the values of one item are held at a time)
+    numbers, true, false and null are kept as their text
+    */
+    bool is_string = false;
+    bool is_object = false;
+    bool is_array = false;
+    std::string text;                   //string or the text of a number or literal
+    std::vector<std::string> keys;      //keys of an object
+    std::vector<JsonValue> values;      //values of an object (same order as the keys) or the elements of an array
+
+    const JsonValue* find(const std::string key) const{
+        for(unsigned long i=0; i < this->keys.size(); i++){
+            if(toLower(this->keys[i]) == key){
+                return &this->values[i];
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader{
+    /*
+    reads json from a stream character by character (rfc 8259)
+    */
+private:
+    std::streambuf* buf;
+    unsigned long line;
+
+public:
+    JsonReader(std::istream& in) : buf(in.rdbuf()), line(1){}
+
+    [[noreturn]] void fail(const std::string what) const{
+        throw std::runtime_error("json is corrupted (" + what + " in line " + std::to_string(this->line) + ")");
+    }
+
+    int peek(){     //next character that is not white space (EOF at the end)
+        int c = this->buf->sgetc();
+        while(c == ' ' || c == '\t' || c == '\r' || c == '\n'){
+            this->line += c == '\n';
+            this->buf->sbumpc();
+            c = this->buf->sgetc();
+        }
+        return c;
+    }
+
+    void expect(char expected){
+        if(this->peek() != expected){
+            this->fail(std::string("expected ") + expected);
+        }
+        this->buf->sbumpc();
+    }
+
+    bool next(char separator, char end){    //skips the separator, returns false behind the end of the object or array
+        int c = this->peek();
+        this->buf->sbumpc();
+        if(c == separator){
+            return true;
+        }
+        if(c != end){
+            this->fail(std::string("expected ") + separator + " or " + end);
+        }
+        return false;
+    }
+
+    unsigned long readHex(){
+        unsigned long code = 0;
+        for(int i=0; i < 4; i++){
+            int c = this->buf->sbumpc();
+            if(!std::isxdigit(c)){
+                this->fail("invalid unicode escape");
+            }
+            code = code*16 + (std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
+        }
+        return code;
+    }
+
+    std::string readString(){
+        this->expect('"');
+        std::string text;
+        for(int c = this->buf->sbumpc(); c != '"'; c = this->buf->sbumpc()){
+            if(c == EOF || c == '\n'){
+                this->fail("string is not closed");
+            }
+            if(c != '\\'){
+                text += (char)c;
+                continue;
+            }
+            c = this->buf->sbumpc();
+            switch(c){
+                case '"': case '\\': case '/': text += (char)c; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+                case 'u':{
+                    unsigned long code = this->readHex();
+                    if(code >= 0xD800 && code < 0xDC00){
+                        //high surrogate, the low surrogate follows
+                        if(this->buf->sbumpc() != '\\' || this->buf->sbumpc() != 'u'){
+                            this->fail("surrogate pair is not complete");
+                        }
+                        unsigned long low = this->readHex();
+                        if(low < 0xDC00 || low >= 0xE000){
+                            this->fail("invalid surrogate pair");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    //utf-8
+                    if(code < 0x80){
+                        text += (char)code;
+                    }else if(code < 0x800){
+                        text += (char)(0xC0 | (code >> 6));
+                        text += (char)(0x80 | (code & 0x3F));
+                    }else if(code < 0x10000){
+                        text += (char)(0xE0 | (code >> 12));
+                        text += (char)(0x80 | ((code >> 6) & 0x3F));
+                        text += (char)(0x80 | (code & 0x3F));
+                    }else{
+                        text += (char)(0xF0 | (code >> 18));
+                        text += (char)(0x80 | ((code >> 12) & 0x3F));
+                        text += (char)(0x80 | ((code >> 6) & 0x3F));
+                        text += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: this->fail("invalid escape");
+            }
+        }
+        return text;
+    }
+
+    JsonValue readValue(unsigned int depth){
+        if(depth > Importer::MAX_JSON_DEPTH){
+            this->fail("nested too deep");
+        }
+        JsonValue value;
+        int c = this->peek();
+        if(c == '"'){
+            value.is_string = true;
+            value.text = this->readString();
+        }else if(c == '{'){
+            value.is_object = true;
+            this->buf->sbumpc();
+            if(this->peek() == '}'){
+                this->buf->sbumpc();
+                return value;
+            }
+            do{
+                value.keys.push_back(this->readString());
+                this->expect(':');
+                value.values.push_back(this->readValue(depth + 1));
+            }while(this->next(',', '}'));
+        }else if(c == '['){
+            value.is_array = true;
+            this->buf->sbumpc();
+            if(this->peek() == ']'){
+                this->buf->sbumpc();
+                return value;
+            }
+            do{
+                value.values.push_back(this->readValue(depth + 1));
+            }while(this->next(',', ']'));
+        }else{
+            //number, true, false or null
+            for(c = this->buf->sgetc(); c != EOF && (std::isalnum(c) || c == '-' || c == '+' || c == '.'); c = this->buf->sgetc()){
+                value.text += (char)this->buf->sbumpc();
+            }
+            if(value.text.empty()){
+                this->fail(c == EOF ? "unexpected end" : "unexpected character");
+            }
+        }
+        return value;
+    }
+};
+
+static std::string getJsonText(const JsonValue* object, const std::vector<std::string>& keys){
+    if(object == nullptr || !object->is_object){
+        return "";
+    }
+    for(const std::string& key : keys){
+        const JsonValue* value = object->find(key);
+        if(value != nullptr && !value->is_object && !value->is_array && value->text != "null"){
+            return value->text;
+        }
+    }
+    return "";
+}
+
+static Entry toEntry(const JsonValue& item){
+    //flat items (username, password, url) and bitwarden items (login object with username, password and uris)
+    Entry entry = newEntry();
+    const JsonValue* login = item.find("login");
+    entry.title = getJsonText(&item, TITLE_KEYS);
+    entry.notes = getJsonText(&item, NOTES_KEYS);
+    entry.username = getJsonText(login, USERNAME_KEYS);
+    entry.username = entry.username.empty() ? getJsonText(&item, USERNAME_KEYS) : entry.username;
+    entry.secret = getJsonText(login, SECRET_KEYS);
+    entry.secret = entry.secret.empty() ? getJsonText(&item, SECRET_KEYS) : entry.secret;
+    const JsonValue* uris = login != nullptr && login->is_object ? login->find("uris") : nullptr;
+    if(uris != nullptr && uris->is_array && !uris->values.empty()){
+        entry.url = getJsonText(&uris->values[0], {"uri", "url"});
+    }
+    entry.url = entry.url.empty() ? getJsonText(login, URL_KEYS) : entry.url;
+    entry.url = entry.url.empty() ? getJsonText(&item, URL_KEYS) : entry.url;
+    return entry;
+}
+
+static bool readJsonItems(JsonReader& reader, const std::function<bool(Entry)> onEntry){
+    //reads the array of items one item at a time, returns false if onEntry stopped the import
+    reader.expect('[');
+    if(reader.peek() == ']'){
+        reader.next(',', ']');
+        return true;
+    }
+    do{
+        if(reader.peek() != '{'){
+            reader.fail("item is not an object");
+        }
+        if(!onEntry(toEntry(reader.readValue(1)))){
+            return false;
+        }
+    }while(reader.next(',', ']'));
+    return true;
+}
+
+void Importer::parseJson(std::istream& in, const std::function<bool(Entry)> onEntry){
+    JsonReader reader(in);
+    int c = reader.peek();
+    if(c == '['){
+        if(!readJsonItems(reader, onEntry)){
+            return;
+        }
+    }else if(c == '{'){
+        //export object: the items array is streamed, the other members (folders, collections) are skipped
+        reader.expect('{');
+        bool found = false;
+        if(reader.peek() != '}'){
+            do{
+                std::string key = toLower(reader.readString());
+                reader.expect(':');
+                if(!found && (key == "items" || key == "entries") && reader.peek() == '['){
+                    found = true;
+                    if(!readJsonItems(reader, onEntry)){
+                        return;
+                    }
+                }else{
+                    reader.readValue(1);
+                }
+            }while(reader.next(',', '}'));
+        }else{
+            reader.expect('}');
+        }
+        if(!found){
+            throw std::runtime_error("json export has no items array");
+        }
+    }else{
+        reader.fail("expected an array or an object");
+    }
+    if(reader.peek() != EOF){
+        reader.fail("data behind the export");
+    }
+}
+
+ImportReport Importer::run(std::istream& in, unsigned char format, EntryStore& store, unsigned int threads){
+    if(format != FORMAT_CSV && format != FORMAT_JSON){
+        throw std::invalid_argument("import format does not exist");
+    }
+    auto start = std::chrono::steady_clock::now();
+    ImportReport report;
+    report.threads = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+    std::vector<std::string> names = store.getNames();
+    std::set<std::string> used(names.begin(), names.end());
+    std::set<std::string> existing = used;      //records from before the import that an item can match
+
+    BoundedQueue<std::pair<std::string, Entry>> parsed(IMPORT_QUEUE_LEN);
+    BoundedQueue<std::pair<std::string, Bytes>> encoded(IMPORT_QUEUE_LEN);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::atomic<bool> failed{false};
+    auto fail = [&](){
+        //the first error stops all stages
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if(!error){
+                error = std::current_exception();
+            }
+        }
+        failed = true;
+        parsed.close();
+        encoded.close();
+    };
+
+    //stage 1: parses the export and gives each entry an unused name
+    //an entry that is stored already under its name or a suffix of it is skipped, so an import that failed can be run again
+    std::thread parser([&](){
+        try{
+            std::function<bool(Entry)> onEntry = [&](Entry entry){
+                std::string base = getEntryName(entry);
+                std::string name = base;
+                for(unsigned long number = 2; used.count(name) != 0; number++){
+                    if(existing.count(name) != 0 && isSameEntry(entry, store.get(name))){
+                        existing.erase(name);   //a record matches only one item (an export can have the same item twice)
+                        report.skipped++;
+                        return true;
+                    }
+                    name = base + " (" + std::to_string(number) + ")";
+                }
+                if(name != base){
+                    report.renamed++;
+                }
+                used.insert(name);
+                return parsed.push({name, std::move(entry)});
+            };
+            if(format == FORMAT_CSV){
+                Importer::parseCsv(in, onEntry);
+            }else{
+                Importer::parseJson(in, onEntry);
+            }
+        }catch(...){
+            fail();
+        }
+        parsed.close();
+    });
+    //stage 2: encodes the entries as records
+    std::atomic<unsigned int> encoding{report.threads};
+    std::vector<std::thread> encoders;
+    for(unsigned int t=0; t < report.threads; t++){
+        encoders.emplace_back([&](){
+            try{
+                for(std::optional<std::pair<std::string, Entry>> item = parsed.pop(); item.has_value(); item = parsed.pop()){
+                    if(!encoded.push({item->first, EntryView::encode(item->second)})){
+                        break;
+                    }
+                }
+            }catch(...){
+                fail();
+            }
+            if(--encoding == 0){
+                encoded.close();    //the last encoder ends the writer
+            }
+        });
+    }
+    //stage 3: writes batches into the store
+    std::vector<std::pair<std::string, Bytes>> batch;
+    auto write = [&](){
+        if(!failed){
+            store.putAll(batch);
+            report.entries += batch.size();
+            report.batches++;
+        }
+        batch.clear();
+    };
+    try{
+        for(std::optional<std::pair<std::string, Bytes>> item = encoded.pop(); item.has_value(); item = encoded.pop()){
+            report.bytes += item->second.getLen();
+            batch.push_back(std::move(item.value()));
+            if(batch.size() >= IMPORT_BATCH_LEN){
+                write();
+            }
+        }
+        if(!batch.empty()){
+            write();
+        }
+    }catch(...){
+        fail();
+    }
+    parser.join();
+    for(std::thread& encoder : encoders){
+        encoder.join();
+    }
+    if(error){
+        std::rethrow_exception(error);  //the batches that were written stay in the store (a second run skips them)
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,146 @@
+#include <openssl/crypto.h>
+#include "keyslot.h"
+
+KeySlot::KeySlot(unsigned char const hash_mode){
+    if(!HashModes::isModeValid(hash_mode)){
+        throw std::invalid_argument("hash mode does not exist");
+    }
+    Hash* hash = HashModes::getHash(hash_mode);
+    this->hash_mode = hash_mode;
+    this->hash_size = hash->getHashSize();
+    delete hash;
+    this->chainhash1_mode = 0;
+    this->chainhash2_mode = 0;
+    this->chainhash1_iters = 0;
+    this->chainhash2_iters = 0;
+}
+
+unsigned int KeySlot::getLength() const{
+    //two chainhashes (mode, iterations, datablock length, datablock), the valid passwordhash and the wrapped data key
+    return 20 + this->chainhash1_datablock.getLen() + this->chainhash2_datablock.getLen() + this->hash_size + KeyWrap::getWrappedLen(this->hash_size);
+}
+
+bool KeySlot::isComplete() const noexcept{
+    return (this->chainhash1_mode != 0 && this->chainhash2_mode != 0 && !this->valid_passwordhash.isEmpty() && !this->enc_datakey.isEmpty());
+}
+
+unsigned char KeySlot::getHashMode() const noexcept{
+    return this->hash_mode;
+}
+
+void KeySlot::setChainHash1(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock){
+    if(len != datablock.getLen()){
+        throw std::invalid_argument("length of the datablock does not match with the given length");
+    }
+    if(!ChainHashModes::isChainHashValid(mode, iters, datablock)){
+        throw std::invalid_argument("given data is not valid");
+    }
+    this->chainhash1_mode = mode;
+    this->chainhash1_datablock = datablock;
+    this->chainhash1_iters = iters;
+}
+
+void KeySlot::setChainHash2(unsigned char mode, unsigned long iters, unsigned char len, Bytes datablock){
+    if(len != datablock.getLen()){
+        throw std::invalid_argument("length of the datablock does not match with the given length");
+    }
+    if(!ChainHashModes::isChainHashValid(mode, iters, datablock)){
+        throw std::invalid_argument("given data is not valid");
+    }
+    this->chainhash2_mode = mode;
+    this->chainhash2_datablock = datablock;
+    this->chainhash2_iters = iters;
+}
+
+void KeySlot::setValidPasswordHashBytes(Bytes validBytes){
+    if(validBytes.getLen() != this->hash_size){
+        throw std::length_error("Length of the given validBytes does not match with the hash size");
+    }
+    this->valid_passwordhash = validBytes;
+}
+
+void KeySlot::setWrappedDataKey(Bytes wrapped){
+    if((unsigned long)wrapped.getLen() != KeyWrap::getWrappedLen(this->hash_size)){
+        throw std::length_error("Length of the wrapped data key does not match with the hash size");
+    }
+    this->enc_datakey = wrapped;
+}
+
+unsigned char KeySlot::getChainHash1Mode() const noexcept{
+    return this->chainhash1_mode;
+}
+
+unsigned long KeySlot::getChainHash1Iters() const noexcept{
+    return this->chainhash1_iters;
+}
+
+Bytes KeySlot::getChainHash1Datablock() const noexcept{
+    return this->chainhash1_datablock;
+}
+
+unsigned char KeySlot::getChainHash2Mode() const noexcept{
+    return this->chainhash2_mode;
+}
+
+unsigned long KeySlot::getChainHash2Iters() const noexcept{
+    return this->chainhash2_iters;
+}
+
+Bytes KeySlot::getChainHash2Datablock() const noexcept{
+    return this->chainhash2_datablock;
+}
+
+Bytes KeySlot::getValidPasswordHash() const noexcept{
+    return this->valid_passwordhash;
+}
+
+Bytes KeySlot::getWrappedDataKey() const noexcept{
+    return this->enc_datakey;
+}
+
+Bytes KeySlot::calcPasswordHash(std::string password, const std::atomic<bool>* stop) const{
+    if(this->chainhash1_mode == 0){
+        throw std::logic_error("first chainhash is not set");
+    }
+    Hash* hash = HashModes::getHash(this->hash_mode);
+    Bytes passwordhash = ChainHashModes::performChainHash(this->chainhash1_mode, this->chainhash1_iters, this->chainhash1_datablock, hash, password, stop);
+    delete hash;
+    return passwordhash;
+}
+
+bool KeySlot::isPasswordHashValid(Bytes passwordhash, const std::atomic<bool>* stop) const{
+    if(this->chainhash2_mode == 0){
+        throw std::logic_error("second chainhash is not set");
+    }
+    Hash* hash = HashModes::getHash(this->hash_mode);
+    Bytes validhash = ChainHashModes::performChainHash(this->chainhash2_mode, this->chainhash2_iters, this->chainhash2_datablock, hash, passwordhash, stop);
+    delete hash;
+    //constant time, so the time of a failed unlock does not tell how many bytes of the hash matched
+    return validhash.getLen() == this->valid_passwordhash.getLen() && CRYPTO_memcmp(validhash.getView().data(), this->valid_passwordhash.getView().data(), validhash.getLen()) == 0;
+}
+
+std::optional<Bytes> KeySlot::getDataKey(std::string password, const std::atomic<bool>* stop) const{
+    Bytes passwordhash = this->calcPasswordHash(password, stop);
+    if(stop != nullptr && stop->load()){
+        return {};  //another keyslot was faster
+    }
+    if(!this->isPasswordHashValid(passwordhash, stop)){
+        return {};  //wrong password (or stopped)
+    }
+    return KeyWrap::unwrap(passwordhash, this->enc_datakey);
+}
+
+void KeySlot::setPassword(std::string password, Bytes datakey){
+    if(datakey.getLen() != this->hash_size){
+        throw std::length_error("Length of the data key does not match with the hash size");
+    }
+    if(this->chainhash2_mode == 0){
+        throw std::logic_error("second chainhash is not set");
+    }
+    Bytes passwordhash = this->calcPasswordHash(password);
+    Hash* hash = HashModes::getHash(this->hash_mode);
+    Bytes validhash = ChainHashModes::performChainHash(this->chainhash2_mode, this->chainhash2_iters, this->chainhash2_datablock, hash, passwordhash);
+    delete hash;
+    this->setValidPasswordHashBytes(validhash);
+    this->setWrappedDataKey(KeyWrap::wrap(passwordhash, datakey));
+}
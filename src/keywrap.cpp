@@ -0,0 +1,38 @@
+#include "keywrap.h"
+#include "cipher_modes.h"
+#include "rng.h"
+
+static const constexpr unsigned char WRAP_CIPHER_MODE = 2;     //AES-256-GCM
+static const std::string WRAP_KEY_PURPOSE = "wrap";
+
+Bytes KeyWrap::generateDataKey(const int len){
+    if(len <= 0){
+        throw std::range_error("length of the data key has to be greater than zero");
+    }
+    Bytes datakey;
+    datakey.setBytes(RNG::get_random_bytes(len));
+    return datakey;
+}
+
+unsigned long KeyWrap::getWrappedLen(const int len){
+    return CipherModes::getEncryptedLen(WRAP_CIPHER_MODE, len);
+}
+
+Bytes KeyWrap::wrap(const Bytes passwordhash, const Bytes datakey){
+    if(datakey.isEmpty()){
+        throw std::invalid_argument("data key is empty");
+    }
+    Bytes kek = CipherModes::deriveKey(passwordhash, WRAP_KEY_PURPOSE);     //key encryption key
+    return CipherModes::encrypt(WRAP_CIPHER_MODE, kek, datakey);
+}
+
+std::optional<Bytes> KeyWrap::unwrap(const Bytes passwordhash, const Bytes wrapped){
+    Bytes kek = CipherModes::deriveKey(passwordhash, WRAP_KEY_PURPOSE);
+    try{
+        return CipherModes::decrypt(WRAP_CIPHER_MODE, kek, wrapped);
+    }catch(std::runtime_error&){
+        return {};  //tag does not match
+    }catch(std::length_error&){
+        return {};  //wrapped key is too short
+    }
+}
@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include "log_vault.h"
+#include "entry_record.h"
+#include "mapped_vault.h"
+
+LogVault::LogVault(const std::filesystem::path path, const DataHeader& header, const Bytes datakey) : log(header.getCipherMode(), datakey, header.getCompressionMode()), name_index(header.getCipherMode(), datakey), search_filter(header.getCipherMode(), datakey){
+    this->path = path;
+    this->header = header.getHeaderBytes();
+    this->mac_key = CipherModes::deriveKey(datakey, "mac");
+    this->compacting = false;
+    this->lock_timeout = LOCK_TIMEOUT_MS;
+    this->indexed_len = 0;
+    this->reloads = 0;
+    bool create = !std::filesystem::exists(path) || std::filesystem::file_size(path) == 0;
+    FileLock file_lock(path, create, this->lock_timeout);
+    if(create && (!std::filesystem::exists(path) || std::filesystem::file_size(path) == 0)){
+        this->last_save = AtomicWriter::writeFile(path, {this->header.getView()});     //new vault with an empty log
+        this->stamp = FileLock::getStamp(path);
+        std::filesystem::remove(NameIndex::getIndexPath(path));     //index and filters of an old file at the same path
+        std::filesystem::remove(SearchFilter::getFilterPath(path));
+        std::filesystem::remove(SegmentMac::getTablePath(path));
+        return;
+    }
+    this->reload();     //another process may have created the file in the meantime
+    this->indexed_len = std::min(NameIndex::readCoveredLen(NameIndex::getIndexPath(path)).value_or(0), this->log.getLogLen());
+}
+
+LogVault::LogVault(const std::filesystem::path path, const DataHeader& header, const UnlockedVault unlocked) : log(unlocked.log), name_index(header.getCipherMode(), unlocked.datakey), search_filter(header.getCipherMode(), unlocked.datakey){
+    this->path = path;
+    this->header = header.getHeaderBytes();
+    this->mac_key = CipherModes::deriveKey(unlocked.datakey, "mac");
+    this->compacting = false;
+    this->lock_timeout = LOCK_TIMEOUT_MS;
+    this->reloads = 0;
+    this->indexed_len = std::min(NameIndex::readCoveredLen(NameIndex::getIndexPath(path)).value_or(0), this->log.getLogLen());
+    this->indexEntries();
+    FileLock file_lock(path, false, this->lock_timeout);
+    this->stamp = FileLock::getStamp(path);
+    if(this->stamp.size != this->header.getLen() + this->log.getLogLen()){
+        this->stamp = FileStamp();      //the file changed since the log was loaded, it is read again before the next change
+    }
+}
+
+LogVault::~LogVault(){
+    this->waitForCompaction();
+    if(this->log.getLogLen() - this->indexed_len > MAX_UNINDEXED_LEN){
+        try{
+            this->writeIndex();
+        }catch(std::exception&){
+            //the lookups read the part that is not indexed from the log
+        }
+    }
+}
+
+void LogVault::reload(){
+    this->reloads++;
+    this->stamp = FileLock::getStamp(this->path);
+    MappedVault vault(this->path);
+    if(!(vault.getHeader().toBytes() == this->header)){
+        throw std::invalid_argument("data header of the file does not match with the given header");
+    }
+    this->log.load(vault.getBody());
+    this->indexEntries();
+}
+
+void LogVault::indexEntries(){
+    this->titles.clear();
+    this->urls.clear();
+    for(const std::string& name : this->log.getNames()){
+        this->indexEntry(name);
+    }
+}
+
+void LogVault::indexEntry(const std::string& name){
+    std::optional<Bytes> value = this->log.get(name);
+    if(!value.has_value() || !EntryView::isRecord(value->getView())){
+        return;
+    }
+    EntryView entry(value->getView());
+    std::string title = entry.getFieldString(EntryView::FIELD_TITLE);
+    std::string url = entry.getFieldString(EntryView::FIELD_URL);
+    if(!title.empty()){
+        this->titles.put(title, name);     //the entry that was changed last wins
+    }
+    if(!url.empty()){
+        this->urls.put(url, name);
+    }
+}
+
+void LogVault::unindexEntry(const std::string& name){
+    std::optional<Bytes> value = this->log.get(name);
+    if(!value.has_value() || !EntryView::isRecord(value->getView())){
+        return;
+    }
+    EntryView entry(value->getView());
+    std::string title = entry.getFieldString(EntryView::FIELD_TITLE);
+    std::string url = entry.getFieldString(EntryView::FIELD_URL);
+    this->titles.remove(title, name);  //other entries with the same title keep it
+    this->urls.remove(url, name);
+}
+
+bool LogVault::reloadIfChanged(){
+    if(FileLock::getStamp(this->path) == this->stamp){
+        return false;
+    }
+    this->reload();
+    return true;
+}
+
+void LogVault::append(const Bytes frame){
+    //writes behind the valid log, a frame that was cut off by a crash is overwritten
+    try{
+        this->last_save = AtomicWriter::appendFile(this->path, this->header.getLen() + this->log.getLogLen() - frame.getLen(), {frame.getView()});
+        this->stamp = FileLock::getStamp(this->path);
+    }catch(...){
+        this->reload();     //the change is not in the file, so the records are read again from the file
+        throw;
+    }
+}
+
+void LogVault::compactLocked(){
+    //the compacted file is written under the shared lock, so other processes can read while it is built,
+    //the exclusive lock is only held to check that the file did not change in the meantime and to rename the new file over it
+    Bytes file;
+    while(true){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        FileStamp source;
+        std::filesystem::path tmp_path;
+        {
+            FileLock file_lock(this->path, false, this->lock_timeout);
+            this->reloadIfChanged();
+            source = this->stamp;
+            file = this->header;
+            file.addBytes(this->log.getCompacted());
+            tmp_path = AtomicWriter::writeTemp(this->path, {file.getView()});
+        }
+        try{
+            FileLock file_lock(this->path, true, this->lock_timeout);
+            if(FileLock::getStamp(this->path) != source){
+                std::filesystem::remove(tmp_path);
+                continue;   //another process changed the file, the compaction is built again with its changes
+            }
+            AtomicWriter::replaceWithTemp(this->path, tmp_path);
+            this->stamp = FileLock::getStamp(this->path);
+        }catch(...){
+            std::filesystem::remove(tmp_path);
+            throw;
+        }
+        this->log.setCompacted(file.getLen() - this->header.getLen());
+        this->last_save.bytes = file.getLen();
+        this->last_save.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        break;
+    }
+    //the index, filters and mac table are written from the compacted log in memory after the lock is released
+    //(if another process changes the file before they are written, their log id does not match and they are not used)
+    try{
+        this->writeIndexLocked(file.getView());     //the positions of all frames changed
+    }catch(std::runtime_error&){
+        this->indexed_len = 0;      //the old index does not match with the log id, lookups decrypt the whole log
+    }
+    std::set<std::string> blob_ids;
+    for(const std::string& name : this->log.getNames()){
+        Bytes value = this->log.get(name).value();
+        std::optional<BlobRef> ref = BlobStore::decodeRef(value.getView());
+        if(ref.has_value()){
+            blob_ids.insert(toHex(ref->id));
+        }
+    }
+    try{
+        BlobStore::removeUnreferenced(this->path, blob_ids);    //attachments of changed and removed records
+    }catch(std::filesystem::filesystem_error&){
+        //removed at the next compaction
+    }
+}
+
+void LogVault::writeIndexLocked(const BytesView file){
+    std::vector<std::pair<std::string, unsigned long>> offsets = this->log.getOffsets();
+    std::sort(offsets.begin(), offsets.end(), [](const std::pair<std::string, unsigned long>& a, const std::pair<std::string, unsigned long>& b){
+        return a.second < b.second;
+    });
+    Bytes log_id;
+    Bytes macs;
+    SearchFilter filter = this->search_filter;
+    {
+        BytesView body = file.slice(this->header.getLen(), file.getLen() - this->header.getLen());
+        macs = SegmentMac::createTable(this->mac_key, file.slice(0, this->header.getLen() + this->log.getLogLen()));   //header and valid log
+        log_id = NameIndex::calcLogId(body, this->log.getLogLen());
+        //the latest frames are grouped into segments of about SEARCH_SEGMENT_LEN log bytes
+        std::vector<unsigned long> segment_offsets;
+        std::vector<std::string> texts;
+        unsigned long begin = 0;
+        unsigned long end = 0;
+        for(const std::pair<std::string, unsigned long>& offset : offsets){
+            unsigned long frame_len = RecordLog::getFrameLen(body, offset.second);
+            if(!segment_offsets.empty() && offset.second + frame_len - begin > SEARCH_SEGMENT_LEN){
+                filter.addSegment(begin, end, segment_offsets, texts);
+                segment_offsets.clear();
+                texts.clear();
+            }
+            if(segment_offsets.empty()){
+                begin = offset.second;
+            }
+            segment_offsets.push_back(offset.second);
+            end = offset.second + frame_len;
+            Bytes value = this->log.get(offset.first).value();
+            std::vector<std::string> record_texts = SearchFilter::getSearchText(offset.first, value.getView());
+            texts.insert(texts.end(), record_texts.begin(), record_texts.end());
+        }
+        if(!segment_offsets.empty()){
+            filter.addSegment(begin, end, segment_offsets, texts);
+        }
+    }
+    Bytes filters = filter.encode(this->log.getLogLen(), this->log.getNextSeq(), log_id);
+    AtomicWriter::writeFile(SearchFilter::getFilterPath(this->path), {filters.getView()});
+    Bytes index = this->name_index.encode(offsets, this->log.getLogLen(), this->log.getNextSeq(), log_id);
+    AtomicWriter::writeFile(NameIndex::getIndexPath(this->path), {index.getView()});
+    AtomicWriter::writeFile(SegmentMac::getTablePath(this->path), {macs.getView()});
+    this->indexed_len = this->log.getLogLen();
+}
+
+void LogVault::startCompaction(){
+    if(!this->log.needsCompaction() || this->compacting.exchange(true)){
+        return;
+    }
+    if(this->compactor.joinable()){
+        this->compactor.join();     //the last compaction has finished (compacting was false)
+    }
+    this->compactor = std::thread([this](){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            try{
+                if(this->log.needsCompaction()){
+                    this->compactLocked();
+                }
+            }catch(std::exception&){
+                //the old file is still valid, the next change tries again
+            }
+        }
+        this->compacting = false;
+    });
+}
+
+void LogVault::put(const std::string name, const Bytes value){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, true, this->lock_timeout);   //only held for the append
+    this->reloadIfChanged();
+    this->unindexEntry(name);
+    Bytes frame = this->log.put(name, value);
+    this->indexEntry(name);
+    this->append(frame);     //a failed append reads the records and builds the entry index again
+    this->startCompaction();
+}
+
+void LogVault::putAll(const std::vector<std::pair<std::string, Bytes>> records){
+    if(records.empty()){
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, true, this->lock_timeout);
+    this->reloadIfChanged();
+    for(const std::pair<std::string, Bytes>& record : records){
+        this->unindexEntry(record.first);
+    }
+    Bytes frames = this->log.putAll(records);
+    for(const std::pair<std::string, Bytes>& record : records){
+        this->indexEntry(record.first);
+    }
+    this->append(frames);    //one write and one sync for all records
+    this->startCompaction();
+}
+
+bool LogVault::remove(const std::string name){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, true, this->lock_timeout);
+    this->reloadIfChanged();
+    this->unindexEntry(name);
+    std::optional<Bytes> tombstone = this->log.remove(name);
+    if(!tombstone.has_value()){
+        return false;
+    }
+    this->append(tombstone.value());
+    this->startCompaction();
+    return true;
+}
+
+std::optional<Bytes> LogVault::get(const std::string name) const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->log.get(name);
+}
+
+std::optional<std::string> LogVault::findEntry(const std::string key) const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::optional<std::string> name = this->titles.find(key);
+    return name.has_value() ? name : this->urls.find(key);
+}
+
+std::vector<std::string> LogVault::findEntries(const std::string prefix, unsigned long limit) const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::set<std::string> names;
+    for(const EntryIndex* index : {&this->titles, &this->urls}){
+        for(const std::pair<std::string, std::string>& found : index->findPrefix(prefix, limit)){
+            names.insert(found.second);
+        }
+    }
+    std::vector<std::string> sorted(names.begin(), names.end());
+    if(sorted.size() > limit){
+        sorted.resize(limit);
+    }
+    return sorted;
+}
+
+std::vector<std::string> LogVault::getNames() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->log.getNames();
+}
+
+unsigned long LogVault::getRecordNumber() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->log.getRecordNumber();
+}
+
+unsigned long LogVault::getFileLen() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->header.getLen() + this->log.getLogLen();
+}
+
+SaveReport LogVault::getLastSave() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->last_save;
+}
+
+bool LogVault::needsCompaction() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->log.needsCompaction();
+}
+
+void LogVault::writeIndex(){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, true, this->lock_timeout);  //the index has to match with the file
+    this->reloadIfChanged();
+    MappedVault vault(this->path);
+    this->writeIndexLocked(vault.getView());
+}
+
+bool LogVault::refresh(){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, false, this->lock_timeout);
+    return this->reloadIfChanged();
+}
+
+unsigned long LogVault::getReloadCount() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->reloads;
+}
+
+void LogVault::setLockTimeout(long timeout_ms) noexcept{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->lock_timeout = timeout_ms;
+}
+
+void LogVault::compact(){
+    this->waitForCompaction();
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->compactLocked();
+}
+
+void LogVault::waitForCompaction(){
+    std::thread running;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        running = std::move(this->compactor);   //only one caller joins the thread
+    }
+    if(running.joinable()){
+        running.join();
+    }
+}
+
+ScrubReport LogVault::scrub(const std::filesystem::path path, const Bytes datakey, unsigned int threads){
+    FileLock file_lock(path, false);
+    std::vector<unsigned char> table = AtomicWriter::readFile(SegmentMac::getTablePath(path));
+    if(table.empty()){
+        throw std::runtime_error("the vault has no mac table (it is written with the name index)");
+    }
+    MappedVault vault(path);
+    return SegmentMac::scrubTable(CipherModes::deriveKey(datakey, "mac"), vault.getView(), BytesView(table), threads);
+}
+
+NameLookup LogVault::lookup(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, const std::string name){
+    NameLookup result;
+    FileLock file_lock(path, false);
+    MappedVault vault(path);
+    if(!(vault.getHeader().toBytes() == header.getHeaderBytes())){
+        throw std::invalid_argument("data header of the file does not match with the given header");
+    }
+    BytesView body = vault.getBody();
+    RecordLog log(header.getCipherMode(), datakey, header.getCompressionMode());
+    NameIndex index(header.getCipherMode(), datakey);
+    std::vector<unsigned char> index_bytes = AtomicWriter::readFile(NameIndex::getIndexPath(path));
+    try{
+        index.load(BytesView(index_bytes));
+        result.used_index = index.getCoveredLen() <= body.getLen() && index.getLogId() == NameIndex::calcLogId(body, index.getCoveredLen());
+    }catch(std::runtime_error&){
+        result.used_index = false;  //no index, an index of another key or a modified index
+    }
+    if(!result.used_index){
+        log.load(body);
+        result.value = log.get(name);
+        result.decrypted_len = body.getLen();
+        return result;
+    }
+    result.decrypted_len = index_bytes.size();
+    std::optional<unsigned long> pos = index.find(name);
+    if(pos.has_value()){
+        unsigned long frame_len = RecordLog::getFrameLen(body, pos.value());
+        if(frame_len == 0 || pos.value() + frame_len > index.getCoveredLen()){
+            throw std::runtime_error("name index does not match with the log");
+        }
+        LogFrame frame = log.decodeFrame(body.slice(pos.value(), frame_len));
+        if(frame.name != name || frame.type != RecordLog::RECORD_PUT){
+            throw std::runtime_error("name index does not match with the log");
+        }
+        result.value = frame.value;
+        result.decrypted_len += frame_len;
+    }
+    //the last frame of the name behind the index wins
+    result.decrypted_len += log.readFrames(body, index.getCoveredLen(), index.getNextSeq(), [&result, &name](const LogFrame& frame, unsigned long, unsigned long){
+        if(frame.name == name){
+            result.value = frame.type == RecordLog::RECORD_PUT ? std::optional<Bytes>(frame.value) : std::nullopt;
+        }
+    }) - index.getCoveredLen();
+    return result;
+}
+
+SearchResult LogVault::search(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, const std::string query, unsigned int threads){
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+    FileLock file_lock(path, false);
+    MappedVault vault(path);
+    if(!(vault.getHeader().toBytes() == header.getHeaderBytes())){
+        throw std::invalid_argument("data header of the file does not match with the given header");
+    }
+    BytesView body = vault.getBody();
+    RecordLog log(header.getCipherMode(), datakey, header.getCompressionMode());
+    SearchFilter filter(header.getCipherMode(), datakey);
+    std::vector<unsigned char> filter_bytes = AtomicWriter::readFile(SearchFilter::getFilterPath(path));
+    try{
+        filter.load(BytesView(filter_bytes));
+        result.used_filters = filter.getCoveredLen() <= body.getLen() && filter.getLogId() == NameIndex::calcLogId(body, filter.getCoveredLen());
+    }catch(std::runtime_error&){
+        result.used_filters = false;    //no filters, filters of another key or modified filters
+    }
+    std::set<std::string> names;
+    if(!result.used_filters){
+        log.load(body);
+        for(const std::string& name : log.getNames()){
+            Bytes value = log.get(name).value();
+            if(SearchFilter::matches(name, value.getView(), query)){
+                names.insert(name);
+            }
+        }
+        result.names.assign(names.begin(), names.end());
+        result.decrypted_len = body.getLen();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    std::vector<unsigned long> candidates = filter.getCandidates(query);
+    result.segments = filter.getSegmentNumber();
+    result.scanned_segments = candidates.size();
+    result.decrypted_len = filter_bytes.size();
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<unsigned long>(threads, std::max(1UL, candidates.size()));
+    std::atomic<unsigned long> next{0};
+    std::mutex result_mutex;
+    std::exception_ptr error;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t < threads; t++){
+        workers.emplace_back([&](){
+            //each worker takes the next candidate segment until all candidates are scanned
+            try{
+                for(unsigned long i = next++; i < candidates.size(); i = next++){
+                    const SearchSegment& segment = filter.getSegment(candidates[i]);
+                    std::vector<std::string> found;
+                    unsigned long decrypted_len = 0;
+                    for(unsigned long offset : segment.offsets){
+                        unsigned long frame_len = RecordLog::getFrameLen(body, offset);
+                        if(frame_len == 0 || offset + frame_len > segment.end){
+                            throw std::runtime_error("search filters do not match with the log");
+                        }
+                        LogFrame frame = log.decodeFrame(body.slice(offset, frame_len));
+                        if(frame.type != RecordLog::RECORD_PUT){
+                            throw std::runtime_error("search filters do not match with the log");
+                        }
+                        if(SearchFilter::matches(frame.name, frame.value.getView(), query)){
+                            found.push_back(frame.name);
+                        }
+                        decrypted_len += frame_len;
+                    }
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    names.insert(found.begin(), found.end());
+                    result.decrypted_len += decrypted_len;
+                }
+            }catch(...){
+                std::lock_guard<std::mutex> lock(result_mutex);
+                if(!error){
+                    error = std::current_exception();
+                }
+                next = candidates.size();   //the other workers stop
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    if(error){
+        std::rethrow_exception(error);
+    }
+    //the frames behind the filters replace the older versions of their records
+    std::map<std::string, LogFrame> tail;
+    result.decrypted_len += log.readFrames(body, filter.getCoveredLen(), filter.getNextSeq(), [&tail](const LogFrame& frame, unsigned long, unsigned long){
+        tail[frame.name] = frame;
+    }) - filter.getCoveredLen();
+    for(const std::pair<const std::string, LogFrame>& changed : tail){
+        names.erase(changed.first);
+        if(changed.second.type == RecordLog::RECORD_PUT && SearchFilter::matches(changed.first, changed.second.value.getView(), query)){
+            names.insert(changed.first);
+        }
+    }
+    result.names.assign(names.begin(), names.end());
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
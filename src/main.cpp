@@ -1,22 +1,98 @@
 #include <iostream>
+#include <string>
 #include "app.h"
 
+static void printUsage(const char* name){
+    std::cerr << "usage: " << name << "                                   interactive mode" << std::endl;
+    std::cerr << "       " << name << " --vault <file> --batch [--password-fd <fd>]   reads get/set/del/list commands from stdin (the vault can be a sharded vault directory)" << std::endl;
+    std::cerr << "       " << name << " get <name> --vault <file> [--password-fd <fd>]   prints one record (uses the name index of the vault, or the title or url of an entry)" << std::endl;
+    std::cerr << "       " << name << " search <query> --vault <file> [--password-fd <fd>]   prints the names of the records that contain the query" << std::endl;
+    std::cerr << "       " << name << " attach <name> <file> --vault <file> [--password-fd <fd>]   stores the file as an encrypted attachment" << std::endl;
+    std::cerr << "       " << name << " export <name> <file> --vault <file> [--password-fd <fd>]   writes the attachment into the file (- for stdout)" << std::endl;
+    std::cerr << "       " << name << " import <file> --vault <file> [--password-fd <fd>] [--format csv|json]   imports the export of another password manager (- for stdin)" << std::endl;
+    std::cerr << "       " << name << " shard <directory> --vault <file> [--password-fd <fd>] [--shards <n>]   copies the vault into a new sharded vault directory" << std::endl;
+    std::cerr << "       " << name << " scrub --vault <file> [--password-fd <fd>]   checks the vault with its segment macs and prints the damaged offsets" << std::endl;
+    std::cerr << "       " << name << " serve --vault <file> [--password-fd <fd>] [--socket <path>] [--threads <n>]   answers the commands of many clients on a unix socket" << std::endl;
+}
+
 int main(int argc, char *argv[]) {
-    // for (int i = 0; i < argc; i++){
-    //     std::cout << "a"<<argv[i]<<"b" << std::endl;
-    //     if (argv[i] == "-f"){
-    //         if (argc == i){
-    //             std::cout << "break";
-    //             return 1;
-    //         }
-    //         std::cout << "no break";
-    //         i++;
-    //         char* path = argv[i];
-    //         FileHandler FH;
-    //         std::cout << FH.setFilePath(path);
-    //         continue;
-    //     }
-    // }
+    std::string vault_path;
+    std::string socket_path;
+    std::string format;             //format of pman import (empty: from the file extension)
+    std::string command;            //subcommand (empty for the interactive and the batch mode)
+    std::vector<std::string> args;  //arguments of the subcommand
+    bool batch = false;
+    int password_fd = -1;
+    unsigned int threads = 0;
+    unsigned long shards = STANDARD_SHARD_NUMBER;
+    int first = 1;
+    if (argc > 1){
+        std::string arg = argv[1];
+        unsigned int arg_number = (arg == "serve" || arg == "scrub") ? 0 : (arg == "get" || arg == "search" || arg == "import" || arg == "shard") ? 1 : (arg == "attach" || arg == "export") ? 2 : 3;
+        if (arg_number < 3){
+            if (argc < 2 + (int)arg_number){
+                printUsage(argv[0]);
+                return 1;
+            }
+            command = arg;
+            args.assign(argv + 2, argv + 2 + arg_number);
+            first = 2 + arg_number;
+        }
+    }
+    for (int i = first; i < argc; i++){
+        std::string arg = argv[i];
+        try{
+            if (arg == "--vault" && i+1 < argc){
+                vault_path = argv[++i];
+            }else if (arg == "--batch" && command.empty()){
+                batch = true;
+            }else if (arg == "--password-fd" && i+1 < argc){
+                password_fd = std::stoi(argv[++i]);
+            }else if (arg == "--socket" && command == "serve" && i+1 < argc){
+                socket_path = argv[++i];
+            }else if (arg == "--threads" && command == "serve" && i+1 < argc){
+                threads = std::stoul(argv[++i]);
+            }else if (arg == "--format" && command == "import" && i+1 < argc){
+                format = argv[++i];
+            }else if (arg == "--shards" && command == "shard" && i+1 < argc){
+                shards = std::stoul(argv[++i]);
+            }else{
+                printUsage(argv[0]);
+                return 1;
+            }
+        }catch(std::exception&){
+            printUsage(argv[0]);    //not a number
+            return 1;
+        }
+    }
     App app;
-    return app.run();
+    if (batch || !command.empty()){
+        if (vault_path.empty()){
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (command == "get"){
+            return app.runGet(vault_path, password_fd, args[0]);
+        }else if (command == "search"){
+            return app.runSearch(vault_path, password_fd, args[0]);
+        }else if (command == "attach"){
+            return app.runAttach(vault_path, password_fd, args[0], args[1]);
+        }else if (command == "export"){
+            return app.runExport(vault_path, password_fd, args[0], args[1]);
+        }else if (command == "import"){
+            return app.runImport(vault_path, password_fd, args[0], format);
+        }else if (command == "shard"){
+            return app.runShard(vault_path, password_fd, args[0], shards);
+        }else if (command == "scrub"){
+            return app.runScrub(vault_path, password_fd);
+        }else if (command == "serve"){
+            return app.runServe(vault_path, password_fd, socket_path, threads);
+        }
+        return app.runBatch(vault_path, password_fd);
+    }
+    if (!vault_path.empty() || password_fd >= 0){
+        printUsage(argv[0]);    //these options are only for the batch mode
+        return 1;
+    }
+    return app.run() ? 0 : 1;
 }
@@ -0,0 +1,150 @@
+#include <fstream>
+#include <stdexcept>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "mapped_vault.h"
+#include "dataHeader.h"
+
+MappedVault::MappedVault(const std::filesystem::path path){
+    this->data = nullptr;
+    this->len = 0;
+    this->header_len = 0;
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary);
+    if(!file){
+        throw std::runtime_error("Encrypted file not found in filepath");
+    }
+    file.seekg(0, file.end);
+    this->buffer.resize(file.tellg());
+    file.seekg(0, file.beg);
+    file.read(reinterpret_cast<char*>(this->buffer.data()), this->buffer.size());
+    this->len = this->buffer.size();
+    if(this->len > 0){
+        this->data = this->buffer.data();
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        throw std::runtime_error("Encrypted file not found in filepath");
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0){
+        close(fd);
+        throw std::runtime_error("Encrypted file could not be read");
+    }
+    this->len = st.st_size;
+    if(this->len > 0){
+        void* mapped = mmap(nullptr, this->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped == MAP_FAILED){
+            close(fd);
+            throw std::runtime_error("Encrypted file could not be mapped");
+        }
+        this->data = static_cast<unsigned char*>(mapped);
+    }
+    close(fd);      //the mapping stays valid without the file descriptor
+#endif
+    if(this->len > 0){
+        try{
+            this->header_len = DataHeader::readHeaderLength(this->getView());
+        }catch(...){
+            this->unmap();
+            throw;
+        }
+    }
+}
+
+MappedVault::MappedVault(MappedVault&& other) noexcept{
+    this->data = nullptr;
+    this->len = 0;
+    this->header_len = 0;
+    *this = std::move(other);
+}
+
+MappedVault& MappedVault::operator=(MappedVault&& other) noexcept{
+    if(this != &other){
+        this->unmap();
+        bool buffered = !other.buffer.empty();
+        this->buffer = std::move(other.buffer);
+        this->data = buffered ? this->buffer.data() : other.data;
+        this->len = other.len;
+        this->header_len = other.header_len;
+        other.data = nullptr;
+        other.len = 0;
+        other.header_len = 0;
+    }
+    return *this;
+}
+
+MappedVault::~MappedVault(){
+    this->unmap();
+}
+
+void MappedVault::unmap() noexcept{
+#if !defined(_WIN32)
+    if(this->data != nullptr && this->buffer.empty()){
+        munmap(this->data, this->len);
+    }
+#endif
+    this->buffer.clear();
+    this->data = nullptr;
+    this->len = 0;
+    this->header_len = 0;
+}
+
+void MappedVault::advise(unsigned long offset, unsigned long len, int advice) const noexcept{
+#if !defined(_WIN32)
+    if(this->data == nullptr || !this->buffer.empty() || len == 0){
+        return;
+    }
+    //madvise needs a page aligned address
+    unsigned long page = sysconf(_SC_PAGESIZE);
+    unsigned long begin = offset - offset % page;
+    madvise(this->data + begin, offset + len - begin, advice);    //only a hint, errors are ignored
+#endif
+}
+
+bool MappedVault::isEmpty() const noexcept{
+    return this->len == 0;
+}
+
+unsigned long MappedVault::getLen() const noexcept{
+    return this->len;
+}
+
+unsigned int MappedVault::getHeaderLength() const noexcept{
+    return this->header_len;
+}
+
+BytesView MappedVault::getView() const noexcept{
+    return BytesView(this->data, this->len);
+}
+
+BytesView MappedVault::getHeader() const noexcept{
+#if !defined(_WIN32)
+    this->advise(0, this->header_len, MADV_WILLNEED);
+#endif
+    return BytesView(this->data, this->header_len);
+}
+
+BytesView MappedVault::getBody() const noexcept{
+#if !defined(_WIN32)
+    this->advise(this->header_len, this->len - this->header_len, MADV_SEQUENTIAL);
+#endif
+    return BytesView(this->data + this->header_len, this->len - this->header_len);
+}
+
+void MappedVault::adviseRandom() const noexcept{
+#if !defined(_WIN32)
+    this->advise(this->header_len, this->len - this->header_len, MADV_RANDOM);
+#endif
+}
+
+void MappedVault::prefetch() const noexcept{
+#if !defined(_WIN32)
+    this->advise(0, this->len, MADV_WILLNEED);
+#endif
+}
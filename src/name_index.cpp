@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "name_index.h"
+#include "cipher_modes.h"
+#include "sha256.h"
+
+static const std::string INDEX_MAGIC = "PIDX";
+
+NameIndex::NameIndex(unsigned char const cipher_mode, const Bytes datakey){
+    if(!CipherModes::isAuthenticated(cipher_mode)){
+        throw std::invalid_argument("name indexes need an authenticated cipher mode");
+    }
+    this->cipher_mode = cipher_mode;
+    this->enc_key = CipherModes::deriveKey(datakey, "index");
+    this->mac_key = CipherModes::deriveKey(datakey, "index-name");
+    this->covered_len = 0;
+    this->next_seq = 0;
+}
+
+Bytes NameIndex::getNameHash(const std::string name) const{
+    Bytes hash = CipherModes::deriveKey(this->mac_key, name);     //HMAC-SHA256 of the name
+    return hash.getView().slice(0, HASH_LEN).toBytes();
+}
+
+Bytes NameIndex::encode(const std::vector<std::pair<std::string, unsigned long>> offsets, unsigned long covered_len, unsigned long next_seq, const Bytes log_id) const{
+    if(log_id.getLen() != 32){
+        throw std::length_error("log id has to be 32 bytes long");
+    }
+    std::vector<std::vector<unsigned char>> entries;
+    entries.reserve(offsets.size());
+    for(const std::pair<std::string, unsigned long>& offset : offsets){
+        std::vector<unsigned char> entry = this->getNameHash(offset.first).getBytes();
+        std::vector<unsigned char> pos = fromLong(offset.second).getBytes();
+        entry.insert(entry.end(), pos.begin(), pos.end());
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end());
+    //the prefix is stored readable and encrypted, so it cannot be changed unnoticed
+    Bytes prefix;
+    for(char c : INDEX_MAGIC){
+        prefix.addByte(c);
+    }
+    prefix.addBytes(fromLong(covered_len));
+    prefix.addBytes(fromLong(next_seq));
+    prefix.addBytes(log_id);
+    std::vector<unsigned char> plain = prefix.getBytes();
+    plain.reserve(PREFIX_LEN + 8 + entries.size() * ENTRY_LEN);
+    std::vector<unsigned char> count = fromLong(entries.size()).getBytes();
+    plain.insert(plain.end(), count.begin(), count.end());
+    for(const std::vector<unsigned char>& entry : entries){
+        plain.insert(plain.end(), entry.begin(), entry.end());
+    }
+    Bytes plain_bytes;
+    plain_bytes.setBytes(plain);
+    Bytes file = prefix;
+    file.addBytes(CipherModes::encrypt(this->cipher_mode, this->enc_key, plain_bytes));
+    return file;
+}
+
+void NameIndex::load(const BytesView file){
+    if(file.getLen() < PREFIX_LEN || std::string(file.data(), file.data() + 4) != INDEX_MAGIC){
+        throw std::runtime_error("name index is corrupted (no index prefix)");
+    }
+    Bytes plain = CipherModes::decrypt(this->cipher_mode, this->enc_key, file.slice(PREFIX_LEN, file.getLen() - PREFIX_LEN).toBytes());
+    BytesView p = plain.getView();
+    if(p.getLen() < PREFIX_LEN + 8 || std::memcmp(p.data(), file.data(), PREFIX_LEN) != 0){
+        throw std::runtime_error("name index is corrupted (prefix was modified)");
+    }
+    unsigned long count = toLong(p.slice(PREFIX_LEN, 8));
+    if(count != (p.getLen() - PREFIX_LEN - 8) / ENTRY_LEN || (p.getLen() - PREFIX_LEN - 8) % ENTRY_LEN != 0){
+        throw std::runtime_error("name index is corrupted (wrong number of entries)");
+    }
+    this->covered_len = toLong(p.slice(4, 8));
+    this->next_seq = toLong(p.slice(12, 8));
+    this->log_id = p.slice(20, 32).toBytes();
+    this->entries = p.slice(PREFIX_LEN + 8, count * ENTRY_LEN).toBytes();
+}
+
+std::optional<unsigned long> NameIndex::find(const std::string name) const{
+    Bytes hash = this->getNameHash(name);
+    BytesView entries = this->entries.getView();
+    unsigned long low = 0;
+    unsigned long high = entries.getLen() / ENTRY_LEN;
+    while(low < high){
+        unsigned long mid = (low + high) / 2;
+        int cmp = std::memcmp(entries.data() + mid * ENTRY_LEN, hash.getView().data(), HASH_LEN);
+        if(cmp == 0){
+            return toLong(entries.slice(mid * ENTRY_LEN + HASH_LEN, 8));
+        }
+        if(cmp < 0){
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    return {};
+}
+
+unsigned long NameIndex::getEntryNumber() const noexcept{
+    return this->entries.getLen() / ENTRY_LEN;
+}
+
+unsigned long NameIndex::getCoveredLen() const noexcept{
+    return this->covered_len;
+}
+
+unsigned long NameIndex::getNextSeq() const noexcept{
+    return this->next_seq;
+}
+
+Bytes NameIndex::getLogId() const noexcept{
+    return this->log_id;
+}
+
+Bytes NameIndex::calcLogId(const BytesView log, unsigned long covered_len){
+    //the begin of the log contains the random nonces of the first frames, so every compaction gets a new id
+    unsigned long len = std::min(std::min(covered_len, LOG_ID_LEN), log.getLen());
+    return sha256().hash(log.slice(0, len).toBytes());
+}
+
+std::filesystem::path NameIndex::getIndexPath(const std::filesystem::path vault_path){
+    std::filesystem::path index_path = vault_path;
+    index_path += ".idx";
+    return index_path;
+}
+
+std::optional<unsigned long> NameIndex::readCoveredLen(const std::filesystem::path index_path) noexcept{
+    std::ifstream file(index_path, std::ios::binary);
+    unsigned char prefix[12];
+    if(!file.read(reinterpret_cast<char*>(prefix), sizeof(prefix)) || std::string(prefix, prefix + 4) != INDEX_MAGIC){
+        return {};
+    }
+    return toLong(BytesView(prefix + 4, 8));
+}
@@ -21,9 +21,18 @@ PwFunc::PwFunc(const Hash *hash) noexcept
     this->hash = hash;
 }
 
+void PwFunc::setStopFlag(const std::atomic<bool>* stop) noexcept{
+    this->stop = stop;
+}
+
+bool PwFunc::isStopped() const noexcept{
+    return this->stop != nullptr && this->stop->load(std::memory_order_relaxed);
+}
+
 Bytes PwFunc::chainhash(const std::string password, unsigned long iterations) const noexcept{
     Bytes ret = this->hash->hash(password);     //hashes the password
     for(unsigned long i=1; i < iterations; i++){
+        if(this->isStopped())return Bytes();   //stopped from another thread
         //for iterations -1 the hash is hashed again
         ret = this->hash->hash(ret);
     }
@@ -34,6 +43,7 @@ Bytes PwFunc::chainhashWithConstantSalt(const std::string password, unsigned lon
     Bytes ret = this->hash->hash(password+salt);        //hashes the password with the salt added
     Bytes hashed_salt = this->hash->hash(salt);         //hashes the salt
     for(unsigned long i=1; i < iterations; i++){
+        if(this->isStopped())return Bytes();   //stopped from another thread
         //for iterations -1 the salt hash is added to the current hash and the result is hashed again
         ret.addBytes(hashed_salt);
         ret = this->hash->hash(ret);
@@ -44,6 +54,7 @@ Bytes PwFunc::chainhashWithConstantSalt(const std::string password, unsigned lon
 Bytes PwFunc::chainhashWithCountSalt(const std::string password, unsigned long iterations, unsigned long salt_start) const noexcept{
     Bytes ret = this->hash->hash(password+std::to_string(salt_start));  //hashes the password with the start salt added
     for(unsigned long i=1; i < iterations; i++){
+        if(this->isStopped())return Bytes();   //stopped from another thread
         //for iterations - 1 the salt will count up and get hashed. The hash is added to the current hash and is hashed again
         salt_start++;
         Bytes hashed_salt = this->hash->hash(std::to_string(salt_start));
@@ -57,6 +68,7 @@ Bytes PwFunc::chainhashWithCountAndConstantSalt(const std::string password, unsi
     Bytes ret = this->hash->hash(password+salt+std::to_string(salt_start)); //the password is hashed with the salt and the count salt
     Bytes hashed_constant_salt = this->hash->hash(salt);    //the constant salt gets hashed
     for(unsigned long i=1; i < iterations; i++){
+        if(this->isStopped())return Bytes();   //stopped from another thread
         //for iterations -1 the count salt will increment and get hashed. Next the constant salt hash gets added to the current hash as well as the count salt hash
         //the result is hashed again
         salt_start++;
@@ -71,6 +83,7 @@ Bytes PwFunc::chainhashWithCountAndConstantSalt(const std::string password, unsi
 Bytes PwFunc::chainhashWithQuadraticCountSalt(const std::string password, unsigned long iterations, unsigned long salt_start, unsigned long a, unsigned long b, unsigned long c) const noexcept{
     Bytes ret = this->hash->hash(password+std::to_string(a*salt_start*salt_start + b*salt_start + c));  //hashes the password with the a*start_salt^2 + b*start_salt + c added
     for(unsigned long i=1; i < iterations; i++){
+        if(this->isStopped())return Bytes();   //stopped from another thread
         //for iterations - 1 the salt will count up and get hashed. The hash is added to the current hash and is hashed again
         salt_start++;
         Bytes hashed_salt = this->hash->hash(std::to_string(a*salt_start*salt_start + b*salt_start + c));
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "record_log.h"
+
+RecordLog::RecordLog(unsigned char const cipher_mode, const Bytes datakey, unsigned char const compression_mode){
+    if(!CipherModes::isAuthenticated(cipher_mode)){
+        throw std::invalid_argument("record logs need an authenticated cipher mode");
+    }
+    if(!Compression::isModeValid(compression_mode)){
+        throw std::invalid_argument("compression mode does not exist");
+    }
+    this->cipher_mode = cipher_mode;
+    this->compression_mode = compression_mode;
+    this->key = CipherModes::deriveKey(datakey, "data");
+    this->log_len = 0;
+    this->live_len = 0;
+    this->next_seq = 0;
+}
+
+Bytes RecordLog::encodeFrame(unsigned long seq, unsigned char type, const std::string& name, const Bytes& value) const{
+    if(name.empty() || name.size() > 0xFFFF){
+        throw std::length_error("record name has to be between 1 and 65535 bytes long");
+    }
+    //plain record: sequence number, type, name length, name, (compressed) value
+    Bytes plain = fromLong(seq);
+    plain.addByte(type);
+    plain.addBytes(fromLong(name.size(), 2));
+    for(char c : name){
+        plain.addByte(c);
+    }
+    plain.addBytes(Compression::compress(this->compression_mode, value));
+    if(CipherModes::getEncryptedLen(this->cipher_mode, plain.getView().getLen()) > 0xFFFFFFFF){
+        throw std::length_error("record is too long");     //the frame length has 4 bytes
+    }
+    Bytes encrypted = CipherModes::encrypt(this->cipher_mode, this->key, plain);
+    Bytes frame = fromLong(encrypted.getLen(), FRAME_HEADER_LEN);
+    frame.addBytes(encrypted);
+    return frame;
+}
+
+unsigned long RecordLog::getFrameLen(const BytesView log, unsigned long pos) noexcept{
+    if(pos > log.getLen() || log.getLen() - pos < FRAME_HEADER_LEN){
+        return 0;   //frame header was cut off while appending
+    }
+    unsigned long frame_len = FRAME_HEADER_LEN + toLong(log.slice(pos, FRAME_HEADER_LEN));
+    if(frame_len > log.getLen() - pos){
+        return 0;   //frame was cut off while appending
+    }
+    return frame_len;
+}
+
+LogFrame RecordLog::decodeFrame(const BytesView frame) const{
+    Bytes plain = CipherModes::decrypt(this->cipher_mode, this->key, frame.slice(FRAME_HEADER_LEN, frame.getLen() - FRAME_HEADER_LEN).toBytes());
+    BytesView p = plain.getView();
+    if(p.getLen() < 11){
+        throw std::runtime_error("record log is corrupted (record is too short)");
+    }
+    LogFrame decoded;
+    decoded.seq = toLong(p.slice(0, 8));
+    decoded.type = p[8];
+    unsigned long name_len = toLong(p.slice(9, 2));
+    if(name_len == 0 || 11 + name_len > p.getLen()){
+        throw std::runtime_error("record log is corrupted (invalid record name)");
+    }
+    if(decoded.type != RECORD_PUT && decoded.type != RECORD_TOMBSTONE){
+        throw std::runtime_error("record log is corrupted (unknown record type)");
+    }
+    decoded.name = std::string(p.data() + 11, p.data() + 11 + name_len);
+    decoded.value = p.slice(11 + name_len, p.getLen() - 11 - name_len).toBytes();
+    if(this->compression_mode != 0){
+        try{
+            decoded.value = Compression::decompress(this->compression_mode, decoded.value);
+        }catch(std::exception&){
+            throw std::runtime_error("record log is corrupted (invalid compressed value)");
+        }
+    }
+    return decoded;
+}
+
+unsigned long RecordLog::readFrames(const BytesView log, unsigned long begin, unsigned long seq, const std::function<void(const LogFrame&, unsigned long, unsigned long)> onFrame) const{
+    unsigned long pos = begin;
+    while(pos < log.getLen()){
+        unsigned long frame_len = RecordLog::getFrameLen(log, pos);
+        if(frame_len == 0){
+            break;      //frame was cut off while appending
+        }
+        LogFrame frame;
+        try{
+            frame = this->decodeFrame(log.slice(pos, frame_len));
+        }catch(std::runtime_error&){
+            if(pos + frame_len == log.getLen()){
+                break;  //last frame was not completely written
+            }
+            throw std::runtime_error("record log is corrupted (a record was modified)");
+        }
+        if(frame.seq != seq++){
+            throw std::runtime_error("record log is corrupted (records are missing or reordered)");
+        }
+        onFrame(frame, pos, frame_len);
+        pos += frame_len;
+    }
+    return pos;
+}
+
+unsigned long RecordLog::load(const BytesView log){
+    this->records.clear();
+    this->log_len = 0;
+    this->live_len = 0;
+    this->next_seq = 0;
+    this->log_len = this->readFrames(log, 0, 0, [this](const LogFrame& frame, unsigned long pos, unsigned long frame_len){
+        std::map<std::string, LogRecord>::iterator old = this->records.find(frame.name);
+        if(old != this->records.end()){
+            this->live_len -= old->second.frame_len;    //the old version is garbage now
+        }
+        if(frame.type == RECORD_PUT){
+            LogRecord& record = this->records[frame.name];
+            record.value = frame.value;
+            record.frame_len = frame_len;
+            record.offset = pos;
+            this->live_len += frame_len;
+        }else if(old != this->records.end()){
+            this->records.erase(old);
+        }
+        this->next_seq++;
+    });
+    return this->log_len;
+}
+
+Bytes RecordLog::put(const std::string name, const Bytes value){
+    Bytes frame = this->encodeFrame(this->next_seq, RECORD_PUT, name, value);
+    LogRecord& record = this->records[name];
+    this->live_len += frame.getLen() - record.frame_len;    //frame_len is 0 for new records
+    record.value = value;
+    record.frame_len = frame.getLen();
+    record.offset = this->log_len;
+    this->log_len += frame.getLen();
+    this->next_seq++;
+    return frame;
+}
+
+Bytes RecordLog::putAll(const std::vector<std::pair<std::string, Bytes>> records, unsigned int threads){
+    //the sequence numbers are known in advance, so the frames can be encrypted by many threads
+    std::vector<Bytes> frames(records.size());
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<unsigned long>(threads, std::max(1UL, records.size()));
+    std::atomic<unsigned long> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t < threads; t++){
+        workers.emplace_back([&](){
+            for(unsigned long i = next++; i < records.size(); i = next++){
+                try{
+                    frames[i] = this->encodeFrame(this->next_seq + i, RECORD_PUT, records[i].first, records[i].second);
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error){
+                        error = std::current_exception();
+                    }
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    if(error){
+        std::rethrow_exception(error);      //no record was changed
+    }
+    //the records in memory are only changed when all frames were encrypted
+    std::vector<unsigned char> log;
+    for(unsigned long i=0; i < records.size(); i++){
+        LogRecord& record = this->records[records[i].first];
+        this->live_len += frames[i].getLen() - record.frame_len;
+        record.value = records[i].second;
+        record.frame_len = frames[i].getLen();
+        record.offset = this->log_len;
+        this->log_len += frames[i].getLen();
+        this->next_seq++;
+        BytesView view = frames[i].getView();
+        log.insert(log.end(), view.data(), view.data() + view.getLen());
+    }
+    Bytes ret;
+    ret.setBytes(log);
+    return ret;
+}
+
+std::optional<Bytes> RecordLog::remove(const std::string name){
+    std::map<std::string, LogRecord>::iterator it = this->records.find(name);
+    if(it == this->records.end()){
+        return {};
+    }
+    Bytes frame = this->encodeFrame(this->next_seq, RECORD_TOMBSTONE, name, Bytes());
+    this->live_len -= it->second.frame_len;
+    this->records.erase(it);
+    this->log_len += frame.getLen();
+    this->next_seq++;
+    return frame;
+}
+
+std::optional<Bytes> RecordLog::get(const std::string name) const{
+    std::map<std::string, LogRecord>::const_iterator it = this->records.find(name);
+    if(it == this->records.end()){
+        return {};
+    }
+    return it->second.value;
+}
+
+std::vector<std::string> RecordLog::getNames() const{
+    std::vector<std::string> names;
+    names.reserve(this->records.size());
+    for(const std::pair<const std::string, LogRecord>& record : this->records){
+        names.push_back(record.first);
+    }
+    return names;
+}
+
+std::vector<std::pair<std::string, unsigned long>> RecordLog::getOffsets() const{
+    std::vector<std::pair<std::string, unsigned long>> offsets;
+    offsets.reserve(this->records.size());
+    for(const std::pair<const std::string, LogRecord>& record : this->records){
+        offsets.emplace_back(record.first, record.second.offset);
+    }
+    return offsets;
+}
+
+unsigned long RecordLog::getRecordNumber() const noexcept{
+    return this->records.size();
+}
+
+unsigned long RecordLog::getLogLen() const noexcept{
+    return this->log_len;
+}
+
+unsigned long RecordLog::getNextSeq() const noexcept{
+    return this->next_seq;
+}
+
+unsigned long RecordLog::getGarbageLen() const noexcept{
+    return this->log_len - this->live_len;
+}
+
+bool RecordLog::needsCompaction() const noexcept{
+    return this->log_len >= MIN_COMPACTION_LEN && this->getGarbageLen() * 100 > this->log_len * COMPACTION_GARBAGE_PERCENT;
+}
+
+Bytes RecordLog::getCompacted() const{
+    //the frames keep their lengths (the sequence number has a fixed length), so the compacted log is live_len long
+    std::vector<unsigned char> log;
+    log.reserve(this->live_len);
+    unsigned long seq = 0;
+    for(const std::pair<const std::string, LogRecord>& record : this->records){
+        Bytes frame = this->encodeFrame(seq++, RECORD_PUT, record.first, record.second.value);
+        BytesView view = frame.getView();
+        log.insert(log.end(), view.data(), view.data() + view.getLen());
+    }
+    Bytes ret;
+    ret.setBytes(log);
+    return ret;
+}
+
+void RecordLog::setCompacted(const unsigned long len){
+    if(len != this->live_len){
+        throw std::logic_error("compacted log does not match with the records");
+    }
+    this->log_len = len;
+    this->next_seq = this->records.size();
+    unsigned long offset = 0;
+    for(std::pair<const std::string, LogRecord>& record : this->records){
+        record.second.offset = offset;  //same order as getCompacted
+        offset += record.second.frame_len;
+    }
+}
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+#include "search_filter.h"
+#include "cipher_modes.h"
+#include "entry_record.h"
+
+static const std::string FILTER_MAGIC = "PFLT";
+static const constexpr unsigned long MIN_FILTER_BITS = 512;
+
+static std::string toLower(const std::string text){
+    //only ascii letters are changed, bytes of other utf-8 chars stay as they are
+    std::string lower = text;
+    for(char& c : lower){
+        if(c >= 'A' && c <= 'Z'){
+            c = c - 'A' + 'a';
+        }
+    }
+    return lower;
+}
+
+static std::unordered_set<uint32_t> getTrigrams(const std::string lower){
+    std::unordered_set<uint32_t> trigrams;
+    for(unsigned long i=0; i + 3 <= lower.size(); i++){
+        trigrams.insert((uint32_t)(unsigned char)lower[i] << 16 | (uint32_t)(unsigned char)lower[i+1] << 8 | (unsigned char)lower[i+2]);
+    }
+    return trigrams;
+}
+
+static void appendLong(std::vector<unsigned char>& out, uint64_t value, int len){
+    for(int i = len-1; i >= 0; i--){
+        out.push_back((value >> (8*i)) & 0xFF);
+    }
+}
+
+static uint64_t readLong(const BytesView view, unsigned long& pos, int len){
+    if(pos + len > view.getLen()){
+        throw std::runtime_error("search filters are corrupted (cut off)");
+    }
+    uint64_t value = 0;
+    for(int i=0; i < len; i++){
+        value = value << 8 | view[pos + i];
+    }
+    pos += len;
+    return value;
+}
+
+static bool mayContain(const std::vector<uint64_t>& filter, uint64_t hash){
+    //double hashing: the probes are h1 + i*h2
+    uint64_t bits = filter.size() * 64;
+    uint64_t h1 = hash & 0xFFFFFFFF;
+    uint64_t h2 = (hash >> 32) | 1;
+    for(int i=0; i < SearchFilter::PROBES; i++){
+        uint64_t bit = (h1 + i*h2) % bits;
+        if((filter[bit / 64] & (1ULL << (bit % 64))) == 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+static void addHash(std::vector<uint64_t>& filter, uint64_t hash){
+    uint64_t bits = filter.size() * 64;
+    uint64_t h1 = hash & 0xFFFFFFFF;
+    uint64_t h2 = (hash >> 32) | 1;
+    for(int i=0; i < SearchFilter::PROBES; i++){
+        uint64_t bit = (h1 + i*h2) % bits;
+        filter[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+SearchFilter::SearchFilter(unsigned char const cipher_mode, const Bytes datakey){
+    if(!CipherModes::isAuthenticated(cipher_mode)){
+        throw std::invalid_argument("search filters need an authenticated cipher mode");
+    }
+    this->cipher_mode = cipher_mode;
+    this->enc_key = CipherModes::deriveKey(datakey, "search");
+    this->token_key = CipherModes::deriveKey(datakey, "search-token");
+    this->covered_len = 0;
+    this->next_seq = 0;
+}
+
+uint64_t SearchFilter::hashToken(uint32_t trigram) const{
+    std::string token = {(char)(trigram >> 16), (char)(trigram >> 8), (char)trigram};
+    Bytes hash = CipherModes::deriveKey(this->token_key, token);    //HMAC-SHA256 of the trigram
+    unsigned long pos = 0;
+    return readLong(hash.getView(), pos, 8);
+}
+
+void SearchFilter::addSegment(unsigned long begin, unsigned long end, const std::vector<unsigned long> offsets, const std::vector<std::string> texts){
+    if(end < begin || (!this->segments.empty() && begin < this->segments.back().end)){
+        throw std::invalid_argument("segments have to be added in the order of the log and cannot overlap");
+    }
+    std::unordered_set<uint32_t> trigrams;
+    for(const std::string& text : texts){
+        std::unordered_set<uint32_t> t = getTrigrams(toLower(text));
+        trigrams.insert(t.begin(), t.end());
+    }
+    unsigned long bits = (trigrams.size() * BITS_PER_TOKEN + 63) / 64 * 64;
+    bits = std::min(std::max(bits, MIN_FILTER_BITS), SEARCH_FILTER_MAX_BITS);
+    SearchSegment segment;
+    segment.begin = begin;
+    segment.end = end;
+    segment.offsets = offsets;
+    segment.filter.assign(bits / 64, 0);
+    for(uint32_t trigram : trigrams){
+        auto cached = this->token_cache.find(trigram);
+        if(cached == this->token_cache.end()){
+            cached = this->token_cache.emplace(trigram, this->hashToken(trigram)).first;    //most trigrams occur in many records
+        }
+        addHash(segment.filter, cached->second);
+    }
+    this->segments.push_back(std::move(segment));
+}
+
+Bytes SearchFilter::encode(unsigned long covered_len, unsigned long next_seq, const Bytes log_id) const{
+    if(log_id.getLen() != 32){
+        throw std::length_error("log id has to be 32 bytes long");
+    }
+    //the prefix is stored readable and encrypted, so it cannot be changed unnoticed
+    std::vector<unsigned char> plain(FILTER_MAGIC.begin(), FILTER_MAGIC.end());
+    appendLong(plain, covered_len, 8);
+    appendLong(plain, next_seq, 8);
+    std::vector<unsigned char> id = log_id.getBytes();
+    plain.insert(plain.end(), id.begin(), id.end());
+    std::vector<unsigned char> prefix = plain;
+    appendLong(plain, this->segments.size(), 8);
+    for(const SearchSegment& segment : this->segments){
+        appendLong(plain, segment.begin, 8);
+        appendLong(plain, segment.end, 8);
+        appendLong(plain, segment.offsets.size(), 4);
+        appendLong(plain, segment.filter.size(), 4);
+        for(unsigned long offset : segment.offsets){
+            appendLong(plain, offset, 8);
+        }
+        for(uint64_t word : segment.filter){
+            appendLong(plain, word, 8);
+        }
+    }
+    Bytes plain_bytes;
+    plain_bytes.setBytes(plain);
+    Bytes file;
+    file.setBytes(prefix);
+    file.addBytes(CipherModes::encrypt(this->cipher_mode, this->enc_key, plain_bytes));
+    return file;
+}
+
+void SearchFilter::load(const BytesView file){
+    if(file.getLen() < PREFIX_LEN || std::string(file.data(), file.data() + 4) != FILTER_MAGIC){
+        throw std::runtime_error("search filters are corrupted (no filter prefix)");
+    }
+    Bytes plain = CipherModes::decrypt(this->cipher_mode, this->enc_key, file.slice(PREFIX_LEN, file.getLen() - PREFIX_LEN).toBytes());
+    BytesView p = plain.getView();
+    if(p.getLen() < PREFIX_LEN + 8 || std::memcmp(p.data(), file.data(), PREFIX_LEN) != 0){
+        throw std::runtime_error("search filters are corrupted (prefix was modified)");
+    }
+    unsigned long pos = 4;
+    unsigned long covered_len = readLong(p, pos, 8);
+    unsigned long next_seq = readLong(p, pos, 8);
+    Bytes log_id = p.slice(pos, 32).toBytes();
+    pos += 32;
+    unsigned long count = readLong(p, pos, 8);
+    std::vector<SearchSegment> segments;
+    for(unsigned long i=0; i < count; i++){
+        SearchSegment segment;
+        segment.begin = readLong(p, pos, 8);
+        segment.end = readLong(p, pos, 8);
+        unsigned long offsets = readLong(p, pos, 4);
+        unsigned long words = readLong(p, pos, 4);
+        if(words == 0 || pos + (offsets + words) * 8 > p.getLen()){
+            throw std::runtime_error("search filters are corrupted (segment is cut off)");
+        }
+        for(unsigned long j=0; j < offsets; j++){
+            segment.offsets.push_back(readLong(p, pos, 8));
+        }
+        for(unsigned long j=0; j < words; j++){
+            segment.filter.push_back(readLong(p, pos, 8));
+        }
+        segments.push_back(std::move(segment));
+    }
+    if(pos != p.getLen()){
+        throw std::runtime_error("search filters are corrupted (wrong number of segments)");
+    }
+    this->segments = std::move(segments);
+    this->covered_len = covered_len;
+    this->next_seq = next_seq;
+    this->log_id = log_id;
+}
+
+std::vector<unsigned long> SearchFilter::getCandidates(const std::string query) const{
+    std::vector<uint64_t> hashes;
+    for(uint32_t trigram : getTrigrams(toLower(query))){
+        hashes.push_back(this->hashToken(trigram));
+    }
+    std::vector<unsigned long> candidates;
+    for(unsigned long i=0; i < this->segments.size(); i++){
+        bool candidate = std::all_of(hashes.begin(), hashes.end(), [this, i](uint64_t hash){
+            return mayContain(this->segments[i].filter, hash);
+        });
+        if(candidate){
+            candidates.push_back(i);    //short queries have no trigrams, every segment is a candidate
+        }
+    }
+    return candidates;
+}
+
+const SearchSegment& SearchFilter::getSegment(unsigned long index) const{
+    if(index >= this->segments.size()){
+        throw std::range_error("segment does not exist");
+    }
+    return this->segments[index];
+}
+
+unsigned long SearchFilter::getSegmentNumber() const noexcept{
+    return this->segments.size();
+}
+
+unsigned long SearchFilter::getCoveredLen() const noexcept{
+    return this->covered_len;
+}
+
+unsigned long SearchFilter::getNextSeq() const noexcept{
+    return this->next_seq;
+}
+
+Bytes SearchFilter::getLogId() const noexcept{
+    return this->log_id;
+}
+
+std::vector<std::string> SearchFilter::getSearchText(const std::string name, const BytesView value){
+    std::vector<std::string> texts = {name};
+    try{
+        EntryView entry(value);
+        if(entry.getLen() == value.getLen()){
+            //the secret is never searchable
+            for(unsigned char field : {EntryView::FIELD_TITLE, EntryView::FIELD_USERNAME, EntryView::FIELD_URL, EntryView::FIELD_NOTES}){
+                texts.push_back(entry.getFieldString(field));
+            }
+        }
+    }catch(std::exception&){
+        //not an entry record, only the name is searchable
+    }
+    return texts;
+}
+
+bool SearchFilter::matches(const std::string name, const BytesView value, const std::string query){
+    std::string lower = toLower(query);
+    for(const std::string& text : SearchFilter::getSearchText(name, value)){
+        if(toLower(text).find(lower) != std::string::npos){
+            return true;
+        }
+    }
+    return false;
+}
+
+std::filesystem::path SearchFilter::getFilterPath(const std::filesystem::path vault_path){
+    std::filesystem::path filter_path = vault_path;
+    filter_path += ".flt";
+    return filter_path;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include "secure_buffer.h"
+
+SecureBuffer::SecureBuffer() noexcept{
+    this->data = nullptr;
+    this->len = 0;
+    this->cap = 0;
+    this->locked = false;
+}
+
+SecureBuffer::SecureBuffer(const BytesView bytes) : SecureBuffer(){
+    if(bytes.isEmpty()){
+        return;
+    }
+    this->allocate(bytes.getLen());
+    this->len = bytes.getLen();
+    std::memcpy(this->data, bytes.data(), this->len);
+}
+
+void SecureBuffer::allocate(unsigned long min_len){
+#if defined(_WIN32)
+    this->cap = min_len;
+    this->data = new unsigned char[this->cap];
+#else
+    unsigned long page = sysconf(_SC_PAGESIZE);
+    this->cap = (min_len + page - 1) / page * page;
+    void* pages = mmap(nullptr, this->cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(pages == MAP_FAILED){
+        this->cap = 0;
+        throw std::bad_alloc();
+    }
+    this->data = static_cast<unsigned char*>(pages);
+    this->locked = mlock(this->data, this->cap) == 0;
+#if defined(MADV_DONTDUMP)
+    madvise(this->data, this->cap, MADV_DONTDUMP);
+#endif
+#endif
+}
+
+SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept : SecureBuffer(){
+    *this = std::move(other);
+}
+
+SecureBuffer& SecureBuffer::operator=(SecureBuffer&& other) noexcept{
+    if(this != &other){
+        this->release();
+        this->data = other.data;
+        this->len = other.len;
+        this->cap = other.cap;
+        this->locked = other.locked;
+        other.data = nullptr;
+        other.len = 0;
+        other.cap = 0;
+        other.locked = false;
+    }
+    return *this;
+}
+
+SecureBuffer::~SecureBuffer(){
+    this->release();
+}
+
+void SecureBuffer::release() noexcept{
+    if(this->data == nullptr){
+        return;
+    }
+    OPENSSL_cleanse(this->data, this->cap);     //cannot be optimized away like memset
+#if defined(_WIN32)
+    delete[] this->data;
+#else
+    if(this->locked){
+        munlock(this->data, this->cap);
+    }
+    munmap(this->data, this->cap);
+#endif
+    this->data = nullptr;
+    this->len = 0;
+    this->cap = 0;
+    this->locked = false;
+}
+
+BytesView SecureBuffer::getView() const noexcept{
+    return BytesView(this->data, this->len);
+}
+
+unsigned long SecureBuffer::getLen() const noexcept{
+    return this->len;
+}
+
+bool SecureBuffer::isEmpty() const noexcept{
+    return this->len == 0;
+}
+
+bool SecureBuffer::isLocked() const noexcept{
+    return this->locked;
+}
+
+void SecureBuffer::append(const BytesView bytes){
+    if(bytes.isEmpty()){
+        return;
+    }
+    if(this->len + bytes.getLen() > this->cap){
+        SecureBuffer grown;
+        grown.allocate(std::max(2 * this->cap, this->len + bytes.getLen()));
+        if(this->len > 0){
+            std::memcpy(grown.data, this->data, this->len);
+        }
+        grown.len = this->len;
+        *this = std::move(grown);   //releases (zeroizes) the old pages
+    }
+    std::memcpy(this->data + this->len, bytes.data(), bytes.getLen());
+    this->len += bytes.getLen();
+}
+
+void SecureBuffer::clear() noexcept{
+    this->release();
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include "segment_mac.h"
+
+static const std::string TRAILER_MAGIC = "PMAC";
+
+static EVP_MAC* getHmac(){
+    //the hmac implementation is fetched once when the first mac is calculated (not at startup and not for every segment)
+    static EVP_MAC* hmac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    return hmac;
+}
+
+Bytes SegmentMac::calcMac(const Bytes key, unsigned long index, const unsigned char* segment, unsigned long len){
+    if(key.isEmpty()){
+        throw std::invalid_argument("mac key is empty");
+    }
+    std::vector<unsigned char> k = key.getBytes();
+    std::vector<unsigned char> prefix = fromLong(index).getBytes();     //the index is part of the mac, so segments cannot be swapped
+    std::vector<unsigned char> segment_len = fromLong(len).getBytes();
+    prefix.insert(prefix.end(), segment_len.begin(), segment_len.end());
+
+    EVP_MAC* mac = getHmac();
+    EVP_MAC_CTX* ctx = mac == nullptr ? nullptr : EVP_MAC_CTX_new(mac);
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0), OSSL_PARAM_construct_end()};
+    unsigned char out[MAC_LEN];
+    size_t out_len = 0;
+    bool ok = ctx != nullptr
+        && EVP_MAC_init(ctx, k.data(), k.size(), params) == 1
+        && EVP_MAC_update(ctx, prefix.data(), prefix.size()) == 1
+        && EVP_MAC_update(ctx, segment, len) == 1
+        && EVP_MAC_final(ctx, out, &out_len, sizeof(out)) == 1;
+    EVP_MAC_CTX_free(ctx);
+    if(!ok || out_len != MAC_LEN){
+        throw std::runtime_error("Error occured in calcMac");
+    }
+    Bytes ret;
+    ret.setBytes(std::vector<unsigned char>(out, out + MAC_LEN));
+    return ret;
+}
+
+static unsigned int getThreads(unsigned int threads, unsigned long count){
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::min<unsigned long>(threads, std::max(1UL, count));
+}
+
+static void runParallel(unsigned long count, unsigned int threads, const std::function<void(unsigned long)> work){
+    //each worker takes the next segment until all segments are done
+    std::atomic<unsigned long> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t < getThreads(threads, count); t++){
+        workers.emplace_back([&](){
+            for(unsigned long i = next++; i < count; i = next++){
+                try{
+                    work(i);
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error){
+                        error = std::current_exception();
+                    }
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    if(error){
+        std::rethrow_exception(error);
+    }
+}
+
+Bytes SegmentMac::createTrailer(const Bytes key, const Bytes data, unsigned long segment_size){
+    return SegmentMac::createTrailer(key, data.getView(), segment_size, 1);
+}
+
+Bytes SegmentMac::createTrailer(const Bytes key, const BytesView data, unsigned long segment_size, unsigned int threads){
+    if(segment_size == 0 || segment_size > 0xFFFFFFFF){
+        throw std::range_error("segment size has to fit into 4 bytes and cannot be zero");
+    }
+    unsigned long count = (data.getLen() + segment_size - 1) / segment_size;
+    std::vector<unsigned char> macs(count*MAC_LEN);
+    runParallel(count, threads, [&](unsigned long i){
+        unsigned long len = std::min(segment_size, data.getLen() - i*segment_size);
+        std::vector<unsigned char> mac = SegmentMac::calcMac(key, i, data.data() + i*segment_size, len).getBytes();
+        std::copy(mac.begin(), mac.end(), macs.begin() + i*MAC_LEN);
+    });
+    Bytes trailer;
+    trailer.setBytes(macs);
+    trailer.addBytes(fromLong(segment_size, 4));
+    trailer.addBytes(fromLong(count));
+    for(char c : TRAILER_MAGIC){
+        trailer.addByte(c);
+    }
+    return trailer;
+}
+
+unsigned long SegmentMac::getTrailerLen(const Bytes data){
+    return SegmentMac::getTrailerLen(data.getView());
+}
+
+unsigned long SegmentMac::getTrailerLen(const BytesView data){
+    if(data.getLen() < TRAILER_FOOTER_LEN || std::string(data.data() + data.getLen() - 4, data.data() + data.getLen()) != TRAILER_MAGIC){
+        return 0;   //no trailer at the end of the data
+    }
+    BytesView footer = data.slice(data.getLen() - TRAILER_FOOTER_LEN, TRAILER_FOOTER_LEN - 4);
+    unsigned long segment_size = toLong(footer.slice(0, 4));
+    unsigned long count = toLong(footer.slice(4, 8));
+    if(segment_size == 0 || count > (data.getLen() - TRAILER_FOOTER_LEN) / MAC_LEN){
+        throw std::length_error("mac trailer is corrupted or cut off");
+    }
+    unsigned long trailer_len = count*MAC_LEN + TRAILER_FOOTER_LEN;
+    unsigned long data_len = data.getLen() - trailer_len;
+    if((data_len + segment_size - 1) / segment_size != count){
+        throw std::length_error("number of macs does not match with the length of the data");
+    }
+    return trailer_len;
+}
+
+ScrubReport SegmentMac::scrub(const Bytes key, const Bytes data, unsigned int threads){
+    BytesView view = data.getView();
+    unsigned long trailer_len = SegmentMac::getTrailerLen(view);
+    if(trailer_len == 0){
+        throw std::runtime_error("no mac trailer found");
+    }
+    return SegmentMac::scrub(key, view.slice(0, view.getLen() - trailer_len), view.slice(view.getLen() - trailer_len, trailer_len), threads);
+}
+
+ScrubReport SegmentMac::scrub(const Bytes key, const BytesView data, const BytesView trailer, unsigned int threads){
+    auto start = std::chrono::steady_clock::now();
+    if(trailer.getLen() < TRAILER_FOOTER_LEN || std::string(trailer.data() + trailer.getLen() - 4, trailer.data() + trailer.getLen()) != TRAILER_MAGIC){
+        throw std::runtime_error("no mac trailer found");
+    }
+    BytesView footer = trailer.slice(trailer.getLen() - TRAILER_FOOTER_LEN, TRAILER_FOOTER_LEN - 4);
+    unsigned long segment_size = toLong(footer.slice(0, 4));
+    unsigned long count = toLong(footer.slice(4, 8));
+    if(segment_size == 0 || trailer.getLen() != count*MAC_LEN + TRAILER_FOOTER_LEN || (data.getLen() + segment_size - 1) / segment_size != count){
+        throw std::length_error("number of macs does not match with the length of the data");
+    }
+    ScrubReport report;
+    std::mutex report_mutex;
+    runParallel(count, threads, [&](unsigned long i){
+        unsigned long len = std::min(segment_size, data.getLen() - i*segment_size);
+        std::vector<unsigned char> mac = SegmentMac::calcMac(key, i, data.data() + i*segment_size, len).getBytes();
+        if(CRYPTO_memcmp(mac.data(), trailer.data() + i*MAC_LEN, MAC_LEN) != 0){
+            std::lock_guard<std::mutex> lock(report_mutex);
+            report.damaged.push_back(i*segment_size);
+        }
+    });
+    std::sort(report.damaged.begin(), report.damaged.end());
+    report.segments = count;
+    report.bytes = data.getLen();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+Bytes SegmentMac::createTable(const Bytes key, const BytesView data, unsigned int threads){
+    Bytes table = fromLong(data.getLen());
+    table.addBytes(SegmentMac::createTrailer(key, data, SEGMENT_SIZE, threads));
+    return table;
+}
+
+ScrubReport SegmentMac::scrubTable(const Bytes key, const BytesView file, const BytesView table, unsigned int threads){
+    if(table.getLen() < 8){
+        throw std::runtime_error("no mac table found");
+    }
+    unsigned long covered_len = toLong(table.slice(0, 8));
+    BytesView trailer = table.slice(8, table.getLen() - 8);
+    if(file.getLen() >= covered_len){
+        ScrubReport report = SegmentMac::scrub(key, file.slice(0, covered_len), trailer, threads);
+        report.unchecked = file.getLen() - covered_len;
+        return report;
+    }
+    //the file was cut off: the segments that are still there are checked, the cut off segment counts as damaged
+    std::vector<unsigned char> padded(file.data(), file.data() + file.getLen());
+    padded.resize(covered_len, 0);
+    return SegmentMac::scrub(key, BytesView(padded), trailer, threads);
+}
+
+std::filesystem::path SegmentMac::getTablePath(const std::filesystem::path vault_path){
+    std::filesystem::path table_path = vault_path;
+    table_path += ".mac";
+    return table_path;
+}
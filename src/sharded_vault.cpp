@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <thread>
+#include <openssl/crypto.h>
+#include "sharded_vault.h"
+#include "mapped_vault.h"
+
+static const std::string MANIFEST_MAGIC = "PSHM";
+static const std::string SHARD_PREFIX = "shard-";
+
+static void runParallel(unsigned long count, unsigned int threads, const std::function<void(unsigned long)> work){
+    //each worker takes the next index until all are done, the first exception is thrown again after all workers have finished
+    threads = std::min<unsigned long>(threads, std::max(1UL, count));
+    std::atomic<unsigned long> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t < threads; t++){
+        workers.emplace_back([&](){
+            for(unsigned long i = next++; i < count; i = next++){
+                try{
+                    work(i);
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error){
+                        error = std::current_exception();
+                    }
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    if(error){
+        std::rethrow_exception(error);
+    }
+}
+
+static unsigned int getThreads(unsigned int threads){
+    return threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+}
+
+static Bytes encodeManifest(const Bytes manifest_key, unsigned long generation, const std::vector<std::pair<unsigned long, unsigned long>> entries){
+    //shard table (magic, generation, number of shards, generation and log length of each shard) and its mac
+    Bytes table;
+    for(char c : MANIFEST_MAGIC){
+        table.addByte(c);
+    }
+    table.addBytes(fromLong(generation));
+    table.addBytes(fromLong(entries.size(), 4));
+    for(const std::pair<unsigned long, unsigned long>& entry : entries){
+        table.addBytes(fromLong(entry.first));
+        table.addBytes(fromLong(entry.second));
+    }
+    BytesView view = table.getView();
+    table.addBytes(CipherModes::deriveKey(manifest_key, std::string(view.data(), view.data() + view.getLen())));
+    return table;
+}
+
+ShardedVault::ShardedVault(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, unsigned int threads) : ShardedVault(dir, header, datakey, std::optional<std::string>(), threads){
+}
+
+ShardedVault::ShardedVault(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, const std::optional<std::string> only_name, unsigned int threads){
+    this->dir = dir;
+    this->header = header.getHeaderBytes();
+    this->cipher_mode = header.getCipherMode();
+    this->compression_mode = header.getCompressionMode();
+    if(!CipherModes::isAuthenticated(this->cipher_mode)){
+        throw std::invalid_argument("sharded vaults need an authenticated cipher mode");
+    }
+    this->shard_key = CipherModes::deriveKey(datakey, "shard");
+    this->name_key = CipherModes::deriveKey(datakey, "shard-name");
+    this->manifest_key = CipherModes::deriveKey(datakey, "shard-manifest");
+    this->mac_key = CipherModes::deriveKey(datakey, "mac");
+    this->generation = 0;
+    this->lock_timeout = LOCK_TIMEOUT_MS;
+    if(!ShardedVault::isShardedVault(dir)){
+        throw std::invalid_argument("no sharded vault: " + dir.string());
+    }
+    FileLock file_lock(ShardedVault::getManifestPath(dir), false, this->lock_timeout);
+    std::vector<std::pair<unsigned long, unsigned long>> entries = this->readManifest();
+    std::vector<unsigned long> indices;
+    for(unsigned long i=0; i < entries.size(); i++){
+        this->shards.push_back(Shard{this->newShardLog(i, entries[i].first), entries[i].first, false});
+        indices.push_back(i);
+    }
+    if(only_name.has_value()){
+        indices = {this->getShardOf(only_name.value())};    //the other shards stay empty
+    }
+    this->loadShards(entries, indices, threads);
+}
+
+RecordLog ShardedVault::newShardLog(unsigned long index, unsigned long generation) const{
+    return RecordLog(this->cipher_mode, CipherModes::deriveKey(this->shard_key, std::to_string(index) + "." + std::to_string(generation)), this->compression_mode);
+}
+
+std::vector<std::pair<unsigned long, unsigned long>> ShardedVault::readManifest() const{
+    MappedVault manifest(ShardedVault::getManifestPath(this->dir));
+    if(!(manifest.getHeader().toBytes() == this->header)){
+        throw std::invalid_argument("data header of the manifest does not match with the given header");
+    }
+    BytesView body = manifest.getBody();
+    if(body.getLen() < MANIFEST_PREFIX_LEN + MAC_LEN || std::string(body.data(), body.data() + 4) != MANIFEST_MAGIC){
+        throw std::runtime_error("manifest is corrupted (no shard table)");
+    }
+    unsigned long shard_number = toLong(body.slice(12, 4));
+    if(body.getLen() != MANIFEST_PREFIX_LEN + shard_number*SHARD_ENTRY_LEN + MAC_LEN){
+        throw std::runtime_error("manifest is corrupted (length does not match with the number of shards)");
+    }
+    BytesView table = body.slice(0, body.getLen() - MAC_LEN);
+    Bytes mac = CipherModes::deriveKey(this->manifest_key, std::string(table.data(), table.data() + table.getLen()));
+    if(CRYPTO_memcmp(mac.getView().data(), body.slice(table.getLen(), MAC_LEN).data(), MAC_LEN) != 0){
+        throw std::runtime_error("manifest was modified or the data key is wrong");
+    }
+    std::vector<std::pair<unsigned long, unsigned long>> entries;
+    for(unsigned long i=0; i < shard_number; i++){
+        BytesView entry = table.slice(MANIFEST_PREFIX_LEN + i*SHARD_ENTRY_LEN, SHARD_ENTRY_LEN);
+        entries.emplace_back(toLong(entry.slice(0, 8)), toLong(entry.slice(8, 8)));
+    }
+    return entries;
+}
+
+void ShardedVault::loadShards(const std::vector<std::pair<unsigned long, unsigned long>> entries, const std::vector<unsigned long> indices, unsigned int threads){
+    auto start = std::chrono::steady_clock::now();
+    threads = std::min<unsigned long>(getThreads(threads), std::max(1UL, indices.size()));
+    std::atomic<unsigned long> bytes{0};
+    runParallel(indices.size(), threads, [&](unsigned long i){
+        unsigned long index = indices[i];
+        unsigned long log_len = entries[index].second;
+        Shard& shard = this->shards[index];
+        shard.log = this->newShardLog(index, entries[index].first);
+        shard.generation = entries[index].first;
+        shard.dirty = false;
+        if(log_len == 0){
+            return;     //empty shards have no file
+        }
+        std::ifstream file(ShardedVault::getShardPath(this->dir, index, entries[index].first), std::ios::binary);
+        std::vector<unsigned char> log((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        //the shard is written before the manifest, so a shorter log is damage and not a cut off append
+        //the mac trailer behind the log is checked by pman scrub, not here (the frames are authenticated)
+        if(log.size() < log_len || (log.size() > log_len && SegmentMac::getTrailerLen(BytesView(log)) != log.size() - log_len)
+            || shard.log.load(BytesView(log).slice(0, log_len)) != log_len){
+            throw std::runtime_error("shard " + std::to_string(index) + " is missing or corrupted");
+        }
+        bytes += log_len;
+    });
+    this->generation = 0;
+    for(const std::pair<unsigned long, unsigned long>& entry : entries){
+        this->generation = std::max(this->generation, entry.first);
+    }
+    this->last_load.shards = this->shards.size();
+    this->last_load.bytes = bytes;
+    this->last_load.threads = threads;
+    this->last_load.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShardedVault::put(const std::string name, const Bytes value){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Shard& shard = this->shards[this->getShardOf(name)];
+    shard.log.put(name, value);
+    shard.dirty = true;
+}
+
+bool ShardedVault::remove(const std::string name){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Shard& shard = this->shards[this->getShardOf(name)];
+    if(!shard.log.remove(name).has_value()){
+        return false;
+    }
+    shard.dirty = true;
+    return true;
+}
+
+std::optional<Bytes> ShardedVault::get(const std::string name) const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->shards[this->getShardOf(name)].log.get(name);
+}
+
+std::vector<std::string> ShardedVault::getNames() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<std::string> names;
+    for(const Shard& shard : this->shards){
+        std::vector<std::string> shard_names = shard.log.getNames();
+        names.insert(names.end(), shard_names.begin(), shard_names.end());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+unsigned long ShardedVault::getRecordNumber() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    unsigned long number = 0;
+    for(const Shard& shard : this->shards){
+        number += shard.log.getRecordNumber();
+    }
+    return number;
+}
+
+unsigned long ShardedVault::getShardNumber() const noexcept{
+    return this->shards.size();
+}
+
+unsigned long ShardedVault::getShardOf(const std::string name) const{
+    if(name.empty()){
+        throw std::length_error("record name has to be between 1 and 65535 bytes long");
+    }
+    Bytes hash = CipherModes::deriveKey(this->name_key, name);     //HMAC-SHA256 of the name
+    return toLong(hash.getView().slice(0, 8)) % this->shards.size();
+}
+
+std::vector<unsigned long> ShardedVault::getDirtyShards() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<unsigned long> dirty;
+    for(unsigned long i=0; i < this->shards.size(); i++){
+        if(this->shards[i].dirty){
+            dirty.push_back(i);
+        }
+    }
+    return dirty;
+}
+
+ShardLoadReport ShardedVault::getLastLoad() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->last_load;
+}
+
+SaveReport ShardedVault::getLastSave() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->last_save;
+}
+
+void ShardedVault::setLockTimeout(long timeout_ms) noexcept{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->lock_timeout = timeout_ms;
+}
+
+SaveReport ShardedVault::save(unsigned int threads){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<unsigned long> dirty;
+    for(unsigned long i=0; i < this->shards.size(); i++){
+        if(this->shards[i].dirty){
+            dirty.push_back(i);
+        }
+    }
+    if(dirty.empty()){
+        return SaveReport();
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::filesystem::path manifest_path = ShardedVault::getManifestPath(this->dir);
+    FileLock file_lock(manifest_path, true, this->lock_timeout);
+    std::vector<std::pair<unsigned long, unsigned long>> entries = this->readManifest();
+    if(entries.size() != this->shards.size()){
+        throw std::runtime_error("number of shards was changed by another process");
+    }
+    //shards that another process wrote are read again, a dirty one cannot be merged
+    std::vector<unsigned long> changed;
+    for(unsigned long i=0; i < entries.size(); i++){
+        if(entries[i].first != this->shards[i].generation){
+            if(this->shards[i].dirty){
+                throw std::runtime_error("shard " + std::to_string(i) + " was changed by another process");
+            }
+            changed.push_back(i);
+        }
+    }
+    if(!changed.empty()){
+        ShardLoadReport load = this->last_load;
+        this->loadShards(entries, changed, threads);
+        this->last_load = load;
+    }
+    unsigned long generation = 0;
+    for(const std::pair<unsigned long, unsigned long>& entry : entries){
+        generation = std::max(generation, entry.first);
+    }
+    generation = std::max(generation, this->generation) + 1;
+
+    //the dirty shards are written into new files with the key of the new generation (one encryption per record)
+    std::vector<RecordLog> logs(dirty.size(), this->newShardLog(0, 0));
+    std::atomic<unsigned long> bytes{0};
+    runParallel(dirty.size(), getThreads(threads), [&](unsigned long i){
+        unsigned long index = dirty[i];
+        const RecordLog& old_log = this->shards[index].log;
+        logs[i] = this->newShardLog(index, generation);
+        std::vector<unsigned char> log;
+        for(const std::string& name : old_log.getNames()){
+            Bytes frame = logs[i].put(name, old_log.get(name).value());
+            BytesView view = frame.getView();
+            log.insert(log.end(), view.data(), view.data() + view.getLen());
+        }
+        if(!log.empty()){
+            Bytes trailer = SegmentMac::createTrailer(this->mac_key, BytesView(log), SEGMENT_SIZE, 1);    //the shards are already written in parallel
+            bytes += AtomicWriter::writeFile(ShardedVault::getShardPath(this->dir, index, generation), {BytesView(log), trailer.getView()}).bytes;
+        }
+        entries[index] = {generation, log.size()};
+    });
+    Bytes manifest = encodeManifest(this->manifest_key, generation, entries);
+    bytes += AtomicWriter::writeFile(manifest_path, {this->header.getView(), manifest.getView()}).bytes;
+    for(unsigned long i=0; i < dirty.size(); i++){
+        Shard& shard = this->shards[dirty[i]];
+        shard.log = logs[i];
+        shard.generation = generation;
+        shard.dirty = false;
+    }
+    this->generation = generation;
+
+    //old generations and files of failed saves are not referenced by the manifest anymore
+    std::set<std::string> referenced;
+    for(unsigned long i=0; i < entries.size(); i++){
+        referenced.insert(ShardedVault::getShardPath(this->dir, i, entries[i].first).filename().string());
+    }
+    try{
+        for(const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(this->dir)){
+            std::string filename = file.path().filename().string();
+            if(filename.rfind(SHARD_PREFIX, 0) == 0 && referenced.count(filename) == 0){
+                std::filesystem::remove(file.path());
+            }
+        }
+    }catch(std::filesystem::filesystem_error&){
+        //removed by the next save
+    }
+    this->last_save.bytes = bytes;
+    this->last_save.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return this->last_save;
+}
+
+std::optional<Bytes> ShardedVault::lookup(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, const std::string name){
+    //the vault only knows the shard of the name, so it is never saved or given out
+    ShardedVault vault(dir, header, datakey, name, 1);
+    return vault.get(name);
+}
+
+std::vector<std::pair<std::filesystem::path, ScrubReport>> ShardedVault::scrub(const std::filesystem::path dir, const Bytes datakey, unsigned int threads){
+    FileLock file_lock(ShardedVault::getManifestPath(dir), false);
+    std::vector<std::filesystem::path> files;
+    for(const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(dir)){
+        if(file.path().filename().string().rfind(SHARD_PREFIX, 0) == 0){
+            files.push_back(file.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    Bytes mac_key = CipherModes::deriveKey(datakey, "mac");
+    std::vector<std::pair<std::filesystem::path, ScrubReport>> reports;
+    for(const std::filesystem::path& file : files){
+        std::vector<unsigned char> shard = AtomicWriter::readFile(file);    //shards have no data header (not a MappedVault)
+        BytesView view(shard);
+        unsigned long trailer_len = SegmentMac::getTrailerLen(view);
+        if(trailer_len == 0){
+            throw std::runtime_error("shard has no mac trailer: " + file.filename().string());
+        }
+        reports.emplace_back(file, SegmentMac::scrub(mac_key, view.slice(0, view.getLen() - trailer_len), view.slice(view.getLen() - trailer_len, trailer_len), threads));
+    }
+    return reports;
+}
+
+void ShardedVault::create(const std::filesystem::path dir, const DataHeader& header, const Bytes datakey, unsigned long shard_number){
+    if(shard_number == 0 || shard_number > MAX_SHARD_NUMBER){
+        throw std::range_error("number of shards has to be between 1 and " + std::to_string(MAX_SHARD_NUMBER));
+    }
+    if(std::filesystem::exists(dir) && (!std::filesystem::is_directory(dir) || !std::filesystem::is_empty(dir))){
+        throw std::invalid_argument("vault directory exists and is not empty: " + dir.string());
+    }
+    std::filesystem::create_directories(dir);
+    Bytes manifest = encodeManifest(CipherModes::deriveKey(datakey, "shard-manifest"), 0, std::vector<std::pair<unsigned long, unsigned long>>(shard_number, {0, 0}));
+    Bytes header_bytes = header.getHeaderBytes();
+    FileLock file_lock(ShardedVault::getManifestPath(dir), true);
+    AtomicWriter::writeFile(ShardedVault::getManifestPath(dir), {header_bytes.getView(), manifest.getView()});
+}
+
+bool ShardedVault::isShardedVault(const std::filesystem::path path) noexcept{
+    std::error_code error;
+    return std::filesystem::is_directory(path, error) && std::filesystem::exists(ShardedVault::getManifestPath(path), error);
+}
+
+std::filesystem::path ShardedVault::getManifestPath(const std::filesystem::path dir){
+    return dir / "manifest";
+}
+
+std::filesystem::path ShardedVault::getShardPath(const std::filesystem::path dir, unsigned long index, unsigned long generation){
+    return dir / (SHARD_PREFIX + std::to_string(index) + "." + std::to_string(generation));
+}
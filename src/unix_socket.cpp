@@ -0,0 +1,139 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "unix_socket.h"
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0      //macOS has no MSG_NOSIGNAL, SIGPIPE is ignored by the servers there
+#endif
+#if !defined(SOCK_CLOEXEC)
+#define SOCK_CLOEXEC 0
+#endif
+
+static sockaddr_un getAddress(const std::filesystem::path& path){
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.string().size() >= sizeof(addr.sun_path)){
+        throw std::length_error("socket path is too long");
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+
+int UnixSocket::listenOn(const std::filesystem::path path, int backlog){
+    sockaddr_un addr = getAddress(path);
+    if(path.has_parent_path() && !std::filesystem::exists(path.parent_path())){
+        std::filesystem::create_directories(path.parent_path());
+        chmod(path.parent_path().c_str(), 0700);
+    }
+    if(std::filesystem::exists(path)){
+        //a socket file is left if a server crashed, it is only replaced if nobody answers on it
+        int probe = UnixSocket::connectTo(path);
+        if(probe >= 0){
+            close(probe);
+            throw std::runtime_error("another process is listening on " + path.string());
+        }
+        std::filesystem::remove(path);
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        throw std::runtime_error(std::string("cannot create the socket: ") + std::strerror(errno));
+    }
+    mode_t old_mask = umask(0177);      //the socket is created with 0600
+    int bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    umask(old_mask);
+    if(bound != 0 || listen(fd, backlog) != 0){
+        std::string error = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("cannot bind the socket: " + error);
+    }
+    return fd;
+}
+
+int UnixSocket::connectTo(const std::filesystem::path path) noexcept{
+    sockaddr_un addr;
+    try{
+        addr = getAddress(path);
+    }catch(std::length_error&){
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        return -1;
+    }
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool UnixSocket::isSameUser(int fd) noexcept{
+#if defined(SO_PEERCRED)
+    ucred cred;
+    socklen_t len = sizeof(cred);
+    if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0){
+        return false;
+    }
+    return cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if(getpeereid(fd, &uid, &gid) != 0){
+        return false;
+    }
+    return uid == getuid();
+#endif
+}
+
+bool UnixSocket::hasPrivateDir(const std::filesystem::path path) noexcept{
+    std::filesystem::path dir = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    struct stat info;
+    if(lstat(dir.c_str(), &info) != 0){
+        return false;
+    }
+    return S_ISDIR(info.st_mode) && info.st_uid == getuid() && (info.st_mode & 0777) == 0700;
+}
+
+void UnixSocket::setTimeout(int fd, int ms) noexcept{
+    timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+bool UnixSocket::sendAll(int fd, const unsigned char* data, unsigned long len) noexcept{
+    while(len > 0){
+        ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+        if(sent < 0 && errno == EINTR){
+            continue;
+        }
+        if(sent <= 0){
+            return false;
+        }
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+bool UnixSocket::recvAll(int fd, unsigned char* data, unsigned long len) noexcept{
+    while(len > 0){
+        ssize_t got = recv(fd, data, len, 0);
+        if(got < 0 && errno == EINTR){
+            continue;
+        }
+        if(got <= 0){
+            return false;
+        }
+        data += got;
+        len -= got;
+    }
+    return true;
+}
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "vault_server.h"
+#include "unix_socket.h"
+#include "batch.h"
+
+static const int SEND_TIMEOUT_MS = 1000;        //a client that does not read its answers in this time is dropped
+static const int POLL_MS = 200;                 //workers and the accept loop check for stop in this interval
+static const std::chrono::seconds IDLE_TIMEOUT(30);    //idle clients are dropped, so they do not keep their sockets open forever
+
+VaultServer::VaultServer(const std::filesystem::path socket_path, LogVault& vault, unsigned int threads) : vault(vault){
+    this->socket_path = socket_path;
+    this->threads = threads != 0 ? threads : std::max(4u, std::thread::hardware_concurrency());
+    this->running = false;
+    for(unsigned int i=0; i < this->threads; i++){
+        this->latencies.push_back(std::make_unique<LatencySamples>());
+    }
+    this->publishAll();
+    this->listen_fd = UnixSocket::listenOn(socket_path, 128);
+    if(pipe(this->wake_fds) != 0){
+        close(this->listen_fd);
+        unlink(socket_path.c_str());
+        throw std::runtime_error("Cannot create the wake pipe of the server");
+    }
+    fcntl(this->wake_fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(this->wake_fds[1], F_SETFL, O_NONBLOCK);     //a worker never waits for the poll loop
+}
+
+VaultServer::~VaultServer(){
+    close(this->wake_fds[0]);
+    close(this->wake_fds[1]);
+    close(this->listen_fd);
+    unlink(this->socket_path.c_str());
+}
+
+void VaultServer::publishAll(){
+    this->vault_reloads = this->vault.getReloadCount();     //read first, a reload while the records are copied is published by the next check
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+    for(const std::string& name : this->vault.getNames()){
+        std::optional<Bytes> value = this->vault.get(name);
+        if(value.has_value()){
+            (*next)[name] = value.value();
+        }
+    }
+    std::atomic_store(&this->snapshot, std::shared_ptr<const Snapshot>(next));
+}
+
+bool VaultServer::refresh(){
+    std::lock_guard<std::mutex> lock(this->writer);
+    this->vault.refresh();
+    if(this->vault.getReloadCount() == this->vault_reloads){
+        return false;
+    }
+    this->publishAll();
+    return true;
+}
+
+void VaultServer::put(const std::string name, const Bytes value){
+    std::lock_guard<std::mutex> lock(this->writer);
+    this->vault.put(name, value);   //the change is saved before readers can see it
+    if(this->vault.getReloadCount() != this->vault_reloads){
+        this->publishAll();         //the vault read the changes of another process before the append
+        return;
+    }
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*std::atomic_load(&this->snapshot));
+    (*next)[name] = value;
+    std::atomic_store(&this->snapshot, std::shared_ptr<const Snapshot>(next));
+}
+
+bool VaultServer::remove(const std::string name){
+    std::lock_guard<std::mutex> lock(this->writer);
+    bool removed = this->vault.remove(name);
+    if(this->vault.getReloadCount() != this->vault_reloads){
+        this->publishAll();
+        return removed;
+    }
+    if(!removed){
+        return false;
+    }
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*std::atomic_load(&this->snapshot));
+    next->erase(name);
+    std::atomic_store(&this->snapshot, std::shared_ptr<const Snapshot>(next));
+    return true;
+}
+
+std::optional<Bytes> VaultServer::get(const std::string name) const{
+    std::shared_ptr<const Snapshot> current = std::atomic_load(&this->snapshot);
+    Snapshot::const_iterator it = current->find(name);
+    if(it == current->end()){
+        return {};
+    }
+    return it->second;
+}
+
+std::vector<std::string> VaultServer::getNames() const{
+    std::shared_ptr<const Snapshot> current = std::atomic_load(&this->snapshot);
+    std::vector<std::string> names;
+    names.reserve(current->size());
+    for(const std::pair<const std::string, Bytes>& entry : *current){
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+LatencyReport VaultServer::getLatencyReport(){
+    std::vector<double> all;
+    LatencyReport report;
+    for(std::unique_ptr<LatencySamples>& latency : this->latencies){
+        std::lock_guard<std::mutex> lock(latency->mutex);
+        all.insert(all.end(), latency->samples.begin(), latency->samples.end());
+        report.requests += latency->count;
+    }
+    if(all.empty()){
+        return report;
+    }
+    std::vector<double>::iterator p50 = all.begin() + (all.size() - 1) / 2;
+    std::nth_element(all.begin(), p50, all.end());
+    report.p50 = *p50;
+    std::vector<double>::iterator p99 = all.begin() + (all.size() - 1) * 99 / 100;
+    std::nth_element(all.begin(), p99, all.end());
+    report.p99 = *p99;
+    return report;
+}
+
+void VaultServer::answer(const std::string line, std::ostream& out){
+    if(line == "stats"){
+        LatencyReport report = this->getLatencyReport();
+        out << "ok " << report.requests << " " << report.p50 << " " << report.p99 << '\n';
+        return;
+    }
+    Batch::execute(*this, line, out);
+}
+
+bool VaultServer::serveRequests(Connection& connection, LatencySamples& samples){
+    char chunk[4096];
+    ssize_t got;
+    do{
+        got = recv(connection.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+    }while(got < 0 && errno == EINTR);
+    if(got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+        return true;    //the poll saw data that is gone (e.g. only a hangup that did not happen yet)
+    }
+    if(got <= 0){
+        return false;   //client disconnected
+    }
+    connection.last_request = std::chrono::steady_clock::now();
+    connection.buffer.append(chunk, got);
+    std::ostringstream out;
+    std::string::size_type begin = 0;
+    std::string::size_type end;
+    while((end = connection.buffer.find('\n', begin)) != std::string::npos){
+        std::string line = connection.buffer.substr(begin, end - begin);
+        begin = end + 1;
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        if(line.empty()){
+            continue;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        this->answer(line, out);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(samples.mutex);
+        if(samples.samples.size() < MAX_SAMPLES){
+            samples.samples.push_back(micros);
+        }else{
+            samples.samples[samples.count % MAX_SAMPLES] = micros;
+        }
+        samples.count++;
+    }
+    connection.buffer.erase(0, begin);
+    if(connection.buffer.size() > MAX_LINE_LEN){
+        out << "err line too long" << '\n';
+    }
+    std::string answers = out.str();
+    if(!answers.empty() && !UnixSocket::sendAll(connection.fd, reinterpret_cast<const unsigned char*>(answers.data()), answers.size())){
+        return false;
+    }
+    return connection.buffer.size() <= MAX_LINE_LEN;
+}
+
+void VaultServer::work(LatencySamples& samples){
+    while(true){
+        std::unique_ptr<Connection> connection;
+        {
+            std::unique_lock<std::mutex> lock(this->queue_mutex);
+            //stop cannot notify (it is called from signal handlers), so the workers wake up regularly
+            this->queue_cv.wait_for(lock, std::chrono::milliseconds(POLL_MS), [this](){return !this->ready.empty() || !this->running;});
+            if(!this->running){
+                return;
+            }
+            if(this->ready.empty()){
+                continue;
+            }
+            connection = std::move(this->ready.front());
+            this->ready.pop_front();
+        }
+        if(!this->serveRequests(*connection, samples)){
+            close(connection->fd);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->queue_mutex);
+            this->served.push_back(std::move(connection));
+        }
+        char wake = 0;
+        if(write(this->wake_fds[1], &wake, 1) < 0){
+            //the pipe is full, so the poll loop wakes up anyway
+        }
+    }
+}
+
+void VaultServer::run(){
+    this->running = true;
+    std::vector<std::thread> workers;
+    for(unsigned int i=0; i < this->threads; i++){
+        workers.emplace_back(&VaultServer::work, this, std::ref(*this->latencies[i]));
+    }
+    std::vector<std::unique_ptr<Connection>> idle;     //connections that wait for data (only this thread uses them)
+    std::vector<pollfd> pfds;
+    std::chrono::steady_clock::time_point last_refresh = std::chrono::steady_clock::now();
+    while(this->running){
+        if(std::chrono::steady_clock::now() - last_refresh >= std::chrono::milliseconds(REFRESH_MS)){
+            last_refresh = std::chrono::steady_clock::now();
+            try{
+                this->refresh();
+            }catch(std::exception&){
+                //the file is locked or cannot be read now, the next refresh tries again
+            }
+        }
+        pfds.clear();
+        pfds.push_back({this->listen_fd, POLLIN, 0});
+        pfds.push_back({this->wake_fds[0], POLLIN, 0});
+        for(const std::unique_ptr<Connection>& connection : idle){
+            pfds.push_back({connection->fd, POLLIN, 0});
+        }
+        if(poll(pfds.data(), pfds.size(), POLL_MS) < 0){
+            continue;   //interrupted by a signal
+        }
+        std::vector<std::unique_ptr<Connection>> waiting;
+        std::vector<std::unique_ptr<Connection>> received;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for(unsigned long i=0; i < idle.size(); i++){
+            if(pfds[i + 2].revents != 0){
+                received.push_back(std::move(idle[i]));     //data, hangup or error: a worker reads it
+            }else if(now - idle[i]->last_request > IDLE_TIMEOUT){
+                close(idle[i]->fd);
+            }else{
+                waiting.push_back(std::move(idle[i]));
+            }
+        }
+        idle.swap(waiting);
+        if(pfds[1].revents != 0){
+            char drain[64];
+            while(read(this->wake_fds[0], drain, sizeof(drain)) == sizeof(drain)){
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->queue_mutex);
+            for(std::unique_ptr<Connection>& connection : this->served){
+                idle.push_back(std::move(connection));
+            }
+            this->served.clear();
+            for(std::unique_ptr<Connection>& connection : received){
+                this->ready.push_back(std::move(connection));
+            }
+        }
+        for(unsigned long i=0; i < received.size(); i++){
+            this->queue_cv.notify_one();
+        }
+        if(pfds[0].revents == 0){
+            continue;
+        }
+        int client = accept(this->listen_fd, nullptr, nullptr);
+        if(client < 0){
+            continue;
+        }
+        UnixSocket::setTimeout(client, SEND_TIMEOUT_MS);
+        if(!UnixSocket::isSameUser(client)){
+            close(client);      //only the owner can read the vault
+            continue;
+        }
+        idle.push_back(std::make_unique<Connection>(Connection{client, "", std::chrono::steady_clock::now()}));
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    for(std::unique_ptr<Connection>& connection : idle){
+        close(connection->fd);
+    }
+    for(std::unique_ptr<Connection>& connection : this->ready){
+        close(connection->fd);      //connections that were not served before the stop
+    }
+    this->ready.clear();
+    for(std::unique_ptr<Connection>& connection : this->served){
+        close(connection->fd);
+    }
+    this->served.clear();
+}
+
+void VaultServer::stop() noexcept{
+    this->running = false;
+}
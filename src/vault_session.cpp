@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <openssl/crypto.h>
+#include "vault_session.h"
+#include "atomic_writer.h"
+#include "log_vault.h"
+
+VaultSession::VaultSession(const std::filesystem::path path, const DataHeader& header, const Bytes datakey, unsigned long max_cache_len)
+    : header(header), datakey(datakey.getView()), log(header.getCipherMode(), datakey, header.getCompressionMode()), index(header.getCipherMode(), datakey), filter(header.getCipherMode(), datakey), vault(path){
+    this->path = path;
+    this->lock_timeout = LOCK_TIMEOUT_MS;
+    this->max_cache_len = max_cache_len;
+    this->log_len = 0;
+    this->next_seq = 0;
+    this->garbage_len = 0;
+    bool opened;
+    {
+        FileLock file_lock(path, false, this->lock_timeout);
+        opened = this->open();
+    }
+    if(!opened){
+        //no valid index, the whole log is decrypted once to write it (LogVault takes the file lock itself)
+        LogVault(path, header, datakey).writeIndex();
+        FileLock file_lock(path, false, this->lock_timeout);
+        if(!this->open()){
+            throw std::runtime_error("name index of the vault cannot be written");
+        }
+    }
+}
+
+bool VaultSession::open(){
+    MappedVault vault(this->path);
+    if(!(vault.getHeader().toBytes() == this->header.getHeaderBytes())){
+        throw std::invalid_argument("data header of the file does not match with the given header");
+    }
+    BytesView body = vault.getBody();
+    try{
+        this->index.load(BytesView(AtomicWriter::readFile(NameIndex::getIndexPath(this->path))));
+        this->filter.load(BytesView(AtomicWriter::readFile(SearchFilter::getFilterPath(this->path))));
+    }catch(std::runtime_error&){
+        return false;   //no index, an index of another key or a modified index
+    }
+    if(this->index.getCoveredLen() != this->filter.getCoveredLen() || !(this->index.getLogId() == this->filter.getLogId())
+        || this->index.getCoveredLen() > body.getLen() || !(this->index.getLogId() == NameIndex::calcLogId(body, this->index.getCoveredLen()))){
+        return false;   //the index belongs to another version of the log
+    }
+    vault.adviseRandom();   //only single segments are read
+    this->vault = std::move(vault);
+    this->stamp = FileLock::getStamp(this->path);
+    this->log_len = this->index.getCoveredLen();
+    this->next_seq = this->index.getNextSeq();
+    this->tail.clear();
+    this->tail_values.clear();
+    this->garbage_len = 0;
+    this->indexed_names.reset();
+    this->lru.clear();
+    this->cache.clear();
+    this->stats.cached_len = 0;
+    this->readTail();
+    return true;
+}
+
+void VaultSession::readTail(){
+    this->log_len = this->log.readFrames(this->vault.getBody(), this->log_len, this->next_seq, [this](const LogFrame& frame, unsigned long, unsigned long frame_len){
+        this->addTail(frame.name, frame.type, frame.value.getView(), frame_len);
+        this->next_seq++;
+    });
+}
+
+void VaultSession::addTail(const std::string& name, unsigned char type, const BytesView value, unsigned long frame_len){
+    auto old = this->tail.find(name);
+    if(old != this->tail.end()){
+        if(old->second.value.has_value()){
+            this->garbage_len += old->second.frame_len;     //a tombstone was counted when it was added
+        }
+    }else{
+        std::optional<unsigned long> offset = this->index.find(name);
+        if(offset.has_value()){
+            this->garbage_len += RecordLog::getFrameLen(this->vault.getBody(), offset.value());    //only the length field is read
+        }
+    }
+    TailRecord& record = this->tail[name];
+    record.frame_len = frame_len;
+    if(type == RecordLog::RECORD_PUT){
+        record.value = std::make_pair(this->tail_values.getLen(), value.getLen());
+        this->tail_values.append(value);
+    }else{
+        record.value.reset();
+        this->garbage_len += frame_len;     //a tombstone is garbage itself
+    }
+}
+
+bool VaultSession::needsMaintenance() const noexcept{
+    return this->log_len - this->index.getCoveredLen() > MAX_UNINDEXED_LEN
+        || (this->log_len >= MIN_COMPACTION_LEN && this->garbage_len * 100 > this->log_len * COMPACTION_GARBAGE_PERCENT);
+}
+
+void VaultSession::maintain(){
+    {
+        //LogVault decrypts the whole log once and takes the exclusive lock for the rewrite
+        LogVault vault(this->path, this->header, this->datakey.getView().toBytes());
+        if(vault.needsCompaction()){
+            vault.compact();    //writes the index of the compacted log
+        }else{
+            vault.writeIndex();
+        }
+    }
+    FileLock file_lock(this->path, false, this->lock_timeout);
+    if(!this->open()){
+        throw std::runtime_error("name index of the vault cannot be written");
+    }
+}
+
+bool VaultSession::refreshLocked(){
+    if(FileLock::getStamp(this->path) == this->stamp){
+        return false;
+    }
+    MappedVault vault(this->path);
+    BytesView body = vault.getBody();
+    if(vault.getHeader().toBytes() == this->header.getHeaderBytes() && body.getLen() >= this->log_len
+        && this->index.getLogId() == NameIndex::calcLogId(body, this->index.getCoveredLen())){
+        //another process appended frames, the index and the cached segments are still valid
+        vault.adviseRandom();
+        this->vault = std::move(vault);
+        this->stamp = FileLock::getStamp(this->path);
+        this->readTail();
+        return true;
+    }
+    if(!this->open()){
+        throw std::runtime_error("name index of the vault does not match with the log (open the vault again)");
+    }
+    return true;
+}
+
+std::optional<unsigned long> VaultSession::findSegment(const std::string name) const{
+    std::optional<unsigned long> offset = this->index.find(name);
+    if(!offset.has_value()){
+        return {};
+    }
+    //the segments are sorted by their position in the log
+    unsigned long low = 0;
+    unsigned long high = this->filter.getSegmentNumber();
+    while(low < high){
+        unsigned long mid = (low + high) / 2;
+        if(this->filter.getSegment(mid).end <= offset.value()){
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    if(low == this->filter.getSegmentNumber() || this->filter.getSegment(low).begin > offset.value()){
+        throw std::runtime_error("name index does not match with the search filters");
+    }
+    return low;
+}
+
+const VaultSession::CachedSegment& VaultSession::loadSegment(unsigned long segment) const{
+    auto cached = this->cache.find(segment);
+    if(cached != this->cache.end()){
+        this->stats.hits++;
+        this->lru.splice(this->lru.begin(), this->lru, cached->second.lru_pos);
+        return cached->second;
+    }
+    this->stats.misses++;
+    BytesView body = this->vault.getBody();
+    const SearchSegment& s = this->filter.getSegment(segment);
+    std::vector<unsigned char> values;
+    CachedSegment loaded;
+    for(unsigned long offset : s.offsets){
+        unsigned long frame_len = RecordLog::getFrameLen(body, offset);
+        if(frame_len == 0 || offset + frame_len > s.end){
+            throw std::runtime_error("search filters do not match with the log");
+        }
+        LogFrame frame = this->log.decodeFrame(body.slice(offset, frame_len));
+        if(frame.type != RecordLog::RECORD_PUT){
+            throw std::runtime_error("search filters do not match with the log");
+        }
+        BytesView value = frame.value.getView();
+        loaded.positions[frame.name] = {values.size(), value.getLen()};
+        values.insert(values.end(), value.data(), value.data() + value.getLen());
+    }
+    loaded.values = SecureBuffer(BytesView(values));
+    OPENSSL_cleanse(values.data(), values.size());     //the values are only kept in the locked buffer
+    this->stats.cached_len += loaded.values.getLen();
+    this->lru.push_front(segment);
+    loaded.lru_pos = this->lru.begin();
+    CachedSegment& inserted = this->cache.emplace(segment, std::move(loaded)).first->second;
+    while(this->stats.cached_len > this->max_cache_len && this->lru.size() > 1){
+        //the least recently used segment is dropped (never the segment that was just loaded)
+        auto oldest = this->cache.find(this->lru.back());
+        this->stats.cached_len -= oldest->second.values.getLen();
+        this->cache.erase(oldest);
+        this->lru.pop_back();
+        this->stats.evictions++;
+    }
+    return inserted;
+}
+
+void VaultSession::put(const std::string name, const Bytes value){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    {
+        FileLock file_lock(this->path, true, this->lock_timeout);
+        this->refreshLocked();      //the frame gets the next sequence number of the file
+        Bytes frame = this->log.encodeFrame(this->next_seq, RecordLog::RECORD_PUT, name, value);
+        Bytes header_bytes = this->header.getHeaderBytes();
+        AtomicWriter::appendFile(this->path, header_bytes.getLen() + this->log_len, {frame.getView()});
+        this->stamp = FileLock::getStamp(this->path);
+        this->log_len += frame.getLen();
+        this->next_seq++;
+        this->addTail(name, RecordLog::RECORD_PUT, value.getView(), frame.getLen());
+    }
+    if(this->needsMaintenance()){
+        this->maintain();
+    }
+}
+
+bool VaultSession::remove(const std::string name){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    {
+        FileLock file_lock(this->path, true, this->lock_timeout);
+        this->refreshLocked();
+        auto changed = this->tail.find(name);
+        bool exists = changed != this->tail.end() ? changed->second.value.has_value() : this->index.find(name).has_value();
+        if(!exists){
+            return false;
+        }
+        Bytes frame = this->log.encodeFrame(this->next_seq, RecordLog::RECORD_TOMBSTONE, name, Bytes());
+        Bytes header_bytes = this->header.getHeaderBytes();
+        AtomicWriter::appendFile(this->path, header_bytes.getLen() + this->log_len, {frame.getView()});
+        this->stamp = FileLock::getStamp(this->path);
+        this->log_len += frame.getLen();
+        this->next_seq++;
+        this->addTail(name, RecordLog::RECORD_TOMBSTONE, BytesView(), frame.getLen());
+    }
+    if(this->needsMaintenance()){
+        this->maintain();
+    }
+    return true;
+}
+
+std::optional<Bytes> VaultSession::get(const std::string name) const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto changed = this->tail.find(name);
+    if(changed != this->tail.end()){
+        if(!changed->second.value.has_value()){
+            return {};  //removed behind the index
+        }
+        return this->tail_values.getView().slice(changed->second.value->first, changed->second.value->second).toBytes();
+    }
+    std::optional<unsigned long> segment = this->findSegment(name);
+    if(!segment.has_value()){
+        return {};
+    }
+    const CachedSegment& cached = this->loadSegment(segment.value());
+    auto position = cached.positions.find(name);
+    if(position == cached.positions.end()){
+        throw std::runtime_error("name index does not match with the search filters");
+    }
+    return cached.values.getView().slice(position->second.first, position->second.second).toBytes();
+}
+
+std::vector<std::string> VaultSession::getNames() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(!this->indexed_names.has_value()){
+        std::set<std::string> names;
+        for(unsigned long i=0; i < this->filter.getSegmentNumber(); i++){
+            for(const std::pair<const std::string, std::pair<unsigned long, unsigned long>>& position : this->loadSegment(i).positions){
+                names.insert(position.first);
+            }
+        }
+        this->indexed_names = names;
+    }
+    std::set<std::string> names = this->indexed_names.value();
+    for(const std::pair<const std::string, TailRecord>& changed : this->tail){
+        if(changed.second.value.has_value()){
+            names.insert(changed.first);
+        }else{
+            names.erase(changed.first);
+        }
+    }
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+bool VaultSession::refresh(){
+    std::lock_guard<std::mutex> lock(this->mutex);
+    FileLock file_lock(this->path, false, this->lock_timeout);
+    return this->refreshLocked();
+}
+
+void VaultSession::setLockTimeout(long timeout_ms) noexcept{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->lock_timeout = timeout_ms;
+}
+
+CacheStats VaultSession::getCacheStats() const{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    CacheStats stats = this->stats;
+    stats.cached_segments = this->cache.size();
+    stats.segments = this->filter.getSegmentNumber();
+    return stats;
+}
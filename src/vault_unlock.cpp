@@ -0,0 +1,71 @@
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+#include "vault_unlock.h"
+
+DataHeader VaultUnlock::parseHeader(const MappedVault& vault){
+    if(vault.isEmpty()){
+        throw std::logic_error("an empty vault cannot be unlocked");
+    }
+    DataHeader header(vault.getHeader()[0]);
+    header.setHeaderBytes(vault.getHeader());
+    return header;
+}
+
+VaultUnlock::VaultUnlock(MappedVault vault) : vault(std::move(vault)), header(parseHeader(this->vault)){
+    this->prefetched = 0;
+    this->vault.prefetch();     //the kernel starts reading the file
+    this->prefetcher = std::thread([this](){
+        //some filesystems (network mounts) ignore the hint, touching one byte of each page reads the file on this thread
+        BytesView view = this->vault.getView();
+#if defined(_WIN32)
+        unsigned long page = 4096;
+#else
+        unsigned long page = sysconf(_SC_PAGESIZE);
+#endif
+        volatile unsigned char sink = 0;
+        for(unsigned long pos = 0; pos < view.getLen(); pos += page){
+            sink = sink ^ view[pos];
+            this->prefetched = std::min(pos + page, view.getLen());
+        }
+    });
+}
+
+VaultUnlock::~VaultUnlock(){
+    if(this->prefetcher.joinable()){
+        this->prefetcher.join();
+    }
+}
+
+const DataHeader& VaultUnlock::getHeader() const noexcept{
+    return this->header;
+}
+
+unsigned long VaultUnlock::getPrefetchedLen() const noexcept{
+    return this->prefetched;
+}
+
+std::future<std::optional<UnlockedVault>> VaultUnlock::unlockAsync(const std::string password) const{
+    return std::async(std::launch::async, [this, password]() -> std::optional<UnlockedVault>{
+        //the chainhashes run here while the prefetcher reads the body
+        std::optional<Bytes> datakey = this->header.getDataKey(password);
+        if(!datakey.has_value()){
+            return {};  //wrong password
+        }
+        RecordLog log(this->header.getCipherMode(), datakey.value(), this->header.getCompressionMode());
+        log.load(this->vault.getBody());
+        return UnlockedVault{datakey.value(), log};
+    });
+}
+
+std::future<std::optional<UnlockedVault>> VaultUnlock::unlockWithKeyAsync(const Bytes datakey) const{
+    return std::async(std::launch::async, [this, datakey]() -> std::optional<UnlockedVault>{
+        //no chainhashes, the key is checked against the key check value of the header before the body is decrypted
+        if(!this->header.isDataKeyValid(datakey)){
+            return {};  //a body that decrypts is no proof (an empty log or a cut off last frame decrypts with every key)
+        }
+        RecordLog log(this->header.getCipherMode(), datakey, this->header.getCompressionMode());
+        log.load(this->vault.getBody());
+        return UnlockedVault{datakey, log};
+    });
+}
@@ -0,0 +1,122 @@
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "agent.h"
+#include "unix_socket.h"
+
+std::filesystem::path getTestSocket(){
+    return std::filesystem::temp_directory_path() / ("pman-agent-test-" + std::to_string(getpid())) / "agent.sock";
+}
+
+TEST(AgentClass, keys){
+    //testing that the agent serves the cached keys
+    std::filesystem::path path = getTestSocket();
+    AgentClient client(path);
+    EXPECT_FALSE(client.getKey("vault").has_value());      //no agent runs
+    EXPECT_FALSE(client.addKey("vault", Bytes(32)));
+
+    Agent agent(path, 60);
+    EXPECT_EQ(std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, std::filesystem::status(path).permissions() & std::filesystem::perms::all);
+    EXPECT_THROW(Agent(path, 60), std::runtime_error);
+    std::thread server([&agent](){agent.run();});
+
+    Bytes key1(32);
+    Bytes key2(64);
+    EXPECT_TRUE(client.addKey("vault1", key1));
+    EXPECT_TRUE(client.addKey("vault2", key2));
+    EXPECT_EQ(key1, client.getKey("vault1").value());
+    EXPECT_EQ(key2, client.getKey("vault2").value());
+    EXPECT_FALSE(client.getKey("vault3").has_value());
+    EXPECT_FALSE(client.addKey("vault3", Bytes()));        //only data key lengths are accepted
+    EXPECT_FALSE(client.addKey("vault3", Bytes(16)));
+    EXPECT_FALSE(client.addKey("vault1", Bytes(33)));
+    EXPECT_EQ(key1, client.getKey("vault1").value());
+    EXPECT_EQ(2, agent.getKeyNumber());
+    EXPECT_TRUE(client.removeKey("vault1"));
+    EXPECT_FALSE(client.removeKey("vault1"));
+    EXPECT_FALSE(client.getKey("vault1").has_value());
+    EXPECT_TRUE(client.clear());
+    EXPECT_FALSE(client.getKey("vault2").has_value());
+
+    //the key is removed after its ttl
+    EXPECT_TRUE(client.addKey("vault1", key1, 1));
+    EXPECT_TRUE(client.getKey("vault1").has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    EXPECT_FALSE(client.getKey("vault1").has_value());
+
+    agent.stop();
+    server.join();
+}
+
+TEST(AgentClass, stalledClient){
+    //testing that a client that does not finish its request does not block the others
+    std::filesystem::path path = getTestSocket();
+    Agent agent(path, 60);
+    std::thread server([&agent](){agent.run();});
+    AgentClient client(path);
+    EXPECT_TRUE(client.addKey("vault", Bytes(32)));
+    int stalled = UnixSocket::connectTo(path);
+    ASSERT_GE(stalled, 0);
+    unsigned char head[3] = {Agent::CMD_GET, 0, 0};    //the rest of the header never comes
+    ASSERT_TRUE(UnixSocket::sendAll(stalled, head, sizeof(head)));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i=0; i < 10; i++){
+        EXPECT_TRUE(client.getKey("vault").has_value());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    //the stalled client is dropped after the timeout
+    UnixSocket::setTimeout(stalled, 3000);
+    unsigned char byte;
+    EXPECT_FALSE(UnixSocket::recvAll(stalled, &byte, 1));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(2500));
+    close(stalled);
+    agent.stop();
+    server.join();
+}
+
+TEST(AgentClass, vaultId){
+    //testing that the vault id changes with the header
+    Bytes header(100);
+    EXPECT_EQ(64, Agent::getVaultId(header).size());
+    EXPECT_EQ(Agent::getVaultId(header), Agent::getVaultId(header));
+    EXPECT_NE(Agent::getVaultId(header), Agent::getVaultId(Bytes(100)));
+}
+
+TEST(AgentClass, staleSocket){
+    //testing that a socket of a crashed agent is replaced
+    std::filesystem::path path = getTestSocket();
+    {
+        Agent agent(path);
+    }
+    EXPECT_FALSE(std::filesystem::exists(path));
+    std::filesystem::create_directories(path.parent_path());
+    std::filesystem::permissions(path.parent_path(), std::filesystem::perms::owner_all);
+    std::ofstream(path.c_str());
+    Agent agent(path);
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_EQ(0, agent.getKeyNumber());
+}
+
+TEST(AgentClass, publicDir){
+    //testing that neither the agent nor the client use a socket in a directory that others can write
+    std::filesystem::path path = getTestSocket();
+    std::filesystem::create_directories(path.parent_path());
+    std::filesystem::permissions(path.parent_path(), std::filesystem::perms::owner_all | std::filesystem::perms::others_all);
+    EXPECT_THROW(Agent(path, 60), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(path));
+
+    std::filesystem::permissions(path.parent_path(), std::filesystem::perms::owner_all);
+    Agent agent(path, 60);
+    std::thread server([&agent](){agent.run();});
+    AgentClient client(path);
+    EXPECT_TRUE(client.addKey("vault", Bytes(32)));
+    std::filesystem::permissions(path.parent_path(), std::filesystem::perms::owner_all | std::filesystem::perms::group_write);
+    EXPECT_FALSE(client.getKey("vault").has_value());      //the key is not asked for
+    EXPECT_FALSE(client.addKey("vault2", Bytes(32)));
+    std::filesystem::permissions(path.parent_path(), std::filesystem::perms::owner_all);
+    EXPECT_TRUE(client.getKey("vault").has_value());
+    EXPECT_EQ(1, agent.getKeyNumber());
+    agent.stop();
+    server.join();
+}
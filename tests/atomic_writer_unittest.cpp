@@ -0,0 +1,117 @@
+#include <fstream>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "atomic_writer.h"
+
+std::string readTestFile(std::filesystem::path path){
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+TEST(AtomicWriterClass, writeFile){
+    //testing that the file is replaced by the parts
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_atomic_writer_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    std::filesystem::path path = dir / "vault.enc";
+
+    SaveReport report = AtomicWriter::writeFile(path, std::string("old content"));
+    EXPECT_EQ(11, report.bytes);
+    EXPECT_EQ("old content", readTestFile(path));
+
+    Bytes header(100);
+    Bytes body(3000000);
+    std::vector<unsigned char> trailer = {'P', 'M', 'A', 'C'};
+    report = AtomicWriter::writeFile(path, {header.getView(), BytesView(), body.getView(), BytesView(trailer)});
+    EXPECT_EQ(3000104, report.bytes);
+    EXPECT_GE(report.getThroughput(), 0);
+    Bytes expected = header;
+    expected.addBytes(body);
+    expected.addBytes(BytesView(trailer).toBytes());
+    std::string content = readTestFile(path);
+    EXPECT_EQ(expected.getBytes(), std::vector<unsigned char>(content.begin(), content.end()));
+
+    //only the file is left in the directory (no temp files)
+    int files = 0;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)){
+        EXPECT_EQ(path, entry.path());
+        files++;
+    }
+    EXPECT_EQ(1, files);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AtomicWriterClass, writeStream){
+    //testing that a streamed file is written part by part and an error keeps the old file
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_atomic_writer_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    std::filesystem::path path = dir / "blob";
+    AtomicWriter::writeFile(path, std::string("old content"));
+
+    int parts = 0;
+    SaveReport report = AtomicWriter::writeStream(path, [&parts]() -> std::optional<Bytes>{
+        if(parts == 3){
+            return {};
+        }
+        Bytes part;
+        part.setBytes(std::vector<unsigned char>(1000, 'a' + parts++));
+        return part;
+    });
+    EXPECT_EQ(3000, report.bytes);
+    EXPECT_EQ(std::string(1000, 'a') + std::string(1000, 'b') + std::string(1000, 'c'), readTestFile(path));
+
+    EXPECT_THROW(AtomicWriter::writeStream(path, []() -> std::optional<Bytes>{
+        throw std::runtime_error("input failed");
+    }), std::runtime_error);
+    EXPECT_EQ(3000, std::filesystem::file_size(path));
+    int files = 0;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)){
+        EXPECT_EQ(path, entry.path());      //the temp file was removed
+        files++;
+    }
+    EXPECT_EQ(1, files);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AtomicWriterClass, writeTemp){
+    //testing that a temp file replaces the file only when it is renamed
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_atomic_writer_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    std::filesystem::path path = dir / "vault.enc";
+    AtomicWriter::writeFile(path, std::string("old content"));
+    std::string content = "new content";
+    std::filesystem::path tmp_path = AtomicWriter::writeTemp(path, {BytesView(reinterpret_cast<const unsigned char*>(content.data()), content.size())});
+    EXPECT_EQ(dir, tmp_path.parent_path());
+    EXPECT_EQ("new content", readTestFile(tmp_path));
+    EXPECT_EQ("old content", readTestFile(path));
+    AtomicWriter::replaceWithTemp(path, tmp_path);
+    EXPECT_EQ("new content", readTestFile(path));
+    EXPECT_FALSE(std::filesystem::exists(tmp_path));
+    //a failed rename removes the temp file
+    tmp_path = AtomicWriter::writeTemp(path, {});
+    EXPECT_THROW(AtomicWriter::replaceWithTemp(dir / "missing" / "vault.enc", tmp_path), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(tmp_path));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AtomicWriterClass, permissions){
+    //testing that the new file keeps the permissions of the old file
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_atomic_writer_test.enc";
+    AtomicWriter::writeFile(path, std::string("a"));
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+    AtomicWriter::writeFile(path, std::string("b"));
+    EXPECT_EQ(std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, std::filesystem::status(path).permissions());
+    EXPECT_EQ("b", readTestFile(path));
+    std::filesystem::remove(path);
+}
+
+TEST(AtomicWriterClass, invalid){
+    //testing that nothing is written if the directory does not exist
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_missing_dir" / "vault.enc";
+    EXPECT_THROW(AtomicWriter::writeFile(path, std::string("content")), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
@@ -0,0 +1,89 @@
+#include <sstream>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "batch.h"
+#include "entry_record.h"
+#include "log_vault.h"
+
+TEST(BatchClass, commands){
+    //testing that every command is answered with one line
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_batch_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    std::istringstream in("set mail secret value\r\nget mail\n\nset bank 1234\nlist\ndel mail\ndel mail\nget mail\nfoo\nlist extra\nset\n");
+    std::ostringstream out;
+    EXPECT_EQ(5, Batch::run(vault, in, out));
+    EXPECT_EQ("ok\nok secret value\nok\nok 2\nbank\nmail\nok\nerr not found\nerr not found\nerr unknown command\nerr unknown command\nerr unknown command\n", out.str());
+
+    //the changes are saved
+    LogVault reopened(path, dh, datakey);
+    EXPECT_EQ(std::vector<std::string>({"bank"}), reopened.getNames());
+    std::filesystem::remove(path);
+}
+
+TEST(BatchClass, emptyValue){
+    //testing that a value can be empty
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_batch_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    std::istringstream in("set empty\nget empty\n");
+    std::ostringstream out;
+    EXPECT_EQ(0, Batch::run(vault, in, out));
+    EXPECT_EQ("ok\nok \n", out.str());
+    std::filesystem::remove(path);
+}
+
+TEST(BatchClass, namesWithSpaces){
+    //testing that set takes a name with spaces before a tab and that get and del use the whole name
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_batch_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    std::istringstream in("set Online banking\tmy secret\tpin\nget Online banking\nset short value\nlist\ndel Online banking\nlist\n");
+    std::ostringstream out;
+    EXPECT_EQ(0, Batch::run(vault, in, out));
+    EXPECT_EQ("ok\nok my secret\tpin\nok\nok 2\nOnline banking\nshort\nok\nok 1\nshort\n", out.str());
+    std::filesystem::remove(path);
+}
+
+TEST(BatchClass, entries){
+    //testing that entry records are answered with their secret and names can contain spaces
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_batch_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    Entry entry;
+    entry.title = "Mail";
+    entry.secret = "pw 1";
+    entry.notes = "line1\nline2";
+    vault.put("Mail (2)", EntryView::encode(entry));
+    entry.secret = "line1\nline2";
+    vault.put("multi", EntryView::encode(entry));
+    vault.put("binary", fromLong(1));
+    std::istringstream in("get Mail (2)\nget multi\nget binary\ndel Mail (2)\nget Mail (2)\n");
+    std::ostringstream out;
+    EXPECT_EQ(3, Batch::run(vault, in, out));
+    EXPECT_EQ("ok pw 1\nerr value is binary or has line breaks\nerr value is binary or has line breaks\nok\nerr not found\n", out.str());
+    std::filesystem::remove(path);
+}
+
+TEST(BatchClass, readPassword){
+    //testing that only the first line is read from the file descriptor
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    std::string data = "password1\r\nget mail\n";
+    ASSERT_EQ(data.size(), write(fds[1], data.data(), data.size()));
+    close(fds[1]);
+    EXPECT_EQ("password1", Batch::readPassword(fds[0]));
+    char rest[32];
+    EXPECT_EQ(9, read(fds[0], rest, sizeof(rest)));    //the rest of the pipe is not consumed
+    EXPECT_EQ("", Batch::readPassword(fds[0]));
+    close(fds[0]);
+}
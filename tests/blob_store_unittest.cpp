@@ -0,0 +1,104 @@
+#include <fstream>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "blob_store.h"
+#include "keywrap.h"
+
+std::string randomText(unsigned long len){
+    Bytes random(len);
+    std::vector<unsigned char> v = random.getBytes();
+    return std::string(v.begin(), v.end());
+}
+
+TEST(BlobStoreClass, streams){
+    //testing that attachments are written and read chunk by chunk
+    std::filesystem::path vault = std::filesystem::temp_directory_path() / "pman_blob_store_test.enc";
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    BlobStore store(vault, 2, datakey);
+    for(unsigned long len : {0UL, 1UL, 999UL, 1000UL, 1001UL, 25000UL}){
+        std::string content = randomText(len);
+        std::istringstream in(content);
+        BlobRef ref = store.write(in, 1000);
+        EXPECT_EQ(len, ref.len);
+        EXPECT_EQ(1000, ref.chunk_len);
+        EXPECT_EQ(len <= 1000 ? 1 : (len + 999) / 1000, BlobStore::getChunkNumber(ref));
+        EXPECT_TRUE(std::filesystem::exists(store.getBlobPath(ref.id)));
+        std::ostringstream out;
+        store.read(ref, out);
+        EXPECT_EQ(content, out.str());
+        if(len == 25000){
+            std::vector<unsigned char> chunk = store.readChunk(ref, 7).getBytes();
+            EXPECT_EQ(content.substr(7000, 1000), std::string(chunk.begin(), chunk.end()));
+            EXPECT_THROW(store.readChunk(ref, 25), std::range_error);
+        }
+    }
+    //another key
+    std::istringstream in(randomText(5000));
+    BlobRef ref = store.write(in, 1000);
+    BlobStore other(vault, 2, KeyWrap::generateDataKey(32));
+    std::ostringstream out;
+    EXPECT_THROW(other.read(ref, out), std::runtime_error);
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+}
+
+TEST(BlobStoreClass, tampering){
+    //testing that modified, reordered or cut off chunks are detected
+    std::filesystem::path vault = std::filesystem::temp_directory_path() / "pman_blob_store_test.enc";
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+    BlobStore store(vault, 2, KeyWrap::generateDataKey(32));
+    std::istringstream in(randomText(3000));
+    BlobRef ref = store.write(in, 1000);
+    std::filesystem::path path = store.getBlobPath(ref.id);
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    unsigned long chunk_len = (blob.size() - BlobStore::HEADER_LEN) / 3;
+
+    auto readWith = [&](std::vector<unsigned char> changed, const BlobRef& r){
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(changed.data()), changed.size());
+        f.close();
+        std::ostringstream out;
+        store.read(r, out);
+    };
+    std::vector<unsigned char> changed = blob;
+    changed[BlobStore::HEADER_LEN + chunk_len + 50] ^= 1;
+    EXPECT_THROW(readWith(changed, ref), std::runtime_error);
+    changed = blob;
+    std::swap_ranges(changed.begin() + BlobStore::HEADER_LEN, changed.begin() + BlobStore::HEADER_LEN + chunk_len, changed.begin() + BlobStore::HEADER_LEN + chunk_len);
+    EXPECT_THROW(readWith(changed, ref), std::runtime_error);
+    changed = std::vector<unsigned char>(blob.begin(), blob.end() - chunk_len);     //last chunk cut off
+    BlobRef shorter = ref;
+    shorter.len = 2000;
+    EXPECT_THROW(readWith(changed, shorter), std::runtime_error);
+    EXPECT_NO_THROW(readWith(blob, ref));
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+}
+
+TEST(BlobStoreClass, references){
+    //testing the encoding of the references and the removal of unreferenced blobs
+    std::filesystem::path vault = std::filesystem::temp_directory_path() / "pman_blob_store_test.enc";
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+    BlobStore store(vault, 2, KeyWrap::generateDataKey(32));
+    std::istringstream in1("first");
+    std::istringstream in2("second");
+    BlobRef first = store.write(in1);
+    BlobRef second = store.write(in2);
+
+    Bytes encoded = BlobStore::encodeRef(first);
+    EXPECT_EQ(BlobStore::REF_LEN, encoded.getLen());
+    std::optional<BlobRef> decoded = BlobStore::decodeRef(encoded.getView());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(first.id, decoded->id);
+    EXPECT_EQ(5, decoded->len);
+    EXPECT_EQ(BLOB_CHUNK_LEN, decoded->chunk_len);
+    EXPECT_FALSE(BlobStore::decodeRef(Bytes(BlobStore::REF_LEN).getView()).has_value());
+    EXPECT_FALSE(BlobStore::decodeRef(encoded.getView().slice(0, 20)).has_value());
+
+    EXPECT_EQ(0, BlobStore::removeUnreferenced(vault, {toHex(first.id)}));     //the new blobs are kept for the grace time
+    EXPECT_EQ(1, BlobStore::removeUnreferenced(vault, {toHex(first.id)}, 0));
+    EXPECT_TRUE(std::filesystem::exists(store.getBlobPath(first.id)));
+    EXPECT_FALSE(std::filesystem::exists(store.getBlobPath(second.id)));
+    std::filesystem::remove_all(BlobStore::getBlobDir(vault));
+}
@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "blockchain.h"
+#include "sha256.h"
+
+Bytes applyPatches(Bytes encoded, std::vector<std::pair<unsigned long, Bytes>> patches, unsigned long len){
+    //applies the patches of getDirtyEncoded on an old encoded byte string (like the filehandler does on the file)
+    std::vector<unsigned char> v = encoded.getBytes();
+    v.resize(len);
+    for(std::pair<unsigned long, Bytes> patch : patches){
+        std::vector<unsigned char> p = patch.second.getBytes();
+        std::copy(p.begin(), p.end(), v.begin() + patch.first);
+    }
+    Bytes ret;
+    ret.setBytes(v);
+    return ret;
+}
+
+TEST(BlockChainClass, constructor){
+    //testing the constructor
+    sha256* hash = new sha256();
+    EXPECT_THROW(BlockChain(nullptr, Bytes(32), Bytes(32)), std::invalid_argument);
+    EXPECT_THROW(BlockChain(hash, Bytes(31), Bytes(32)), std::length_error);
+    EXPECT_THROW(BlockChain(hash, Bytes(32), Bytes(33)), std::length_error);
+    BlockChain bc(hash, Bytes(32), Bytes(32));
+    EXPECT_EQ(32, bc.getBlockLen());
+    EXPECT_EQ(0, bc.getBlockNumber());
+    EXPECT_EQ(0, bc.getDataLen());
+    EXPECT_FALSE(bc.isDirty());
+    delete hash;
+}
+
+TEST(BlockChainClass, encode_decode){
+    //testing that encoded data can be decoded by a new chain with the same passwordhash and salt
+    sha256* hash = new sha256();
+    Bytes pwhash(32);
+    Bytes salt(32);
+    for(int len : {1, 31, 32, 33, 1000}){
+        Bytes data(len);
+        BlockChain bc(hash, pwhash, salt);
+        bc.setData(data);
+        EXPECT_EQ(data, bc.getData());
+        EXPECT_EQ((len + 31) / 32, bc.getBlockNumber());
+        Bytes encoded = bc.getEncoded();
+        EXPECT_EQ(bc.getBlockNumber() * 32, encoded.getLen());
+
+        BlockChain bc2(hash, pwhash, salt);
+        bc2.setEncoded(encoded);
+        EXPECT_FALSE(bc2.isDirty());
+        EXPECT_EQ(data, bc2.getData().getFirstBytes(len).value());
+        EXPECT_EQ(encoded, bc2.getEncoded());
+
+        BlockChain bc3(hash, Bytes(32), salt);
+        bc3.setEncoded(encoded);
+        EXPECT_FALSE(data == bc3.getData().getFirstBytes(len).value());
+    }
+    BlockChain bc(hash, pwhash, salt);
+    EXPECT_THROW(bc.setEncoded(Bytes(33)), std::length_error);
+    delete hash;
+}
+
+TEST(BlockChainClass, dirty_blocks){
+    //testing that only the changed blocks have to be written again
+    sha256* hash = new sha256();
+    Bytes pwhash(32);
+    Bytes salt(32);
+    BlockChain bc(hash, pwhash, salt);
+    bc.setData(Bytes(32*100));
+    Bytes encoded = bc.getEncoded();
+    EXPECT_EQ(100, bc.getDirtyBlocks().size());
+    bc.getDirtyEncoded();
+    EXPECT_FALSE(bc.isDirty());
+
+    //change inside of one block
+    bc.changeData(32*10 + 5, Bytes(10));
+    EXPECT_EQ(std::vector<unsigned long>({10}), bc.getDirtyBlocks());
+    //change over a block border
+    bc.changeData(32*50 + 30, Bytes(4));
+    EXPECT_EQ(std::vector<unsigned long>({10, 50, 51}), bc.getDirtyBlocks());
+    std::vector<std::pair<unsigned long, Bytes>> patches = bc.getDirtyEncoded();
+    EXPECT_EQ(2, patches.size());
+    EXPECT_EQ(32*10, patches[0].first);
+    EXPECT_EQ(32, patches[0].second.getLen());
+    EXPECT_EQ(32*50, patches[1].first);
+    EXPECT_EQ(64, patches[1].second.getLen());
+    encoded = applyPatches(encoded, patches, bc.getEncodedLen());
+    EXPECT_EQ(bc.getEncoded(), encoded);
+
+    BlockChain bc2(hash, pwhash, salt);
+    bc2.setEncoded(encoded);
+    EXPECT_EQ(bc.getData(), bc2.getData());
+    delete hash;
+}
+
+TEST(BlockChainClass, insert_remove){
+    //testing that inserting and removing data marks the shifted suffix dirty
+    sha256* hash = new sha256();
+    Bytes pwhash(32);
+    Bytes salt(32);
+    BlockChain bc(hash, pwhash, salt);
+    Bytes data(32*10);
+    bc.setData(data);
+    Bytes encoded = bc.getEncoded();
+    bc.getDirtyEncoded();
+
+    Bytes inserted(5);
+    bc.insertData(32*8, inserted);
+    EXPECT_EQ(32*10 + 5, bc.getDataLen());
+    EXPECT_EQ(std::vector<unsigned long>({8, 9, 10}), bc.getDirtyBlocks());
+    std::vector<unsigned char> expected = data.getBytes();
+    std::vector<unsigned char> ins = inserted.getBytes();
+    expected.insert(expected.begin() + 32*8, ins.begin(), ins.end());
+    EXPECT_EQ(expected, bc.getData().getBytes());
+    encoded = applyPatches(encoded, bc.getDirtyEncoded(), bc.getEncodedLen());
+    EXPECT_EQ(bc.getEncoded(), encoded);
+
+    bc.removeData(32*9 + 1, 6);
+    EXPECT_EQ(32*10 - 1, bc.getDataLen());
+    EXPECT_EQ(10, bc.getBlockNumber());
+    EXPECT_EQ(std::vector<unsigned long>({9}), bc.getDirtyBlocks());
+    expected.erase(expected.begin() + 32*9 + 1, expected.begin() + 32*9 + 7);
+    EXPECT_EQ(expected, bc.getData().getBytes());
+    encoded = applyPatches(encoded, bc.getDirtyEncoded(), bc.getEncodedLen());
+    EXPECT_EQ(bc.getEncoded(), encoded);
+
+    BlockChain bc2(hash, pwhash, salt);
+    bc2.setEncoded(encoded);
+    expected.push_back(0);  //last block is filled up with zeros
+    EXPECT_EQ(expected, bc2.getData().getBytes());
+
+    EXPECT_THROW(bc.insertData(32*11, Bytes(1)), std::range_error);
+    EXPECT_THROW(bc.removeData(32*9, 33), std::range_error);
+    EXPECT_THROW(bc.changeData(32*11, Bytes(1)), std::range_error);
+    delete hash;
+}
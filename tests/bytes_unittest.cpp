@@ -306,6 +306,40 @@ TEST(Utils, toLong){
     EXPECT_EQ(one, toLong(oneBytes));
 }
 
+TEST(Utils, fromLong){
+    unsigned long max_long = -1;
+    std::vector<unsigned char> v1 = {0, 0, 1, 2};
+    EXPECT_EQ(v1, fromLong(258, 4).getBytes());
+    EXPECT_EQ(8, fromLong(0).getLen());
+    EXPECT_EQ(Bytes(), fromLong(0, 0));
+    EXPECT_EQ(max_long, toLong(fromLong(max_long)));
+    EXPECT_EQ(123456789, toLong(fromLong(123456789, 5)));
+    EXPECT_THROW(fromLong(256, 1), std::range_error);
+    EXPECT_THROW(fromLong(1, 9), std::range_error);
+    EXPECT_THROW(fromLong(1, -1), std::range_error);
+}
+
+TEST(BytesViewClass, view){
+    std::vector<unsigned char> v = {1, 2, 3, 4, 5, 6};
+    Bytes b;
+    b.setBytes(v);
+    BytesView view = b.getView();
+    EXPECT_EQ(6, view.getLen());
+    EXPECT_FALSE(view.isEmpty());
+    EXPECT_TRUE(BytesView().isEmpty());
+    EXPECT_EQ(3, view[2]);
+    EXPECT_EQ(b, view.toBytes());
+    BytesView slice = view.slice(2, 3);
+    EXPECT_EQ(std::vector<unsigned char>({3, 4, 5}), slice.toBytes().getBytes());
+    EXPECT_EQ(0x030405, toLong(slice));
+    EXPECT_EQ(toLong(b), toLong(view));
+    EXPECT_TRUE(view.slice(6, 0).isEmpty());
+    EXPECT_THROW(view.slice(5, 2), std::range_error);
+    EXPECT_THROW(view.slice(7, 0), std::range_error);
+    EXPECT_THROW(slice.slice(1, 3), std::range_error);
+    EXPECT_EQ(v.data(), BytesView(v).data());
+}
+
 TEST(Utils, bytesOperator){
     std::vector<unsigned char> testv1 = {123,43,23,113,213,32,0};
     std::vector<unsigned char> testv2 = {89,255,0,189, 11, 67, 254};
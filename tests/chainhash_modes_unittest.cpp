@@ -0,0 +1,35 @@
+#include "gtest/gtest.h"
+#include "chainhash_modes.h"
+#include "pwfunc.h"
+#include "sha256.h"
+
+TEST(ChainHashModesClass, perform){
+    //testing that the chainhash modes use the right pwfunc with the arguments of the datablock
+    sha256* hash = new sha256();
+    PwFunc pwf(hash);
+    std::string pw = "password123";
+    Bytes sn;
+    sn.setBytes({0, 0, 0, 0, 0, 0, 1, 2});    //258
+    Bytes salt;
+    salt.setBytes({'s', 'a', 'l', 't'});
+    Bytes sn_salt = sn;
+    sn_salt.addBytes(salt);
+    Bytes quadratic;
+    for(int i=0; i < 4; i++){
+        quadratic.addBytes(sn);
+    }
+
+    EXPECT_EQ(pwf.chainhash(pw, 10), ChainHashModes::performChainHash(1, 10, Bytes(), hash, pw));
+    EXPECT_EQ(pwf.chainhashWithConstantSalt(pw, 10, "salt"), ChainHashModes::performChainHash(2, 10, salt, hash, pw));
+    EXPECT_EQ(pwf.chainhashWithCountSalt(pw, 10, 258), ChainHashModes::performChainHash(3, 10, sn, hash, pw));
+    EXPECT_EQ(pwf.chainhashWithCountAndConstantSalt(pw, 10, 258, "salt"), ChainHashModes::performChainHash(4, 10, sn_salt, hash, pw));
+    EXPECT_EQ(pwf.chainhashWithQuadraticCountSalt(pw, 10, 258, 258, 258, 258), ChainHashModes::performChainHash(5, 10, quadratic, hash, pw));
+    Bytes pw_bytes;
+    pw_bytes.setBytes(std::vector<unsigned char>(pw.begin(), pw.end()));
+    EXPECT_EQ(pwf.chainhash(pw, 10), ChainHashModes::performChainHash(1, 10, Bytes(), hash, pw_bytes));
+
+    EXPECT_THROW(ChainHashModes::performChainHash(3, 10, salt, hash, pw), std::invalid_argument);
+    EXPECT_THROW(ChainHashModes::performChainHash(1, 0, Bytes(), hash, pw), std::invalid_argument);
+    EXPECT_THROW(ChainHashModes::performChainHash(6, 10, Bytes(), hash, pw), std::invalid_argument);
+    delete hash;
+}
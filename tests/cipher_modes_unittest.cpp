@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "cipher_modes.h"
+
+TEST(CipherModesClass, modes){
+    //testing the mode checks
+    EXPECT_FALSE(CipherModes::isModeValid(0));
+    EXPECT_TRUE(CipherModes::isModeValid(1));
+    EXPECT_TRUE(CipherModes::isModeValid(2));
+    EXPECT_TRUE(CipherModes::isModeValid(3));
+    EXPECT_FALSE(CipherModes::isModeValid(4));
+    EXPECT_FALSE(CipherModes::isAuthenticated(1));
+    EXPECT_TRUE(CipherModes::isAuthenticated(2));
+    EXPECT_TRUE(CipherModes::isAuthenticated(3));
+    EXPECT_THROW(CipherModes::encrypt(1, Bytes(32), Bytes(10)), std::invalid_argument);
+}
+
+TEST(CipherModesClass, deriveKey){
+    //testing the key derivation
+    Bytes pwhash(64);
+    EXPECT_EQ(CipherModes::KEY_LEN, CipherModes::deriveKey(pwhash, "data").getLen());
+    EXPECT_EQ(CipherModes::deriveKey(pwhash, "data"), CipherModes::deriveKey(pwhash, "data"));
+    EXPECT_FALSE(CipherModes::deriveKey(pwhash, "data") == CipherModes::deriveKey(pwhash, "mac"));
+    EXPECT_FALSE(CipherModes::deriveKey(pwhash, "data") == CipherModes::deriveKey(Bytes(64), "data"));
+    EXPECT_THROW(CipherModes::deriveKey(Bytes(), "data"), std::invalid_argument);
+}
+
+TEST(CipherModesClass, encrypt_decrypt){
+    //testing that the encrypted data can be decrypted (also over chunk borders)
+    for(unsigned char mode : {2, 3}){
+        Bytes key(CipherModes::KEY_LEN);
+        for(unsigned long len : {0UL, 1UL, 1000UL, CIPHER_CHUNK_SIZE, 2*CIPHER_CHUNK_SIZE + 7}){
+            Bytes data(len);
+            Bytes enc = CipherModes::encrypt(mode, key, data);
+            EXPECT_EQ(CipherModes::getEncryptedLen(mode, len), enc.getLen());
+            EXPECT_EQ(data, CipherModes::decrypt(mode, key, enc));
+            EXPECT_FALSE(enc == CipherModes::encrypt(mode, key, data));     //new nonce each time
+        }
+        EXPECT_THROW(CipherModes::encrypt(mode, Bytes(31), Bytes(10)), std::length_error);
+        EXPECT_THROW(CipherModes::decrypt(mode, key, Bytes(27)), std::length_error);
+    }
+}
+
+TEST(CipherModesClass, authentication){
+    //testing that modified data, a wrong key and cut off chunks are detected
+    for(unsigned char mode : {2, 3}){
+        Bytes key(CipherModes::KEY_LEN);
+        Bytes data(CIPHER_CHUNK_SIZE + 100);
+        Bytes enc = CipherModes::encrypt(mode, key, data);
+
+        EXPECT_THROW(CipherModes::decrypt(mode, Bytes(CipherModes::KEY_LEN), enc), std::runtime_error);
+        EXPECT_THROW(CipherModes::decrypt(mode == 2 ? 3 : 2, key, enc), std::runtime_error);
+
+        std::vector<unsigned char> v = enc.getBytes();
+        v[CipherModes::NONCE_LEN + 5] ^= 1;
+        Bytes modified;
+        modified.setBytes(v);
+        EXPECT_THROW(CipherModes::decrypt(mode, key, modified), std::runtime_error);
+
+        Bytes cut = enc.getFirstBytes(CipherModes::NONCE_LEN + CIPHER_CHUNK_SIZE + CipherModes::TAG_LEN).value();
+        EXPECT_THROW(CipherModes::decrypt(mode, key, cut), std::runtime_error);
+    }
+}
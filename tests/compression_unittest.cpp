@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "compression.h"
+
+Bytes textBytes(unsigned long len){
+    //data that is compressible (like credentials and urls)
+    std::string text = "user=admin@example.com;url=https://example.com/login;note=";
+    Bytes ret;
+    for(unsigned long i=0; (unsigned long)ret.getLen() < len; i++){
+        for(char c : text + std::to_string(i) + "\n"){
+            ret.addByte(c);
+        }
+    }
+    return ret.getFirstBytes(len).value();
+}
+
+TEST(CompressionClass, block){
+    //testing the lz codec without frames
+    for(unsigned long len : {0UL, 1UL, 4UL, 15UL, 16UL, 300UL, 70000UL}){
+        Bytes text = textBytes(len);
+        Bytes random(len);
+        EXPECT_EQ(text, Compression::decompressBlock(Compression::compressBlock(text), len));
+        EXPECT_EQ(random, Compression::decompressBlock(Compression::compressBlock(random), len));
+    }
+    Bytes zeros;
+    zeros.setBytes(std::vector<unsigned char>(100000, 0));
+    Bytes compressed = Compression::compressBlock(zeros);
+    EXPECT_LT(compressed.getLen(), 1000);
+    EXPECT_EQ(zeros, Compression::decompressBlock(compressed, zeros.getLen()));
+    EXPECT_LT(Compression::compressBlock(textBytes(10000)).getLen(), 5000);
+}
+
+TEST(CompressionClass, corrupted){
+    //testing that corrupted data is detected
+    Bytes text = textBytes(1000);
+    Bytes compressed = Compression::compressBlock(text);
+    EXPECT_THROW(Compression::decompressBlock(compressed, 999), std::runtime_error);
+    EXPECT_THROW(Compression::decompressBlock(compressed, 1001), std::runtime_error);
+    EXPECT_THROW(Compression::decompressBlock(compressed.getFirstBytes(compressed.getLen()/2).value(), 1000), std::runtime_error);
+    Bytes invalid_offset;
+    invalid_offset.setBytes({0x10, 'a', 5, 0});  //one literal and a match 5 bytes back
+    EXPECT_THROW(Compression::decompressBlock(invalid_offset, 5), std::runtime_error);
+}
+
+TEST(CompressionClass, frames){
+    //testing the segment frames
+    Bytes text = textBytes(SEGMENT_SIZE*3 + 100);
+    Bytes compressed = Compression::compress(1, text);
+    EXPECT_LT(compressed.getLen(), text.getLen() / 2);
+    EXPECT_EQ(text, Compression::decompress(1, compressed));
+    EXPECT_EQ(4, Compression::getSegmentOffsets(compressed).size());
+    EXPECT_EQ(text.getFirstBytes(SEGMENT_SIZE).value(), Compression::decompressSegment(compressed, 0));
+    std::vector<unsigned char> v = text.getBytes();
+    EXPECT_EQ(std::vector<unsigned char>(v.begin() + SEGMENT_SIZE*3, v.end()), Compression::decompressSegment(compressed, 3).getBytes());
+    EXPECT_THROW(Compression::decompressSegment(compressed, 4), std::range_error);
+
+    //random data is stored without compression
+    Bytes random(1000);
+    Bytes stored = Compression::compress(1, random, 100);
+    EXPECT_EQ(1000 + 10*Compression::FRAME_HEADER_LEN, stored.getLen());
+    EXPECT_EQ(random, Compression::decompress(1, stored));
+
+    EXPECT_EQ(Bytes(), Compression::compress(1, Bytes()));
+    EXPECT_EQ(Bytes(), Compression::decompress(1, Bytes()));
+    EXPECT_EQ(random, Compression::compress(0, random));
+    EXPECT_EQ(random, Compression::decompress(0, random));
+    EXPECT_THROW(Compression::compress(2, random), std::invalid_argument);
+    EXPECT_THROW(Compression::getSegmentOffsets(compressed.getFirstBytes(compressed.getLen()-1).value()), std::runtime_error);
+}
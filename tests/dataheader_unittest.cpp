@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include "dataHeader.h"
+
+DataHeader createHeader(unsigned char hash_mode, Bytes datakey){
+    //creates a complete data header with two keyslots
+    DataHeader dh(hash_mode);
+    dh.setCipherMode(2);
+    dh.setCompressionMode(1);
+    dh.setChainHash1(3, 20, 8, Bytes(8));
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    KeySlot keyslot(hash_mode);
+    keyslot.setChainHash1(5, 30, 32, Bytes(32));
+    keyslot.setChainHash2(4, 10, 16, Bytes(16));
+    keyslot.setPassword("password2", datakey);
+    dh.addKeySlot(keyslot);
+    dh.setEncryptedSalt(Bytes(datakey.getLen()));
+    return dh;
+}
+
+TEST(DataHeaderClass, roundtrip){
+    //testing that a serialized header is parsed into the same header
+    for(unsigned char hash_mode = 1; hash_mode <= MAX_HASHMODE_NUMBER; hash_mode++){
+        DataHeader dh(hash_mode);
+        Bytes datakey = KeyWrap::generateDataKey(dh.getHashSize());
+        dh = createHeader(hash_mode, datakey);
+        Bytes header = dh.getHeaderBytes();
+        EXPECT_EQ(dh.getHeaderLength(), header.getLen());
+        EXPECT_EQ(4 + dh.getHashSize() + DataHeader::KEY_CHECK_LEN + 2*(48 + 2*dh.getHashSize()) + 56, header.getLen());
+        EXPECT_EQ(header.getLen(), DataHeader::readHeaderLength(header.getView()));
+
+        DataHeader parsed(hash_mode);
+        parsed.setHeaderBytes(header);
+        EXPECT_EQ(header, parsed.getHeaderBytes());
+        EXPECT_EQ(header.getLen(), parsed.getHeaderLength());
+        EXPECT_EQ(2, parsed.getCipherMode());
+        EXPECT_EQ(1, parsed.getCompressionMode());
+        EXPECT_EQ(2, parsed.getKeySlotNumber());
+        EXPECT_EQ(dh.getEncryptedSalt(), parsed.getEncryptedSalt());
+        EXPECT_EQ(32, parsed.getKeySlot(1).getChainHash1Datablock().getLen());
+        EXPECT_EQ(30, parsed.getKeySlot(1).getChainHash1Iters());
+        EXPECT_EQ(datakey, parsed.getDataKey("password1").value());
+        EXPECT_EQ(datakey, parsed.getDataKey("password2").value());
+        EXPECT_TRUE(parsed.isDataKeyValid(datakey));
+        EXPECT_FALSE(parsed.isDataKeyValid(KeyWrap::generateDataKey(dh.getHashSize())));
+    }
+}
+
+TEST(DataHeaderClass, key_check){
+    //testing that the key check value only accepts the data key of the header
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    EXPECT_FALSE(dh.isDataKeyValid(datakey));   //no key check value yet
+    dh = createHeader(1, datakey);
+    EXPECT_TRUE(dh.isDataKeyValid(datakey));
+    EXPECT_FALSE(dh.isDataKeyValid(Bytes()));
+    EXPECT_FALSE(dh.isDataKeyValid(KeyWrap::generateDataKey(32)));
+    EXPECT_THROW(dh.setPassword("password3", KeyWrap::generateDataKey(32), 1), std::invalid_argument);   //all keyslots wrap the same data key
+    dh.setPassword("password3", datakey, 1);
+    EXPECT_TRUE(dh.isDataKeyValid(datakey));
+    EXPECT_EQ(datakey, dh.getDataKey("password3").value());
+}
+
+TEST(DataHeaderClass, buffer){
+    //testing that the header is parsed from the begin of a bigger buffer and written into a preallocated buffer
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createHeader(1, datakey);
+    unsigned int len = dh.getHeaderLength();
+    std::vector<unsigned char> buf(len + 100, 0xAB);
+    EXPECT_THROW(dh.writeHeaderBytes(buf.data(), len - 1), std::length_error);
+    dh.writeHeaderBytes(buf.data(), buf.size());
+    EXPECT_EQ(0xAB, buf[len]);      //nothing is written behind the header
+    EXPECT_EQ(len, DataHeader::readHeaderLength(BytesView(buf)));
+
+    DataHeader parsed(1);
+    parsed.setHeaderBytes(BytesView(buf));
+    EXPECT_EQ(len, parsed.getHeaderLength());
+    EXPECT_EQ(dh.getHeaderBytes(), parsed.getHeaderBytes());
+    Bytes with_body;
+    with_body.setBytes(buf);
+    EXPECT_THROW(parsed.setHeaderBytes(with_body), std::length_error);
+
+    //changing the header updates the serialized header
+    parsed.setCipherMode(3);
+    EXPECT_EQ(3, parsed.getHeaderBytes().getBytes()[1]);
+}
+
+TEST(DataHeaderClass, invalid){
+    //testing that invalid headers are not parsed
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createHeader(1, datakey);
+    std::vector<unsigned char> header = dh.getHeaderBytes().getBytes();
+    DataHeader parsed(1);
+    for(unsigned int len : {0u, 1u, 4u, 50u, (unsigned int)header.size() - 1}){
+        //cut off headers
+        EXPECT_THROW(parsed.setHeaderBytes(BytesView(header.data(), len)), std::length_error);
+        EXPECT_THROW(DataHeader::readHeaderLength(BytesView(header.data(), len)), std::length_error);
+    }
+    EXPECT_EQ(1, parsed.getKeySlotNumber());    //failed parsing does not change the header
+
+    std::vector<unsigned char> changed = header;
+    changed[0] = 2;
+    EXPECT_THROW(parsed.setHeaderBytes(BytesView(changed)), std::invalid_argument);
+    changed = header;
+    changed[1] = 0;
+    EXPECT_THROW(parsed.setHeaderBytes(BytesView(changed)), std::invalid_argument);
+    changed = header;
+    changed[3] = 0;
+    EXPECT_THROW(parsed.setHeaderBytes(BytesView(changed)), std::length_error);
+    changed[3] = MAX_KEYSLOTS + 1;
+    EXPECT_THROW(parsed.setHeaderBytes(BytesView(changed)), std::length_error);
+
+    //incomplete headers are not serialized
+    DataHeader incomplete(1);
+    EXPECT_THROW(incomplete.getHeaderBytes(), std::logic_error);
+}
@@ -0,0 +1,107 @@
+#include <map>
+#include "gtest/gtest.h"
+#include "entry_index.h"
+
+TEST(EntryIndexClass, putAndFind){
+    //testing exact lookups and changes
+    EntryIndex index;
+    EXPECT_EQ(EntryIndex::MIN_CAPACITY, index.getCapacity());
+    EXPECT_FALSE(index.find("mail").has_value());
+    index.put("mail", "record1");
+    index.put("bank", "record2");
+    index.put("mail", "record3");
+    EXPECT_EQ(2, index.getSize());
+    EXPECT_EQ("record3", index.find("mail").value());
+    EXPECT_EQ("record2", index.find("bank").value());
+    EXPECT_TRUE(index.remove("mail"));
+    EXPECT_FALSE(index.remove("mail"));
+    EXPECT_FALSE(index.find("mail").has_value());
+    EXPECT_EQ(1, index.getSize());
+    index.put("mail", "record4");
+    EXPECT_EQ("record4", index.find("mail").value());
+}
+
+TEST(EntryIndexClass, holders){
+    //testing that a key stays until its last holder is removed
+    EntryIndex index;
+    index.put("mail", "record1");
+    index.put("mail", "record2");
+    EXPECT_EQ(1, index.getSize());
+    EXPECT_EQ("record2", index.find("mail").value());
+    EXPECT_FALSE(index.remove("mail", "record3"));
+    EXPECT_TRUE(index.remove("mail", "record2"));
+    EXPECT_EQ("record1", index.find("mail").value());
+    index.put("mail", "record2");
+    index.put("mail", "record1");      //an existing holder becomes the latest again
+    EXPECT_EQ("record1", index.find("mail").value());
+    EXPECT_TRUE(index.remove("mail", "record1"));
+    EXPECT_TRUE(index.remove("mail", "record2"));
+    EXPECT_FALSE(index.find("mail").has_value());
+    EXPECT_EQ(0, index.getSize());
+    EXPECT_TRUE(index.findPrefix("mail").empty());
+}
+
+TEST(EntryIndexClass, growAndRemove){
+    //testing that the index stays correct while it grows and keys are removed (compared with std::map)
+    EntryIndex index(100);
+    std::map<std::string, std::string> expected;
+    for(unsigned long i=0; i < 20000; i++){
+        std::string key = "key" + std::to_string((i * 7919) % 5000);
+        if(i % 3 == 0){
+            EXPECT_EQ(expected.erase(key) > 0, index.remove(key));
+        }else{
+            index.put(key, std::to_string(i));
+            expected[key] = std::to_string(i);
+        }
+    }
+    EXPECT_EQ(expected.size(), index.getSize());
+    EXPECT_LE(index.getSize() * 10, index.getCapacity() * 7);
+    for(unsigned long i=0; i < 5000; i++){
+        std::string key = "key" + std::to_string(i);
+        std::map<std::string, std::string>::iterator it = expected.find(key);
+        std::optional<std::string> found = index.find(key);
+        ASSERT_EQ(it != expected.end(), found.has_value());
+        if(found.has_value()){
+            EXPECT_EQ(it->second, found.value());
+        }
+    }
+    //the sorted keys match
+    std::vector<std::pair<std::string, std::string>> all = index.findPrefix("", expected.size());
+    std::vector<std::pair<std::string, std::string>> expected_all(expected.begin(), expected.end());
+    EXPECT_EQ(expected_all, all);
+}
+
+TEST(EntryIndexClass, prefix){
+    //testing prefix queries
+    EntryIndex index;
+    for(std::string key : {"mail", "mailbox", "bank", "mailserver", "main", "ma"}){
+        index.put(key, "record " + key);
+    }
+    std::vector<std::pair<std::string, std::string>> found = index.findPrefix("mail");
+    ASSERT_EQ(3, found.size());
+    EXPECT_EQ("mail", found[0].first);
+    EXPECT_EQ("mailbox", found[1].first);
+    EXPECT_EQ("mailserver", found[2].first);
+    EXPECT_EQ("record mailserver", found[2].second);
+    EXPECT_EQ(2, index.findPrefix("mai", 2).size());
+    EXPECT_EQ(4, index.findPrefix("mai").size());
+    EXPECT_TRUE(index.findPrefix("x").empty());
+    index.remove("mailbox");
+    EXPECT_EQ(2, index.findPrefix("mail").size());
+}
+
+TEST(EntryIndexClass, clear){
+    //testing that a cleared index can be filled again
+    EntryIndex index;
+    for(int i=0; i < 100; i++){
+        index.put("entry" + std::to_string(i), "record" + std::to_string(i));
+    }
+    unsigned long capacity = index.getCapacity();
+    index.clear();
+    EXPECT_EQ(0, index.getSize());
+    EXPECT_EQ(capacity, index.getCapacity());
+    EXPECT_FALSE(index.find("entry7").has_value());
+    EXPECT_TRUE(index.findPrefix("entry").empty());
+    index.put("entry7", "record");
+    EXPECT_EQ("record", index.find("entry7").value());
+}
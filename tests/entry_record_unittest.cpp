@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "entry_record.h"
+
+Entry createEntry(){
+    Entry entry;
+    entry.title = "mail";
+    entry.username = "me@example.com";
+    entry.secret = "password1";
+    entry.url = "https://mail.example.com";
+    entry.notes = "";
+    entry.created = 1700000000;
+    entry.modified = 1700000100;
+    return entry;
+}
+
+TEST(EntryRecordClass, encodeAndView){
+    //testing that the fields are read from the encoded record
+    Entry entry = createEntry();
+    Bytes record = EntryView::encode(entry);
+    EXPECT_EQ(EntryView::getEncodedLen(entry), record.getLen());
+    EXPECT_EQ(EntryView::HEADER_LEN + 51, record.getLen());
+    EntryView view(record.getView());
+    EXPECT_EQ(record.getLen(), view.getLen());
+    EXPECT_EQ("mail", view.getFieldString(EntryView::FIELD_TITLE));
+    EXPECT_EQ("me@example.com", view.getFieldString(EntryView::FIELD_USERNAME));
+    EXPECT_EQ("password1", view.getFieldString(EntryView::FIELD_SECRET));
+    EXPECT_EQ("https://mail.example.com", view.getFieldString(EntryView::FIELD_URL));
+    EXPECT_TRUE(view.getField(EntryView::FIELD_NOTES).isEmpty());
+    EXPECT_EQ(1700000000, view.getCreated());
+    EXPECT_EQ(1700000100, view.getModified());
+    EXPECT_THROW(view.getField(EntryView::FIELD_NUMBER), std::range_error);
+
+    //the fields are views into the buffer
+    EXPECT_EQ(record.getView().data() + EntryView::HEADER_LEN, view.getField(EntryView::FIELD_TITLE).data());
+
+    Entry decoded = view.toEntry();
+    EXPECT_EQ(entry.url, decoded.url);
+    EXPECT_EQ(entry.modified, decoded.modified);
+}
+
+TEST(EntryRecordClass, consecutiveRecords){
+    //testing that records in one buffer are read one after another
+    Entry first = createEntry();
+    Entry second = createEntry();
+    second.title = "bank";
+    second.notes = std::string(1000, 'n');
+    Bytes buffer = EntryView::encode(first);
+    buffer.addBytes(EntryView::encode(second));
+    BytesView view = buffer.getView();
+    EntryView a(view);
+    EntryView b(view.slice(a.getLen(), view.getLen() - a.getLen()));
+    EXPECT_EQ("mail", a.getFieldString(EntryView::FIELD_TITLE));
+    EXPECT_EQ("bank", b.getFieldString(EntryView::FIELD_TITLE));
+    EXPECT_EQ(1000, b.getField(EntryView::FIELD_NOTES).getLen());
+    EXPECT_EQ(buffer.getLen(), a.getLen() + b.getLen());
+}
+
+TEST(EntryRecordClass, corrupted){
+    //testing that corrupted headers are rejected
+    std::vector<unsigned char> record = EntryView::encode(createEntry()).getBytes();
+    EXPECT_THROW(EntryView(BytesView(record.data(), EntryView::HEADER_LEN - 1)), std::length_error);
+    EXPECT_THROW(EntryView(BytesView(record.data(), record.size() - 1)), std::length_error);     //cut off
+
+    std::vector<unsigned char> version = record;
+    version[4] = 2;
+    EXPECT_THROW(EntryView(BytesView(version)), std::runtime_error);
+
+    std::vector<unsigned char> offsets = record;
+    offsets[24 + 4*2 + 3] = 0xFF;   //field behind the record
+    EXPECT_THROW(EntryView(BytesView(offsets)), std::runtime_error);
+
+    std::vector<unsigned char> order = record;
+    order[24 + 4*1 + 3] = 0;    //field before the header
+    EXPECT_THROW(EntryView(BytesView(order)), std::runtime_error);
+
+    EXPECT_TRUE(EntryView::isRecord(BytesView(record)));
+    EXPECT_FALSE(EntryView::isRecord(BytesView(version)));
+    record.push_back(0);
+    EXPECT_FALSE(EntryView::isRecord(BytesView(record)));      //more than one record
+    std::string text(100, 'a');
+    EXPECT_FALSE(EntryView::isRecord(BytesView(reinterpret_cast<const unsigned char*>(text.data()), text.size())));
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "file_lock.h"
+
+TEST(FileLockClass, sharedAndExclusive){
+    //testing that readers share the lock and a writer waits for them
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_file_lock_test.enc";
+    std::filesystem::remove(FileLock::getLockPath(path));
+    {
+        FileLock reader1(path, false, 0);
+        FileLock reader2(path, false, 0);     //readers do not block each other
+        EXPECT_FALSE(reader1.isExclusive());
+        EXPECT_THROW(FileLock(path, true, 0), std::runtime_error);
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_THROW(FileLock(path, true, 50), std::runtime_error);
+        EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    }
+    {
+        FileLock writer(path, true, 0);
+        EXPECT_TRUE(writer.isExclusive());
+        EXPECT_THROW(FileLock(path, false, 0), std::runtime_error);
+        EXPECT_THROW(FileLock(path, true, 0), std::runtime_error);
+        FileLock moved = std::move(writer);
+        EXPECT_THROW(FileLock(path, false, 0), std::runtime_error);   //the moved lock is still held
+    }
+    EXPECT_NO_THROW(FileLock(path, true, 0));
+    std::filesystem::remove(FileLock::getLockPath(path));
+}
+
+TEST(FileLockClass, waiting){
+    //testing that a waiting lock gets the lock when it is released
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_file_lock_test.enc";
+    std::optional<FileLock> writer;
+    writer.emplace(path, true, 0);
+    std::thread release([&writer](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        writer.reset();
+    });
+    EXPECT_NO_THROW(FileLock(path, false, FileLock::WAIT_FOREVER));
+    release.join();
+    std::filesystem::remove(FileLock::getLockPath(path));
+}
+
+TEST(FileLockClass, stamp){
+    //testing that appends and replaces change the stamp
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_file_lock_test.enc";
+    std::filesystem::remove(path);
+    EXPECT_TRUE(FileLock::getStamp(path) == FileStamp());
+    std::ofstream(path) << "abc";
+    FileStamp stamp = FileLock::getStamp(path);
+    EXPECT_EQ(3, stamp.size);
+    EXPECT_TRUE(stamp == FileLock::getStamp(path));
+    std::ofstream(path, std::ios::app) << "d";
+    EXPECT_TRUE(stamp != FileLock::getStamp(path));
+    std::filesystem::remove(path);
+}
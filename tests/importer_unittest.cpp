@@ -0,0 +1,154 @@
+#include <sstream>
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "importer.h"
+#include "log_vault.h"
+
+std::vector<Entry> parseAll(std::string text, unsigned char format){
+    std::istringstream in(text);
+    std::vector<Entry> entries;
+    auto onEntry = [&entries](Entry entry){
+        entries.push_back(entry);
+        return true;
+    };
+    if(format == Importer::FORMAT_CSV){
+        Importer::parseCsv(in, onEntry);
+    }else{
+        Importer::parseJson(in, onEntry);
+    }
+    return entries;
+}
+
+TEST(ImporterClass, csv){
+    //testing the columns of different exports and quoted fields
+    std::vector<Entry> entries = parseAll("\xEF\xBB\xBF" "folder,favorite,type,name,notes,fields,reprompt,login_uri,login_username,login_password,login_totp\r\n"
+        ",,login,Mail,\"line1\nline2\",,0,https://mail.example.org,alice,\"pw,with \"\"quotes\"\"\",\r\n"
+        "\r\n"
+        ",,login,Bank,,,0,https://bank.example.org,bob,secret", Importer::FORMAT_CSV);
+    ASSERT_EQ(2, entries.size());
+    EXPECT_EQ("Mail", entries[0].title);
+    EXPECT_EQ("line1\nline2", entries[0].notes);
+    EXPECT_EQ("https://mail.example.org", entries[0].url);
+    EXPECT_EQ("alice", entries[0].username);
+    EXPECT_EQ("pw,with \"quotes\"", entries[0].secret);
+    EXPECT_EQ("secret", entries[1].secret);
+    EXPECT_GT(entries[1].created, 0);
+
+    entries = parseAll("url,username,password,totp,extra,name,grouping,fav\nhttps://a.example.org,carol,pw1,,note,A,,0\nhttps://b.example.org,dave,pw2\n", Importer::FORMAT_CSV);
+    ASSERT_EQ(2, entries.size());
+    EXPECT_EQ("A", entries[0].title);
+    EXPECT_EQ("note", entries[0].notes);
+    EXPECT_EQ("", entries[1].title);      //missing fields are empty
+    EXPECT_EQ("pw2", entries[1].secret);
+
+    EXPECT_THROW(parseAll("", Importer::FORMAT_CSV), std::runtime_error);
+    EXPECT_THROW(parseAll("a,b,c\n1,2,3\n", Importer::FORMAT_CSV), std::runtime_error);
+    EXPECT_THROW(parseAll("name,password\n\"open,pw\n", Importer::FORMAT_CSV), std::runtime_error);
+    EXPECT_EQ(Importer::FORMAT_CSV, Importer::getFormat("export.CSV").value());
+    EXPECT_EQ(Importer::FORMAT_JSON, Importer::getFormat("json").value());
+    EXPECT_FALSE(Importer::getFormat("export.txt").has_value());
+}
+
+TEST(ImporterClass, json){
+    //testing bitwarden exports, flat arrays and escapes
+    std::vector<Entry> entries = parseAll(R"({"encrypted": false, "folders": [{"id": "1", "name": "x"}],
+        "items": [
+            {"type": 1, "name": "Mail", "notes": null, "favorite": false,
+             "login": {"username": "alice", "password": "p\"w\\1", "uris": [{"match": null, "uri": "https://mail.example.org"}]}},
+            {"type": 2, "name": "Note é😀", "notes": "line1\nline2", "secureNote": {"type": 0}}
+        ]})", Importer::FORMAT_JSON);
+    ASSERT_EQ(2, entries.size());
+    EXPECT_EQ("Mail", entries[0].title);
+    EXPECT_EQ("alice", entries[0].username);
+    EXPECT_EQ("p\"w\\1", entries[0].secret);
+    EXPECT_EQ("https://mail.example.org", entries[0].url);
+    EXPECT_EQ("", entries[0].notes);
+    EXPECT_EQ("Note \xC3\xA9\xF0\x9F\x98\x80", entries[1].title);
+    EXPECT_EQ("line1\nline2", entries[1].notes);
+
+    entries = parseAll(R"([{"title": "A", "username": "carol", "password": "pw", "url": "https://a.example.org", "pin": 1234}, {}])", Importer::FORMAT_JSON);
+    ASSERT_EQ(2, entries.size());
+    EXPECT_EQ("carol", entries[0].username);
+    EXPECT_EQ("https://a.example.org", entries[0].url);
+    EXPECT_TRUE(parseAll("[]", Importer::FORMAT_JSON).empty());
+
+    EXPECT_THROW(parseAll(R"({"folders": []})", Importer::FORMAT_JSON), std::runtime_error);
+    EXPECT_THROW(parseAll(R"([{"name": "A"}, 5])", Importer::FORMAT_JSON), std::runtime_error);
+    EXPECT_THROW(parseAll(R"([{"name": "A})", Importer::FORMAT_JSON), std::runtime_error);
+    EXPECT_THROW(parseAll(R"([{"name": "A"}] x)", Importer::FORMAT_JSON), std::runtime_error);
+    EXPECT_THROW(parseAll("[{\"a\":" + std::string(100, '[') + std::string(100, ']') + "}]", Importer::FORMAT_JSON), std::runtime_error);
+
+    //the parser stops when the callback returns false
+    std::istringstream in(R"([{"name": "A"}, {"name": "B"}, {"name": "C"}])");
+    int calls = 0;
+    Importer::parseJson(in, [&calls](Entry){return ++calls < 2;});
+    EXPECT_EQ(2, calls);
+}
+
+TEST(ImporterClass, pipeline){
+    //testing that all entries are stored with unused names
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_importer_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("entry5", Bytes(5));
+        for(unsigned int threads : {1u, 0u}){
+            //the second export has other secrets, so its entries get suffixes
+            std::ostringstream csv;
+            csv << "name,username,password,url\n";
+            for(int i=0; i < 10000; i++){
+                csv << "entry" << i % 9000 << ",user" << i << ",pw" << i << "-" << threads << ",https://site" << i << ".example.org\n";
+            }
+            csv << ",,pw" << threads << ",https://nameless.example.org\n";
+            csv << "\" two\nlines \",,pw" << threads << ",\n";
+            std::istringstream in(csv.str());
+            ImportReport report = Importer::run(in, Importer::FORMAT_CSV, vault, threads);
+            EXPECT_EQ(10002, report.entries);
+            EXPECT_EQ(0, report.skipped);
+            EXPECT_GE(report.threads, 1);
+            EXPECT_EQ((10002 + IMPORT_BATCH_LEN - 1) / IMPORT_BATCH_LEN, report.batches);
+        }
+        EXPECT_EQ(20005, vault.getRecordNumber());
+    }
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(Bytes(5).getLen(), vault.get("entry5").value().getLen());    //existing records are not overwritten
+    Entry entry = EntryView(vault.get("entry5 (2)").value().getView()).toEntry();
+    EXPECT_EQ("user5", entry.username);
+    entry = EntryView(vault.get("entry5 (3)").value().getView()).toEntry();
+    EXPECT_EQ("user9005", entry.username);
+    EXPECT_TRUE(vault.get("https://nameless.example.org").has_value());
+    EXPECT_TRUE(vault.get("https://nameless.example.org (2)").has_value());   //second import
+    EXPECT_TRUE(vault.get("two lines").has_value());     //a name is one line
+
+    //a parse error stops the import
+    std::istringstream in("name,password\na,b\n\"c,d\n");
+    EXPECT_THROW(Importer::run(in, Importer::FORMAT_CSV, vault), std::runtime_error);
+
+    //a retry after a parse error skips the entries that were written before
+    std::ostringstream broken;
+    broken << "name,password\n";
+    for(unsigned long i=0; i < 2 * IMPORT_BATCH_LEN; i++){
+        broken << "retry" << i % 1000 << ",secret" << i << "\n";
+    }
+    std::string fixed = broken.str();
+    broken << "\"c,d\n";
+    std::istringstream broken_in(broken.str());
+    EXPECT_THROW(Importer::run(broken_in, Importer::FORMAT_CSV, vault, 1), std::runtime_error);
+    unsigned long written = vault.getRecordNumber() - 20005;
+    EXPECT_GE(written, IMPORT_BATCH_LEN);
+    std::istringstream fixed_in(fixed);
+    ImportReport report = Importer::run(fixed_in, Importer::FORMAT_CSV, vault, 1);
+    EXPECT_EQ(written, report.skipped);
+    EXPECT_EQ(2 * IMPORT_BATCH_LEN - written, report.entries);
+    EXPECT_EQ(20005 + 2 * IMPORT_BATCH_LEN, vault.getRecordNumber());
+    std::istringstream again(fixed);
+    EXPECT_EQ(2 * IMPORT_BATCH_LEN, Importer::run(again, Importer::FORMAT_CSV, vault, 1).skipped);
+    std::istringstream empty("");
+    EXPECT_THROW(Importer::run(empty, 3, vault), std::invalid_argument);
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
@@ -3,11 +3,13 @@
 #define TEST_UTILS_H
 
 #include <iostream>
+#include "dataHeader.h"
 /*
 this header provides some functions that are needed in the unittests 
 but not anywhere else
 */
 std::string gen_random_string(const int len);   //generates a random string with a given length
+DataHeader createVaultHeader(Bytes datakey);    //header with fast chainhashes for the vault tests, the password is "password1"
 
 
 #endif //(TEST_UTILS_H)
\ No newline at end of file
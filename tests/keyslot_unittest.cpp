@@ -0,0 +1,83 @@
+#include <chrono>
+#include "gtest/gtest.h"
+#include "dataHeader.h"
+#include "keyslot.h"
+
+KeySlot createKeySlot(unsigned char hash_mode, std::string password, Bytes datakey, unsigned long iters){
+    //creates a complete keyslot for the password
+    KeySlot keyslot(hash_mode);
+    keyslot.setChainHash1(3, iters, 8, Bytes(8));
+    keyslot.setChainHash2(1, 10, 0, Bytes());
+    keyslot.setPassword(password, datakey);
+    return keyslot;
+}
+
+TEST(KeySlotClass, password){
+    //testing that the keyslot unlocks the data key only with its password
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    KeySlot keyslot(1);
+    EXPECT_FALSE(keyslot.isComplete());
+    EXPECT_THROW(keyslot.setPassword("password1", datakey), std::logic_error);
+    keyslot = createKeySlot(1, "password1", datakey, 100);
+    EXPECT_TRUE(keyslot.isComplete());
+    EXPECT_EQ(48 + 2*32 + 8, keyslot.getLength());
+    EXPECT_EQ(datakey, keyslot.getDataKey("password1").value());
+    EXPECT_FALSE(keyslot.getDataKey("password2").has_value());
+    EXPECT_THROW(keyslot.setPassword("password1", Bytes(31)), std::length_error);
+
+    //stopped keyslot returns nothing
+    std::atomic<bool> stop{true};
+    EXPECT_FALSE(keyslot.getDataKey("password1", &stop).has_value());
+}
+
+TEST(KeySlotClass, header_keyslots){
+    //testing the keyslots of the data header
+    Bytes datakey = KeyWrap::generateDataKey(64);
+    DataHeader dh(3);
+    EXPECT_EQ(1, dh.getKeySlotNumber());
+    EXPECT_EQ(0, dh.getHeaderLength());
+    dh.setChainHash1(1, 50, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password0", datakey);
+    EXPECT_EQ(84 + 3*64, dh.getHeaderLength());
+    for(int i=1; i < MAX_KEYSLOTS; i++){
+        dh.addKeySlot(createKeySlot(3, "password" + std::to_string(i), datakey, 50*i));
+    }
+    EXPECT_EQ(MAX_KEYSLOTS, dh.getKeySlotNumber());
+    EXPECT_THROW(dh.addKeySlot(createKeySlot(3, "password9", datakey, 50)), std::length_error);
+    EXPECT_THROW(dh.addKeySlot(KeySlot(1)), std::length_error);
+    for(int i=0; i < MAX_KEYSLOTS; i++){
+        EXPECT_EQ(datakey, dh.getDataKey("password" + std::to_string(i)).value());
+    }
+    EXPECT_FALSE(dh.getDataKey("password9").has_value());
+
+    //changing the password of one keyslot
+    dh.setPassword("newpassword", datakey, 2);
+    EXPECT_FALSE(dh.getDataKey("password2").has_value());
+    EXPECT_EQ(datakey, dh.getDataKey("newpassword").value());
+
+    dh.removeKeySlot(2);
+    EXPECT_FALSE(dh.getDataKey("newpassword").has_value());
+    while(dh.getKeySlotNumber() > 1){
+        dh.removeKeySlot(0);
+    }
+    EXPECT_THROW(dh.removeKeySlot(0), std::logic_error);
+    EXPECT_THROW(dh.removeKeySlot(1), std::range_error);
+    DataHeader dh2(1);
+    EXPECT_THROW(dh2.addKeySlot(KeySlot(3)), std::invalid_argument);
+}
+
+TEST(KeySlotClass, parallel_unlock){
+    //testing that a fast matching keyslot stops a slow keyslot
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setChainHash1(1, 100, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password0", datakey);
+    KeySlot slow = createKeySlot(1, "otherpassword", datakey, 10);
+    slow.setChainHash1(3, 100000000, 8, Bytes(8));     //would need a long time
+    dh.addKeySlot(slow);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(datakey, dh.getDataKey("password0").value());
+    EXPECT_LT(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 10);
+}
@@ -0,0 +1,30 @@
+#include "gtest/gtest.h"
+#include "keywrap.h"
+
+TEST(KeyWrapClass, generate){
+    //testing the data key generation
+    EXPECT_EQ(64, KeyWrap::generateDataKey(64).getLen());
+    EXPECT_FALSE(KeyWrap::generateDataKey(32) == KeyWrap::generateDataKey(32));
+    EXPECT_THROW(KeyWrap::generateDataKey(0), std::range_error);
+}
+
+TEST(KeyWrapClass, wrap_unwrap){
+    //testing that only the right passwordhash unwraps the data key
+    for(int len : {32, 48, 64}){
+        Bytes pwhash(len);
+        Bytes datakey = KeyWrap::generateDataKey(len);
+        Bytes wrapped = KeyWrap::wrap(pwhash, datakey);
+        EXPECT_EQ(KeyWrap::getWrappedLen(len), wrapped.getLen());
+        EXPECT_EQ(datakey, KeyWrap::unwrap(pwhash, wrapped).value());
+        EXPECT_FALSE(KeyWrap::unwrap(Bytes(len), wrapped).has_value());
+        EXPECT_FALSE(KeyWrap::unwrap(pwhash, wrapped.getFirstBytes(10).value()).has_value());
+
+        //rewrapping for a new passwordhash keeps the data key
+        Bytes new_pwhash(len);
+        Bytes rewrapped = KeyWrap::wrap(new_pwhash, KeyWrap::unwrap(pwhash, wrapped).value());
+        EXPECT_EQ(wrapped.getLen(), rewrapped.getLen());
+        EXPECT_EQ(datakey, KeyWrap::unwrap(new_pwhash, rewrapped).value());
+        EXPECT_FALSE(KeyWrap::unwrap(pwhash, rewrapped).has_value());
+    }
+    EXPECT_THROW(KeyWrap::wrap(Bytes(32), Bytes()), std::invalid_argument);
+}
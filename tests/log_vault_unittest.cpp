@@ -0,0 +1,364 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "log_vault.h"
+#include "entry_record.h"
+
+TEST(LogVaultClass, appends){
+    //testing that changes are appended and read again
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        EXPECT_EQ(dh.getHeaderLength(), std::filesystem::file_size(path));
+        vault.put("mail", Bytes(20));
+        unsigned long len = std::filesystem::file_size(path);
+        vault.put("bank", Bytes(20));
+        EXPECT_EQ(len + vault.getLastSave().bytes, std::filesystem::file_size(path));     //only the new frame is written
+        EXPECT_TRUE(vault.remove("mail"));
+        EXPECT_FALSE(vault.remove("mail"));
+        EXPECT_EQ(vault.getFileLen(), std::filesystem::file_size(path));
+    }
+    //a cut off append is dropped and overwritten by the next append
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    {
+        LogVault vault(path, dh, datakey);
+        EXPECT_EQ(2, vault.getRecordNumber());
+        EXPECT_TRUE(vault.get("mail").has_value());     //the tombstone was cut off
+        vault.put("shop", Bytes(5));
+        EXPECT_EQ(vault.getFileLen(), std::filesystem::file_size(path));
+    }
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(std::vector<std::string>({"bank", "mail", "shop"}), vault.getNames());
+
+    //other header
+    DataHeader other = createVaultHeader(datakey);
+    EXPECT_THROW(LogVault(path, other, datakey), std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+TEST(LogVaultClass, putAll){
+    //testing that many records are appended with one write
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_put_all_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    std::vector<std::pair<std::string, Bytes>> records;
+    for(int i=0; i < 300; i++){
+        records.emplace_back("entry" + std::to_string(i), Bytes(40));
+    }
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("mail", Bytes(20));
+        vault.putAll(records);
+        EXPECT_EQ(vault.getFileLen(), std::filesystem::file_size(path));
+        EXPECT_GT(vault.getLastSave().bytes, 300 * 40);    //all frames with one save
+        EXPECT_EQ(301, vault.getRecordNumber());
+    }
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(301, vault.getRecordNumber());
+    EXPECT_EQ(records[123].second, vault.get("entry123").value());
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(LogVaultClass, compaction){
+    //testing that the background compaction shrinks the file
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 2000; i++){
+            vault.put("entry" + std::to_string(i % 20), Bytes(40));
+        }
+        vault.waitForCompaction();
+        EXPECT_LT(std::filesystem::file_size(path), 2000*40);
+        vault.compact();
+        EXPECT_EQ(vault.getFileLen(), std::filesystem::file_size(path));
+        vault.put("entry0", Bytes(1));
+        EXPECT_EQ(vault.getFileLen(), std::filesystem::file_size(path));
+    }
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(20, vault.getRecordNumber());
+    EXPECT_EQ(1, vault.get("entry0").value().getLen());
+    std::filesystem::remove(path);
+}
+
+TEST(LogVaultClass, twoWriters){
+    //testing that two vaults on the same file (like two processes) do not overwrite their changes
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault first(path, dh, datakey);
+    LogVault second(path, dh, datakey);
+    first.put("mail", Bytes(10));
+    second.put("bank", Bytes(10));      //reads the append of the first vault before it appends
+    first.put("shop", Bytes(10));
+    EXPECT_TRUE(second.remove("shop"));
+    EXPECT_EQ(std::vector<std::string>({"bank", "mail", "shop"}), first.getNames());   //the remove is not read yet
+    EXPECT_TRUE(first.refresh());
+    EXPECT_FALSE(first.refresh());
+    EXPECT_EQ(std::vector<std::string>({"bank", "mail"}), first.getNames());
+
+    //a compaction of one vault is read by the other
+    second.compact();
+    first.put("code", Bytes(10));
+    EXPECT_TRUE(second.refresh());
+    EXPECT_EQ(std::vector<std::string>({"bank", "code", "mail"}), second.getNames());
+
+    //a held lock lets the changes time out
+    {
+        FileLock reader(path, false);
+        first.setLockTimeout(20);
+        EXPECT_THROW(first.put("late", Bytes(10)), std::runtime_error);
+    }
+    first.setLockTimeout(LOCK_TIMEOUT_MS);
+    LogVault third(path, dh, datakey);
+    EXPECT_EQ(std::vector<std::string>({"bank", "code", "mail"}), third.getNames());
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(LogVaultClass, lookup){
+    //testing that single records are read with the name index
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    Bytes mail = Bytes(30);
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 200; i++){
+            vault.put("entry" + std::to_string(i), Bytes(400));
+        }
+        vault.put("mail", mail);
+        //no index yet, the whole log is decrypted
+        NameLookup found = LogVault::lookup(path, dh, datakey, "mail");
+        EXPECT_FALSE(found.used_index);
+        EXPECT_EQ(mail, found.value.value());
+
+        vault.writeIndex();
+        found = LogVault::lookup(path, dh, datakey, "mail");
+        EXPECT_TRUE(found.used_index);
+        EXPECT_EQ(mail, found.value.value());
+        EXPECT_LT(found.decrypted_len, vault.getFileLen() / 10);     //index and one frame
+        EXPECT_FALSE(LogVault::lookup(path, dh, datakey, "none").value.has_value());
+
+        //changes behind the index are read from the tail of the log
+        Bytes changed = Bytes(30);
+        vault.put("mail", changed);
+        vault.put("bank", Bytes(10));
+        EXPECT_TRUE(vault.remove("entry7"));
+        found = LogVault::lookup(path, dh, datakey, "mail");
+        EXPECT_TRUE(found.used_index);
+        EXPECT_EQ(changed, found.value.value());
+        EXPECT_TRUE(LogVault::lookup(path, dh, datakey, "bank").value.has_value());
+        EXPECT_FALSE(LogVault::lookup(path, dh, datakey, "entry7").value.has_value());
+        EXPECT_TRUE(LogVault::lookup(path, dh, datakey, "entry8").value.has_value());
+
+        //a compaction writes a new index
+        vault.compact();
+        found = LogVault::lookup(path, dh, datakey, "mail");
+        EXPECT_TRUE(found.used_index);
+        EXPECT_EQ(changed, found.value.value());
+        EXPECT_FALSE(LogVault::lookup(path, dh, datakey, "entry7").value.has_value());
+    }
+    //an index of an older log is not used
+    std::filesystem::path old_index = NameIndex::getIndexPath(path);
+    old_index += ".old";
+    std::filesystem::copy_file(NameIndex::getIndexPath(path), old_index, std::filesystem::copy_options::overwrite_existing);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("mail", Bytes(30));
+        vault.compact();
+    }
+    std::filesystem::copy_file(old_index, NameIndex::getIndexPath(path), std::filesystem::copy_options::overwrite_existing);
+    NameLookup found = LogVault::lookup(path, dh, datakey, "mail");
+    EXPECT_FALSE(found.used_index);
+    EXPECT_TRUE(found.value.has_value());
+
+    //a wrong key is detected
+    EXPECT_THROW(LogVault::lookup(path, dh, KeyWrap::generateDataKey(32), "mail"), std::runtime_error);
+    std::filesystem::remove(old_index);
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(LogVaultClass, search){
+    //testing that a search decrypts only the segments that may match
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 300; i++){
+            Entry entry;
+            entry.title = "Account " + std::to_string(i);
+            entry.username = "user" + std::to_string(i) + "@example.org";
+            entry.secret = "secret" + std::to_string(i);
+            entry.notes = std::string(2000, 'x');
+            vault.put("entry" + std::to_string(i), EntryView::encode(entry));
+        }
+        vault.put("attachment", Bytes(600000));    //binary values are not searchable
+        //no filters yet, the whole log is decrypted
+        SearchResult result = LogVault::search(path, dh, datakey, "user123@");
+        EXPECT_FALSE(result.used_filters);
+        EXPECT_EQ(std::vector<std::string>({"entry123"}), result.names);
+
+        vault.writeIndex();
+        result = LogVault::search(path, dh, datakey, "USER123@", 4);
+        EXPECT_TRUE(result.used_filters);
+        EXPECT_EQ(std::vector<std::string>({"entry123"}), result.names);
+        EXPECT_LT(result.scanned_segments, result.segments / 2);
+        EXPECT_LT(result.decrypted_len, vault.getFileLen() / 10);
+        EXPECT_TRUE(LogVault::search(path, dh, datakey, "secret12").names.empty());
+        EXPECT_EQ(std::vector<std::string>({"attachment"}), LogVault::search(path, dh, datakey, "attach").names);
+        EXPECT_EQ(11, LogVault::search(path, dh, datakey, "account 12").names.size());    //12 and 120-129
+
+        //changes behind the filters
+        Entry entry;
+        entry.title = "Changed";
+        vault.put("entry123", EntryView::encode(entry));
+        EXPECT_TRUE(vault.remove("entry124"));
+        EXPECT_TRUE(LogVault::search(path, dh, datakey, "user123@").names.empty());
+        EXPECT_EQ(std::vector<std::string>({"entry123"}), LogVault::search(path, dh, datakey, "changed").names);
+        EXPECT_EQ(9, LogVault::search(path, dh, datakey, "account 12").names.size());
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(LogVaultClass, compression){
+    //testing that the values of a vault with a compression mode are compressed in the file and read again
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    dh.setCompressionMode(1);
+    Entry entry;
+    entry.title = "Mail";
+    entry.secret = "secret";
+    entry.notes = std::string(100000, 'x');
+    Bytes value = EntryView::encode(entry);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("mail", value);
+        vault.put("bank", Bytes(10));
+        EXPECT_LT(std::filesystem::file_size(path), value.getLen() / 10);
+        vault.writeIndex();
+        vault.put("shop", value);
+    }
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(3, vault.getRecordNumber());
+    EXPECT_EQ(value, vault.get("mail").value());
+    EXPECT_EQ(10, vault.get("bank").value().getLen());
+    EXPECT_EQ(value, LogVault::lookup(path, dh, datakey, "mail").value.value());
+    EXPECT_EQ(value, LogVault::lookup(path, dh, datakey, "shop").value.value());
+    EXPECT_EQ(std::vector<std::string>({"mail", "shop"}), LogVault::search(path, dh, datakey, "mail").names);     //by name and by title
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(LogVaultClass, scrub){
+    //testing that the mac table is written with the name index and finds damaged segments
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_test.enc";
+    std::filesystem::remove(path);
+    std::filesystem::remove(SegmentMac::getTablePath(path));
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 100; i++){
+            vault.put("entry" + std::to_string(i), Bytes(2000));
+        }
+        EXPECT_THROW(LogVault::scrub(path, datakey), std::runtime_error);   //no table yet
+        vault.writeIndex();
+        vault.put("mail", Bytes(10));
+    }
+    ScrubReport report = LogVault::scrub(path, datakey, 2);
+    EXPECT_TRUE(report.isIntact());
+    EXPECT_EQ((report.bytes + SEGMENT_SIZE - 1) / SEGMENT_SIZE, report.segments);
+    EXPECT_EQ(std::filesystem::file_size(path), report.bytes + report.unchecked);
+    EXPECT_LT(0, report.unchecked);     //the last frame was appended behind the table
+    EXPECT_FALSE(LogVault::scrub(path, KeyWrap::generateDataKey(32)).isIntact());
+
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(SEGMENT_SIZE + 5);
+    char c = file.get();
+    file.seekp(SEGMENT_SIZE + 5);
+    file.put(c ^ 1);
+    file.close();
+    EXPECT_EQ(std::vector<unsigned long>({SEGMENT_SIZE}), LogVault::scrub(path, datakey).damaged);
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+    std::filesystem::remove(SegmentMac::getTablePath(path));
+}
+
+TEST(LogVaultClass, entryIndex){
+    //testing that entries are found by title and url and that changes update the entry index
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_log_vault_entries_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    Entry mail;
+    mail.title = "Mail";
+    mail.url = "https://mail.example.com";
+    mail.secret = "secret1";
+    Entry bank;
+    bank.title = "Bank";
+    bank.secret = "secret2";
+    {
+        LogVault vault(path, dh, datakey);
+        vault.putAll({{"record1", EntryView::encode(mail)}, {"record2", EntryView::encode(bank)}});
+        vault.put("text", Bytes(20));      //not an entry
+        EXPECT_EQ("record1", vault.findEntry("Mail").value());
+        EXPECT_EQ("record1", vault.findEntry("https://mail.example.com").value());
+        EXPECT_EQ("record2", vault.findEntry("Bank").value());
+        EXPECT_FALSE(vault.findEntry("text").has_value());
+        EXPECT_EQ(std::vector<std::string>({"record1"}), vault.findEntries("https://"));
+        mail.title = "Webmail";
+        vault.put("record1", EntryView::encode(mail));
+        EXPECT_FALSE(vault.findEntry("Mail").has_value());
+        EXPECT_EQ("record1", vault.findEntry("Webmail").value());
+        EXPECT_TRUE(vault.remove("record2"));
+        EXPECT_FALSE(vault.findEntry("Bank").has_value());
+        //a title with two holders stays until both are gone
+        vault.putAll({{"record3", EntryView::encode(bank)}, {"record4", EntryView::encode(bank)}});
+        EXPECT_EQ("record4", vault.findEntry("Bank").value());
+        EXPECT_TRUE(vault.remove("record4"));
+        EXPECT_EQ("record3", vault.findEntry("Bank").value());
+        bank.title = "Savings";
+        vault.put("record3", EntryView::encode(bank));
+        EXPECT_FALSE(vault.findEntry("Bank").has_value());
+        EXPECT_EQ("record3", vault.findEntry("Savings").value());
+        EXPECT_TRUE(vault.remove("record3"));
+    }
+    //the index is built again when the vault is loaded
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ("record1", vault.findEntry("Webmail").value());
+    EXPECT_EQ("record1", vault.findEntry("https://mail.example.com").value());
+    EXPECT_FALSE(vault.findEntry("Bank").has_value());
+    std::filesystem::remove(path);
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+    std::filesystem::remove(SegmentMac::getTablePath(path));
+}
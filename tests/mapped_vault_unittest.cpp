@@ -0,0 +1,71 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "mapped_vault.h"
+#include "dataHeader.h"
+
+std::filesystem::path writeTestFile(std::string name, const Bytes content){
+    //writes the content into a file in the temp directory
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::vector<unsigned char> v = content.getBytes();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(v.data()), v.size());
+    return path;
+}
+
+DataHeader createTestHeader(){
+    DataHeader dh(1);
+    dh.setCipherMode(2);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", KeyWrap::generateDataKey(32));
+    dh.setEncryptedSalt(Bytes(32));
+    return dh;
+}
+
+TEST(MappedVaultClass, views){
+    //testing that the header and the body are viewed without copying
+    DataHeader dh = createTestHeader();
+    Bytes header = dh.getHeaderBytes();
+    Bytes body(100000);
+    Bytes file = header;
+    file.addBytes(body);
+    std::filesystem::path path = writeTestFile("pman_mapped_vault_test.enc", file);
+
+    MappedVault vault(path);
+    EXPECT_FALSE(vault.isEmpty());
+    EXPECT_EQ(file.getLen(), vault.getLen());
+    EXPECT_EQ(header.getLen(), vault.getHeaderLength());
+    EXPECT_EQ(header, vault.getHeader().toBytes());
+    EXPECT_EQ(body, vault.getBody().toBytes());
+    EXPECT_EQ(file, vault.getView().toBytes());
+    EXPECT_EQ(vault.getHeader().data(), vault.getHeader().data());     //repeated reads view the same mapping
+    EXPECT_EQ(vault.getHeader().data() + header.getLen(), vault.getBody().data());
+    vault.adviseRandom();
+
+    DataHeader parsed(vault.getHeader()[0]);
+    parsed.setHeaderBytes(vault.getHeader());
+    EXPECT_EQ(header, parsed.getHeaderBytes());
+
+    //the views move with the mapping
+    const unsigned char* begin = vault.getView().data();
+    MappedVault moved = std::move(vault);
+    EXPECT_EQ(begin, moved.getView().data());
+    EXPECT_TRUE(vault.isEmpty());
+    std::filesystem::remove(path);
+}
+
+TEST(MappedVaultClass, invalid){
+    //testing empty, missing and corrupted files
+    std::filesystem::path path = writeTestFile("pman_mapped_vault_test.enc", Bytes());
+    MappedVault empty(path);
+    EXPECT_TRUE(empty.isEmpty());
+    EXPECT_EQ(0, empty.getHeaderLength());
+    EXPECT_TRUE(empty.getHeader().isEmpty());
+    EXPECT_TRUE(empty.getBody().isEmpty());
+
+    Bytes header = createTestHeader().getHeaderBytes();
+    path = writeTestFile("pman_mapped_vault_test.enc", header.getFirstBytes(header.getLen() - 1).value());
+    EXPECT_THROW(MappedVault{path}, std::length_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(MappedVault{path}, std::runtime_error);
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "name_index.h"
+#include "keywrap.h"
+#include "cipher_modes.h"
+
+TEST(NameIndexClass, encodeAndFind){
+    //testing that the positions are found after the index was encoded and loaded
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    NameIndex index(2, datakey);
+    std::vector<std::pair<std::string, unsigned long>> offsets;
+    for(int i=0; i < 500; i++){
+        offsets.push_back({"entry" + std::to_string(i), i * 100UL});
+    }
+    Bytes log_id(32);
+    Bytes file = index.encode(offsets, 50000, 700, log_id);
+    EXPECT_EQ(NameIndex::PREFIX_LEN + CipherModes::getEncryptedLen(2, NameIndex::PREFIX_LEN + 8 + 500 * NameIndex::ENTRY_LEN), file.getLen());   //prefix and encrypted prefix, count and entries
+
+    NameIndex loaded(2, datakey);
+    loaded.load(file.getView());
+    EXPECT_EQ(500, loaded.getEntryNumber());
+    EXPECT_EQ(50000, loaded.getCoveredLen());
+    EXPECT_EQ(700, loaded.getNextSeq());
+    EXPECT_EQ(log_id, loaded.getLogId());
+    for(int i=0; i < 500; i++){
+        std::optional<unsigned long> pos = loaded.find("entry" + std::to_string(i));
+        ASSERT_TRUE(pos.has_value());
+        EXPECT_EQ(i * 100UL, pos.value());
+    }
+    EXPECT_FALSE(loaded.find("entry500").has_value());
+    EXPECT_FALSE(loaded.find("").has_value());
+
+    //the names are not in the file
+    std::vector<unsigned char> v = file.getBytes();
+    std::string name = "entry42";
+    EXPECT_EQ(v.end(), std::search(v.begin(), v.end(), name.begin(), name.end()));
+}
+
+TEST(NameIndexClass, tampering){
+    //testing that a modified index or another key is detected
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    NameIndex index(2, datakey);
+    Bytes file = index.encode({{"mail", 0}, {"bank", 60}}, 120, 2, Bytes(32));
+
+    NameIndex other(2, KeyWrap::generateDataKey(32));
+    EXPECT_THROW(other.load(file.getView()), std::runtime_error);
+    EXPECT_FALSE(index.getNameHash("mail") == other.getNameHash("mail"));
+
+    //covered length in the readable prefix
+    std::vector<unsigned char> v = file.getBytes();
+    v[11] ^= 1;
+    Bytes changed;
+    changed.setBytes(v);
+    NameIndex loaded(2, datakey);
+    EXPECT_THROW(loaded.load(changed.getView()), std::runtime_error);
+    //encrypted entries
+    v = file.getBytes();
+    v[v.size() - 20] ^= 1;
+    changed.setBytes(v);
+    EXPECT_THROW(loaded.load(changed.getView()), std::runtime_error);
+    //cut off
+    EXPECT_THROW(loaded.load(file.getView().slice(0, 30)), std::runtime_error);
+    loaded.load(file.getView());
+    EXPECT_EQ(60, loaded.find("bank").value());
+}
+
+TEST(NameIndexClass, logId){
+    //testing the log id and the covered length in the prefix
+    Bytes log(10000);
+    Bytes id = NameIndex::calcLogId(log.getView(), 100);
+    EXPECT_EQ(32, id.getLen());
+    EXPECT_FALSE(id == NameIndex::calcLogId(log.getView(), 200));
+    EXPECT_EQ(NameIndex::calcLogId(log.getView(), 5000), NameIndex::calcLogId(log.getView(), 9000));     //only the begin of the log is hashed
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_name_index_test.enc";
+    EXPECT_EQ(path.string() + ".idx", NameIndex::getIndexPath(path).string());
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    EXPECT_FALSE(NameIndex::readCoveredLen(NameIndex::getIndexPath(path)).has_value());
+    NameIndex index(2, KeyWrap::generateDataKey(32));
+    Bytes file = index.encode({}, 1234, 0, id);
+    std::ofstream out(NameIndex::getIndexPath(path), std::ios::binary);
+    out.write((const char*)file.getView().data(), file.getLen());
+    out.close();
+    EXPECT_EQ(1234, NameIndex::readCoveredLen(NameIndex::getIndexPath(path)).value());
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+}
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include "record_log.h"
+#include "keywrap.h"
+
+Bytes textBytes(std::string text){
+    Bytes ret;
+    ret.setBytes(std::vector<unsigned char>(text.begin(), text.end()));
+    return ret;
+}
+
+TEST(RecordLogClass, replay){
+    //testing that the latest version of each record wins while loading
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    EXPECT_THROW(RecordLog(1, datakey), std::invalid_argument);
+    for(unsigned char mode : {2, 3}){
+        RecordLog log(mode, datakey);
+        Bytes file;
+        file.addBytes(log.put("mail", textBytes("pw1")));
+        file.addBytes(log.put("bank", textBytes("pw2")));
+        file.addBytes(log.put("mail", textBytes("pw3")));
+        file.addBytes(log.remove("bank").value());
+        EXPECT_FALSE(log.remove("bank").has_value());
+        file.addBytes(log.put("shop", Bytes()));
+        EXPECT_EQ(file.getLen(), log.getLogLen());
+        EXPECT_EQ(std::vector<std::string>({"mail", "shop"}), log.getNames());
+
+        RecordLog loaded(mode, datakey);
+        EXPECT_EQ(file.getLen(), loaded.load(file.getView()));
+        EXPECT_EQ(2, loaded.getRecordNumber());
+        EXPECT_EQ(textBytes("pw3"), loaded.get("mail").value());
+        EXPECT_FALSE(loaded.get("bank").has_value());
+        EXPECT_TRUE(loaded.get("shop").value().isEmpty());
+        EXPECT_EQ(log.getGarbageLen(), loaded.getGarbageLen());
+
+        //the loaded log continues the sequence
+        file.addBytes(loaded.put("bank", textBytes("pw4")));
+        RecordLog reloaded(mode, datakey);
+        reloaded.load(file.getView());
+        EXPECT_EQ(textBytes("pw4"), reloaded.get("bank").value());
+
+        //wrong key
+        RecordLog wrong(mode, KeyWrap::generateDataKey(32));
+        EXPECT_THROW(wrong.load(file.getView()), std::runtime_error);
+    }
+    RecordLog log(2, datakey);
+    EXPECT_THROW(log.put("", Bytes()), std::length_error);
+    EXPECT_THROW(log.put(std::string(65536, 'a'), Bytes()), std::length_error);
+}
+
+TEST(RecordLogClass, damaged){
+    //testing cut off and modified logs
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    RecordLog log(2, datakey);
+    Bytes first = log.put("mail", textBytes("pw1"));
+    Bytes second = log.put("bank", textBytes("pw2"));
+    Bytes file = first;
+    file.addBytes(second);
+
+    //a cut off last frame is ignored
+    RecordLog loaded(2, datakey);
+    for(unsigned long cut : {1UL, 4UL, 10UL, (unsigned long)second.getLen() - 1}){
+        Bytes torn = first;
+        torn.addBytes(second.getFirstBytes(cut).value());
+        EXPECT_EQ(first.getLen(), loaded.load(torn.getView()));
+        EXPECT_EQ(1, loaded.getRecordNumber());
+    }
+    std::vector<unsigned char> v = file.getBytes();
+    v.back() ^= 1;      //last frame is damaged (like an incomplete write)
+    EXPECT_EQ(first.getLen(), loaded.load(BytesView(v)));
+
+    //a damaged frame in the middle throws
+    v = file.getBytes();
+    v[10] ^= 1;
+    EXPECT_THROW(loaded.load(BytesView(v)), std::runtime_error);
+
+    //reordered frames throw
+    Bytes reordered = second;
+    reordered.addBytes(first);
+    EXPECT_THROW(loaded.load(reordered.getView()), std::runtime_error);
+}
+
+TEST(RecordLogClass, compaction){
+    //testing that the compacted log only contains the latest versions
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    RecordLog log(3, datakey);
+    Bytes file;
+    for(int i=0; i < 1000; i++){
+        file.addBytes(log.put("entry" + std::to_string(i % 10), Bytes(50)));
+    }
+    EXPECT_TRUE(log.needsCompaction());
+    Bytes compacted = log.getCompacted();
+    EXPECT_EQ(log.getLogLen() - log.getGarbageLen(), compacted.getLen());
+    EXPECT_THROW(log.setCompacted(compacted.getLen() + 1), std::logic_error);
+    log.setCompacted(compacted.getLen());
+    EXPECT_EQ(0, log.getGarbageLen());
+    EXPECT_FALSE(log.needsCompaction());
+    compacted.addBytes(log.put("entry3", textBytes("new")));
+
+    RecordLog loaded(3, datakey);
+    EXPECT_EQ(compacted.getLen(), loaded.load(compacted.getView()));
+    EXPECT_EQ(10, loaded.getRecordNumber());
+    EXPECT_EQ(textBytes("new"), loaded.get("entry3").value());
+    EXPECT_EQ(log.getNames(), loaded.getNames());
+}
+
+TEST(RecordLogClass, putAll){
+    //testing that frames encrypted in parallel continue the sequence like single puts
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    RecordLog log(2, datakey);
+    Bytes file = log.put("first", textBytes("pw"));
+    std::vector<std::pair<std::string, Bytes>> records;
+    for(int i=0; i < 500; i++){
+        records.emplace_back("entry" + std::to_string(i % 400), Bytes(30));
+    }
+    for(unsigned int threads : {1u, 4u, 0u}){
+        Bytes frames = log.putAll(records, threads);
+        file.addBytes(frames);
+        EXPECT_EQ(file.getLen(), log.getLogLen());
+    }
+    file.addBytes(log.put("last", textBytes("pw")));
+    RecordLog loaded(2, datakey);
+    EXPECT_EQ(file.getLen(), loaded.load(file.getView()));
+    EXPECT_EQ(402, loaded.getRecordNumber());
+    EXPECT_EQ(records[450].second, loaded.get("entry50").value());
+    EXPECT_EQ(log.getGarbageLen(), loaded.getGarbageLen());
+    EXPECT_TRUE(log.putAll({}).isEmpty());
+
+    //an invalid record changes nothing
+    unsigned long len = log.getLogLen();
+    EXPECT_THROW(log.putAll({{"valid", Bytes(5)}, {"", Bytes(5)}}), std::length_error);
+    EXPECT_EQ(len, log.getLogLen());
+    EXPECT_FALSE(log.get("valid").has_value());
+}
+
+TEST(RecordLogClass, compression){
+    //testing that the values are compressed before they are encrypted and the frame lengths do not depend on the sequence number
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    EXPECT_THROW(RecordLog(2, datakey, MAX_COMPRESSIONMODE_NUMBER + 1), std::invalid_argument);
+    Bytes text = textBytes(std::string(5000, 'a') + "password");
+    RecordLog plain(2, datakey);
+    RecordLog log(2, datakey, 1);
+    Bytes plain_frame = plain.put("notes", text);
+    Bytes file = log.put("notes", text);
+    EXPECT_LT(file.getLen(), plain_frame.getLen() / 10);
+    file.addBytes(log.put("mail", Bytes()));
+    file.addBytes(log.put("notes", textBytes("short")));
+    Bytes compacted = log.getCompacted();
+    log.setCompacted(compacted.getLen());
+
+    RecordLog loaded(2, datakey, 1);
+    EXPECT_EQ(file.getLen(), loaded.load(file.getView()));
+    EXPECT_EQ(textBytes("short"), loaded.get("notes").value());
+    EXPECT_TRUE(loaded.get("mail").value().isEmpty());
+    loaded.load(compacted.getView());
+    EXPECT_EQ(textBytes("short"), loaded.get("notes").value());
+
+    //a frame without compression is not decoded with compression
+    EXPECT_THROW(loaded.decodeFrame(plain_frame.getView()), std::runtime_error);
+}
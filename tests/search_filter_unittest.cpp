@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "search_filter.h"
+#include "entry_record.h"
+#include "keywrap.h"
+
+TEST(SearchFilterClass, searchText){
+    //testing which texts of a record are searchable
+    Entry entry;
+    entry.title = "Mail Account";
+    entry.username = "alice@example.org";
+    entry.secret = "hunter22";
+    entry.url = "https://mail.example.org";
+    entry.notes = "second factor on the phone";
+    Bytes record = EntryView::encode(entry);
+    std::vector<std::string> texts = SearchFilter::getSearchText("mail", record.getView());
+    EXPECT_EQ(std::vector<std::string>({"mail", "Mail Account", "alice@example.org", "https://mail.example.org", "second factor on the phone"}), texts);
+    EXPECT_TRUE(SearchFilter::matches("mail", record.getView(), "ACCOUNT"));
+    EXPECT_TRUE(SearchFilter::matches("mail", record.getView(), "factor"));
+    EXPECT_TRUE(SearchFilter::matches("mail", record.getView(), ""));
+    EXPECT_FALSE(SearchFilter::matches("mail", record.getView(), "hunter"));     //the secret is never searched
+
+    //other values are not searched
+    Bytes value;
+    value.setBytes(std::vector<unsigned char>({'s', 'e', 'c', 'r', 'e', 't'}));
+    EXPECT_EQ(std::vector<std::string>({"bank"}), SearchFilter::getSearchText("bank", value.getView()));
+    EXPECT_FALSE(SearchFilter::matches("bank", value.getView(), "secret"));
+    EXPECT_TRUE(SearchFilter::matches("bank", value.getView(), "AN"));
+}
+
+TEST(SearchFilterClass, candidates){
+    //testing that only the segments that may contain the query are candidates
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    SearchFilter filter(2, datakey);
+    for(int i=0; i < 100; i++){
+        filter.addSegment(i * 1000, i * 1000 + 900, {i * 1000UL}, {"entry" + std::to_string(i), "notes of segment number " + std::to_string(i * 7919)});
+    }
+    EXPECT_THROW(filter.addSegment(50, 60, {50}, {}), std::invalid_argument);
+    Bytes file = filter.encode(100000, 100, Bytes(32));
+
+    SearchFilter loaded(2, datakey);
+    loaded.load(file.getView());
+    EXPECT_EQ(100, loaded.getSegmentNumber());
+    EXPECT_EQ(100000, loaded.getCoveredLen());
+    EXPECT_EQ(100, loaded.getNextSeq());
+    EXPECT_EQ(42000, loaded.getSegment(42).begin);
+    EXPECT_EQ(42900, loaded.getSegment(42).end);
+    EXPECT_EQ(std::vector<unsigned long>({42000}), loaded.getSegment(42).offsets);
+    EXPECT_THROW(loaded.getSegment(100), std::range_error);
+
+    std::vector<unsigned long> candidates = loaded.getCandidates("ENTRY42");
+    EXPECT_NE(candidates.end(), std::find(candidates.begin(), candidates.end(), 42));
+    EXPECT_LT(candidates.size(), 5);
+    candidates = loaded.getCandidates(std::to_string(57 * 7919));
+    EXPECT_NE(candidates.end(), std::find(candidates.begin(), candidates.end(), 57));
+    EXPECT_LT(candidates.size(), 5);
+    EXPECT_LT(loaded.getCandidates("nothing like this").size(), 3);
+    EXPECT_EQ(100, loaded.getCandidates("notes").size());
+    EXPECT_EQ(100, loaded.getCandidates("en").size());      //too short for a trigram
+
+    //another key or a modified file
+    SearchFilter other(2, KeyWrap::generateDataKey(32));
+    EXPECT_THROW(other.load(file.getView()), std::runtime_error);
+    std::vector<unsigned char> v = file.getBytes();
+    v[6] ^= 1;
+    Bytes changed;
+    changed.setBytes(v);
+    EXPECT_THROW(loaded.load(changed.getView()), std::runtime_error);
+    EXPECT_THROW(loaded.load(file.getView().slice(0, 40)), std::runtime_error);
+}
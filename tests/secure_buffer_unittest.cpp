@@ -0,0 +1,48 @@
+#include "gtest/gtest.h"
+#include "secure_buffer.h"
+
+TEST(SecureBufferClass, buffer){
+    //testing that the bytes are copied into the buffer and moved with it
+    Bytes key(64);
+    SecureBuffer buffer(key.getView());
+    EXPECT_EQ(64, buffer.getLen());
+    EXPECT_FALSE(buffer.isEmpty());
+    EXPECT_EQ(key, buffer.getView().toBytes());
+    EXPECT_NE(key.getView().data(), buffer.getView().data());
+
+    const unsigned char* data = buffer.getView().data();
+    SecureBuffer moved = std::move(buffer);
+    EXPECT_EQ(data, moved.getView().data());
+    EXPECT_TRUE(buffer.isEmpty());
+    EXPECT_FALSE(buffer.isLocked());
+
+    moved.clear();
+    EXPECT_TRUE(moved.isEmpty());
+    EXPECT_TRUE(SecureBuffer().isEmpty());
+    EXPECT_TRUE(SecureBuffer(BytesView()).isEmpty());
+
+    //bigger than one page
+    Bytes big(10000);
+    SecureBuffer big_buffer(big.getView());
+    EXPECT_EQ(big, big_buffer.getView().toBytes());
+}
+
+TEST(SecureBufferClass, append){
+    //testing that appended bytes stay in one buffer that grows
+    SecureBuffer buffer;
+    Bytes all;
+    const unsigned char* data = nullptr;
+    for(int i=0; i < 100; i++){
+        Bytes part(100);
+        buffer.append(part.getView());
+        all.addBytes(part);
+        if(i == 1){
+            data = buffer.getView().data();
+        }
+    }
+    EXPECT_EQ(10000, buffer.getLen());
+    EXPECT_EQ(all, buffer.getView().toBytes());
+    EXPECT_NE(data, buffer.getView().data());      //moved to bigger pages
+    buffer.append(BytesView());
+    EXPECT_EQ(10000, buffer.getLen());
+}
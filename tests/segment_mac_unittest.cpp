@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "segment_mac.h"
+
+Bytes withTrailer(Bytes data, Bytes trailer){
+    data.addBytes(trailer);
+    return data;
+}
+
+TEST(SegmentMacClass, trailer){
+    //testing the trailer table
+    Bytes key(32);
+    Bytes data(1000);
+    Bytes trailer = SegmentMac::createTrailer(key, data, 100);
+    EXPECT_EQ(10*SegmentMac::MAC_LEN + SegmentMac::TRAILER_FOOTER_LEN, trailer.getLen());
+    EXPECT_EQ(trailer.getLen(), SegmentMac::getTrailerLen(withTrailer(data, trailer)));
+    EXPECT_EQ(0, SegmentMac::getTrailerLen(data));
+    EXPECT_EQ(0, SegmentMac::getTrailerLen(Bytes()));
+    Bytes empty_trailer = SegmentMac::createTrailer(key, Bytes(), 100);
+    EXPECT_EQ(SegmentMac::TRAILER_FOOTER_LEN, SegmentMac::getTrailerLen(empty_trailer));
+    //trailer does not fit to the data length
+    EXPECT_THROW(SegmentMac::getTrailerLen(withTrailer(Bytes(1100), trailer)), std::length_error);
+    //macs of the trailer are cut off
+    std::vector<unsigned char> t = trailer.getBytes();
+    Bytes footer;
+    footer.setBytes(std::vector<unsigned char>(t.end() - SegmentMac::TRAILER_FOOTER_LEN, t.end()));
+    EXPECT_THROW(SegmentMac::getTrailerLen(footer), std::length_error);
+    EXPECT_THROW(SegmentMac::createTrailer(key, data, 0), std::range_error);
+}
+
+TEST(SegmentMacClass, mac){
+    //testing that the mac depends on the key, the index and the data
+    Bytes key(32);
+    std::vector<unsigned char> d = Bytes(100).getBytes();
+    Bytes mac = SegmentMac::calcMac(key, 0, d.data(), d.size());
+    EXPECT_EQ(SegmentMac::MAC_LEN, mac.getLen());
+    EXPECT_EQ(mac, SegmentMac::calcMac(key, 0, d.data(), d.size()));
+    EXPECT_FALSE(mac == SegmentMac::calcMac(Bytes(32), 0, d.data(), d.size()));
+    EXPECT_FALSE(mac == SegmentMac::calcMac(key, 1, d.data(), d.size()));
+    EXPECT_FALSE(mac == SegmentMac::calcMac(key, 0, d.data(), d.size()-1));
+    EXPECT_THROW(SegmentMac::calcMac(Bytes(), 0, d.data(), d.size()), std::invalid_argument);
+}
+
+TEST(SegmentMacClass, scrub){
+    //testing that the scrub finds the damaged segments
+    Bytes key(32);
+    Bytes data(SEGMENT_SIZE*8 + 10);
+    Bytes file = withTrailer(data, SegmentMac::createTrailer(key, data));
+    for(unsigned int threads : {0u, 1u, 3u, 100u}){
+        ScrubReport report = SegmentMac::scrub(key, file, threads);
+        EXPECT_TRUE(report.isIntact());
+        EXPECT_EQ(9, report.segments);
+        EXPECT_EQ(data.getLen(), report.bytes);
+    }
+    EXPECT_FALSE(SegmentMac::scrub(Bytes(32), file).isIntact());
+
+    std::vector<unsigned char> v = file.getBytes();
+    v[SEGMENT_SIZE*2 + 17] ^= 1;
+    v[SEGMENT_SIZE*8 + 9] ^= 1;
+    Bytes damaged;
+    damaged.setBytes(v);
+    ScrubReport report = SegmentMac::scrub(key, damaged);
+    EXPECT_FALSE(report.isIntact());
+    EXPECT_EQ(std::vector<unsigned long>({SEGMENT_SIZE*2, SEGMENT_SIZE*8}), report.damaged);
+    EXPECT_THROW(SegmentMac::scrub(key, data), std::runtime_error);
+}
+
+TEST(SegmentMacClass, table){
+    //testing the mac table of a file that grows behind the covered length
+    Bytes key(32);
+    std::vector<unsigned char> file = Bytes(SEGMENT_SIZE*3 + 100).getBytes();
+    Bytes table = SegmentMac::createTable(key, BytesView(file), 2);
+    EXPECT_EQ(8 + 4*SegmentMac::MAC_LEN + SegmentMac::TRAILER_FOOTER_LEN, table.getLen());
+    ScrubReport report = SegmentMac::scrubTable(key, BytesView(file), table.getView());
+    EXPECT_TRUE(report.isIntact());
+    EXPECT_EQ(4, report.segments);
+    EXPECT_EQ(0, report.unchecked);
+
+    //appended bytes are not checked
+    file.resize(file.size() + 50, 7);
+    report = SegmentMac::scrubTable(key, BytesView(file), table.getView());
+    EXPECT_TRUE(report.isIntact());
+    EXPECT_EQ(50, report.unchecked);
+
+    //damaged and cut off segments
+    file[SEGMENT_SIZE + 3] ^= 1;
+    file.resize(SEGMENT_SIZE*2 + 10);
+    report = SegmentMac::scrubTable(key, BytesView(file), table.getView());
+    EXPECT_EQ(std::vector<unsigned long>({SEGMENT_SIZE, SEGMENT_SIZE*2, SEGMENT_SIZE*3}), report.damaged);
+    EXPECT_THROW(SegmentMac::scrubTable(key, BytesView(file), BytesView()), std::runtime_error);
+}
@@ -0,0 +1,222 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "sharded_vault.h"
+
+std::vector<std::string> getShardFiles(std::filesystem::path dir){
+    std::vector<std::string> files;
+    for(const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(dir)){
+        if(file.path().filename().string().rfind("shard-", 0) == 0){
+            files.push_back(file.path().filename().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+TEST(ShardedVaultClass, roundTrip){
+    //testing that the records are spread over the shards and loaded with any number of threads
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_sharded_vault_test";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    ShardedVault::create(dir, dh, datakey, 8);
+    EXPECT_TRUE(ShardedVault::isShardedVault(dir));
+    EXPECT_FALSE(ShardedVault::isShardedVault(dir / "manifest"));
+    EXPECT_THROW(ShardedVault::create(dir, dh, datakey, 8), std::invalid_argument);
+    EXPECT_THROW(ShardedVault::create(dir / "other", dh, datakey, 0), std::range_error);
+
+    std::vector<Bytes> values;
+    {
+        ShardedVault vault(dir, dh, datakey);
+        EXPECT_EQ(8, vault.getShardNumber());
+        EXPECT_EQ(0, vault.getRecordNumber());
+        for(int i=0; i < 200; i++){
+            values.push_back(Bytes(100));
+            vault.put("entry" + std::to_string(i), values.back());
+        }
+        EXPECT_TRUE(vault.remove("entry7"));
+        EXPECT_FALSE(vault.remove("entry7"));
+        EXPECT_EQ(8, vault.getDirtyShards().size());
+        EXPECT_GT(vault.save().bytes, 0);
+        EXPECT_TRUE(vault.getDirtyShards().empty());
+        EXPECT_EQ(0, vault.save().bytes);      //nothing changed
+    }
+    EXPECT_EQ(8, getShardFiles(dir).size());
+    for(unsigned int threads : {1u, 3u, 0u}){
+        ShardedVault vault(dir, dh, datakey, threads);
+        EXPECT_EQ(199, vault.getRecordNumber());
+        std::vector<std::string> names = vault.getNames();
+        EXPECT_EQ(199, names.size());
+        EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+        EXPECT_FALSE(vault.get("entry7").has_value());
+        for(int i=0; i < 200; i++){
+            if(i != 7){
+                EXPECT_EQ(values[i], vault.get("entry" + std::to_string(i)).value());
+            }
+        }
+        ShardLoadReport report = vault.getLastLoad();
+        EXPECT_EQ(8, report.shards);
+        EXPECT_GT(report.bytes, 19900);
+        EXPECT_GE(report.threads, 1);
+    }
+    //only save writes the changes
+    {
+        ShardedVault vault(dir, dh, datakey);
+        vault.put("entry7", values[7]);
+    }
+    EXPECT_FALSE(ShardedVault(dir, dh, datakey).get("entry7").has_value());
+    {
+        ShardedVault vault(dir, dh, datakey);
+        vault.put("entry7", values[7]);
+        vault.save();
+    }
+    ShardedVault vault(dir, dh, datakey);
+    EXPECT_EQ(values[7], vault.get("entry7").value());
+    //a lookup decrypts only the shard of the name
+    EXPECT_EQ(values[7], ShardedVault::lookup(dir, dh, datakey, "entry7").value());
+    EXPECT_EQ(values[8], ShardedVault::lookup(dir, dh, datakey, "entry8").value());
+    EXPECT_FALSE(ShardedVault::lookup(dir, dh, datakey, "nothing").has_value());
+    EXPECT_THROW(ShardedVault(dir / "none", dh, datakey), std::invalid_argument);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShardedVaultClass, dirtyShards){
+    //testing that a save only writes the changed shards
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_sharded_vault_dirty_test";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    ShardedVault::create(dir, dh, datakey, 16);
+    ShardedVault vault(dir, dh, datakey);
+    for(int i=0; i < 1000; i++){
+        vault.put("entry" + std::to_string(i), Bytes(1000));
+    }
+    SaveReport full = vault.save();
+    std::vector<std::string> before = getShardFiles(dir);
+    EXPECT_EQ(16, before.size());
+
+    unsigned long shard = vault.getShardOf("entry42");
+    vault.put("entry42", Bytes(1000));
+    EXPECT_EQ(std::vector<unsigned long>{shard}, vault.getDirtyShards());
+    SaveReport one = vault.save();
+    EXPECT_LT(one.bytes * 8, full.bytes);      //one of 16 shards and the manifest
+    std::vector<std::string> after = getShardFiles(dir);
+    EXPECT_EQ(16, after.size());
+    std::vector<std::string> changed;
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(changed));
+    EXPECT_EQ(std::vector<std::string>{ShardedVault::getShardPath(dir, shard, 2).filename().string()}, changed);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShardedVaultClass, tampering){
+    //testing that modified, swapped and old shard files are detected
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_sharded_vault_tamper_test";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    ShardedVault::create(dir, dh, datakey, 2);
+    std::string name0;
+    std::string name1;
+    {
+        ShardedVault vault(dir, dh, datakey);
+        for(int i=0; name0.empty() || name1.empty(); i++){
+            std::string name = "entry" + std::to_string(i);
+            (vault.getShardOf(name) == 0 ? name0 : name1) = name;
+        }
+        vault.put(name0, Bytes(100));
+        vault.put(name1, Bytes(100));
+        vault.save();
+    }
+    std::filesystem::path shard0 = ShardedVault::getShardPath(dir, 0, 1);
+    std::filesystem::path shard1 = ShardedVault::getShardPath(dir, 1, 1);
+    std::filesystem::path saved = dir.string() + "_shard0";
+    std::filesystem::copy_file(shard0, saved, std::filesystem::copy_options::overwrite_existing);
+
+    //the shards have different keys, so they cannot be swapped
+    std::filesystem::copy_file(shard1, shard0, std::filesystem::copy_options::overwrite_existing);
+    EXPECT_THROW(ShardedVault(dir, dh, datakey), std::runtime_error);
+    std::filesystem::copy_file(saved, shard0, std::filesystem::copy_options::overwrite_existing);
+    EXPECT_NO_THROW(ShardedVault(dir, dh, datakey));
+
+    //an old generation of the shard cannot be put back
+    {
+        ShardedVault vault(dir, dh, datakey);
+        vault.put(name0, Bytes(100));
+        vault.save();
+    }
+    EXPECT_FALSE(std::filesystem::exists(shard0));
+    std::filesystem::copy_file(saved, ShardedVault::getShardPath(dir, 0, 2), std::filesystem::copy_options::overwrite_existing);
+    EXPECT_THROW(ShardedVault(dir, dh, datakey), std::runtime_error);
+
+    //a changed manifest is detected by its mac
+    std::filesystem::remove_all(dir);
+    ShardedVault::create(dir, dh, datakey, 2);
+    std::fstream manifest(ShardedVault::getManifestPath(dir), std::ios::in | std::ios::out | std::ios::binary);
+    manifest.seekp(-40, std::ios::end);
+    manifest.put(1);
+    manifest.close();
+    EXPECT_THROW(ShardedVault(dir, dh, datakey), std::runtime_error);
+    EXPECT_THROW(ShardedVault(dir, dh, KeyWrap::generateDataKey(32)), std::runtime_error);
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove(saved);
+}
+
+TEST(ShardedVaultClass, otherProcess){
+    //testing that changes of another vault object are read and conflicts are refused
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_sharded_vault_process_test";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    ShardedVault::create(dir, dh, datakey, 4);
+    ShardedVault first(dir, dh, datakey);
+    ShardedVault second(dir, dh, datakey);
+    std::string other;
+    for(int i=0; other.empty(); i++){
+        std::string name = "entry" + std::to_string(i);
+        if(first.getShardOf(name) != first.getShardOf("a")){
+            other = name;
+        }
+    }
+    first.put("a", Bytes(10));
+    first.save();
+    second.put(other, Bytes(10));
+    second.save();      //another shard, the shard of the first is read again
+    EXPECT_TRUE(second.get("a").has_value());
+    second.put("a", Bytes(10));
+    first.put("a", Bytes(10));
+    second.save();
+    EXPECT_THROW(first.save(), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShardedVaultClass, scrub){
+    //testing that the shard files carry a mac trailer that the scrub checks
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "pman_sharded_vault_scrub_test";
+    std::filesystem::remove_all(dir);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    ShardedVault::create(dir, dh, datakey, 4);
+    {
+        ShardedVault vault(dir, dh, datakey);
+        for(int i=0; i < 100; i++){
+            vault.put("entry" + std::to_string(i), Bytes(2000));
+        }
+        vault.save();
+    }
+    std::vector<std::pair<std::filesystem::path, ScrubReport>> reports = ShardedVault::scrub(dir, datakey);
+    EXPECT_EQ(4, reports.size());
+    for(const std::pair<std::filesystem::path, ScrubReport>& report : reports){
+        EXPECT_TRUE(report.second.isIntact());
+        EXPECT_LT(0, report.second.bytes);
+    }
+    EXPECT_FALSE(ShardedVault::scrub(dir, KeyWrap::generateDataKey(32))[0].second.isIntact());
+    std::fstream shard(reports[2].first, std::ios::in | std::ios::out | std::ios::binary);
+    shard.seekp(100);
+    shard.put(1);
+    shard.close();
+    reports = ShardedVault::scrub(dir, datakey);
+    EXPECT_EQ(std::vector<unsigned long>({0}), reports[2].second.damaged);
+    EXPECT_TRUE(reports[1].second.isIntact());
+    std::filesystem::remove_all(dir);
+}
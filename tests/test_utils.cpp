@@ -13,4 +13,14 @@ std::string gen_random_string(const int len) {
     }
     
     return tmp_s;
-}
\ No newline at end of file
+}
+
+DataHeader createVaultHeader(Bytes datakey){
+    DataHeader dh(1);
+    dh.setCipherMode(2);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    return dh;
+}
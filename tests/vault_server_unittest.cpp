@@ -0,0 +1,176 @@
+#include <thread>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "vault_server.h"
+#include "unix_socket.h"
+
+std::string requestServer(int fd, std::string commands, unsigned long lines){
+    //sends the commands and reads the given number of answer lines
+    EXPECT_TRUE(UnixSocket::sendAll(fd, reinterpret_cast<const unsigned char*>(commands.data()), commands.size()));
+    std::string answer;
+    unsigned char c;
+    while(lines > 0 && UnixSocket::recvAll(fd, &c, 1)){
+        answer += c;
+        if(c == '\n'){
+            lines--;
+        }
+    }
+    return answer;
+}
+
+TEST(VaultServerClass, snapshots){
+    //testing that reads see the published changes and the changes are saved
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_server_test.enc";
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path() / "pman_vault_server_test.sock";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("mail", Bytes(10));
+        VaultServer server(socket_path, vault, 2);
+        EXPECT_EQ(std::vector<std::string>({"mail"}), server.getNames());
+        server.put("bank", Bytes(5));
+        EXPECT_TRUE(server.remove("mail"));
+        EXPECT_FALSE(server.remove("mail"));
+        EXPECT_FALSE(server.get("mail").has_value());
+        EXPECT_EQ(5, server.get("bank")->getLen());
+        EXPECT_THROW(VaultServer(socket_path, vault), std::runtime_error);     //the socket is not free
+    }
+    EXPECT_FALSE(std::filesystem::exists(socket_path));
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(std::vector<std::string>({"bank"}), vault.getNames());
+    std::filesystem::remove(path);
+}
+
+TEST(VaultServerClass, otherWriter){
+    //testing that the changes of another process are published
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_server_test.enc";
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path() / "pman_vault_server_test.sock";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    vault.put("mail", Bytes(10));
+    VaultServer server(socket_path, vault, 2);
+    LogVault other(path, dh, datakey);     //like a pman set of another process
+    other.put("bank", Bytes(5));
+    EXPECT_TRUE(server.refresh());
+    EXPECT_FALSE(server.refresh());
+    EXPECT_EQ(5, server.get("bank")->getLen());
+
+    //a write of the server reads the other changes first and publishes them
+    other.put("card", Bytes(3));
+    EXPECT_TRUE(other.remove("mail"));
+    server.put("note", Bytes(1));
+    EXPECT_EQ(std::vector<std::string>({"bank", "card", "note"}), server.getNames());
+
+    //the poll loop refreshes, so clients see the change without a write of the server
+    std::thread serving(&VaultServer::run, &server);
+    other.put("key", Bytes(7));
+    int fd = UnixSocket::connectTo(socket_path);
+    ASSERT_GE(fd, 0);
+    std::string answer;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while((answer = requestServer(fd, "list\n", 1)).find("key") == std::string::npos && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)){
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_NE(std::string::npos, answer.find("key"));
+    close(fd);
+    server.stop();
+    serving.join();
+    std::filesystem::remove(path);
+}
+
+TEST(VaultServerClass, clients){
+    //testing that many clients are served at the same time
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_server_test.enc";
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path() / "pman_vault_server_test.sock";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    vault.put("shared", Bytes(4));
+    VaultServer server(socket_path, vault, 4);
+    std::thread serving(&VaultServer::run, &server);
+
+    std::vector<std::thread> clients;
+    std::atomic<int> failed{0};
+    for(int c=0; c < 8; c++){
+        clients.emplace_back([&, c](){
+            int fd = UnixSocket::connectTo(socket_path);
+            if(fd < 0){
+                failed++;
+                return;
+            }
+            std::string name = "client" + std::to_string(c);
+            for(int i=0; i < 20; i++){
+                std::string value = std::to_string(i);
+                std::string expected = "ok\nok " + value + "\n";
+                if(requestServer(fd, "set " + name + " " + value + "\nget " + name + "\nget shared\n", 3).substr(0, expected.size()) != expected){
+                    failed++;
+                }
+            }
+            close(fd);
+        });
+    }
+    for(std::thread& client : clients){
+        client.join();
+    }
+    EXPECT_EQ(0, failed);
+    EXPECT_EQ(9, server.getNames().size());
+
+    int fd = UnixSocket::connectTo(socket_path);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ("ok 9\n", requestServer(fd, "list\n", 10).substr(0, 5));
+    EXPECT_EQ("err not found\n", requestServer(fd, "del nothing\n", 1));
+    std::string stats = requestServer(fd, "stats\n", 1);
+    EXPECT_EQ("ok 482 ", stats.substr(0, 7));     //8 clients * 60 commands, list and del
+    close(fd);
+    LatencyReport report = server.getLatencyReport();
+    EXPECT_EQ(483, report.requests);     //with the stats request
+    EXPECT_LE(report.p50, report.p99);
+    EXPECT_GT(report.p99, 0);
+
+    server.stop();
+    serving.join();
+    std::filesystem::remove(path);
+}
+
+TEST(VaultServerClass, idleClients){
+    //testing that idle connections do not hold a worker
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_server_test.enc";
+    std::filesystem::path socket_path = std::filesystem::temp_directory_path() / "pman_vault_server_test.sock";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    LogVault vault(path, dh, datakey);
+    vault.put("mail", Bytes(4));
+    VaultServer server(socket_path, vault, 1);
+    std::thread serving(&VaultServer::run, &server);
+
+    std::vector<int> idle;
+    for(int c=0; c < 4; c++){
+        idle.push_back(UnixSocket::connectTo(socket_path));
+        ASSERT_GE(idle.back(), 0);
+    }
+    EXPECT_EQ("ok 1\nmail\n", requestServer(idle[0], "list\n", 2));    //a connection is served again after it was idle
+    int fd = UnixSocket::connectTo(socket_path);
+    ASSERT_GE(fd, 0);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ("ok 1\nmail\n", requestServer(fd, "list\n", 2));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));     //the single worker is not held by the idle connections
+    //a command can arrive in parts
+    EXPECT_TRUE(UnixSocket::sendAll(fd, reinterpret_cast<const unsigned char*>("li"), 2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ("ok 1\nmail\n", requestServer(fd, "st\n", 2));
+    close(fd);
+    for(int idle_fd : idle){
+        close(idle_fd);
+    }
+
+    server.stop();
+    serving.join();
+    std::filesystem::remove(path);
+}
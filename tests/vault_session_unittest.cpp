@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+#include "test_utils.h"
+#include "vault_session.h"
+#include "log_vault.h"
+
+void removeVault(std::filesystem::path path){
+    std::filesystem::remove(path);
+    std::filesystem::remove(FileLock::getLockPath(path));
+    std::filesystem::remove(NameIndex::getIndexPath(path));
+    std::filesystem::remove(SearchFilter::getFilterPath(path));
+}
+
+TEST(VaultSessionClass, lazySegments){
+    //testing that only the segments of the read records are decrypted and cached
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_session_test.enc";
+    removeVault(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    std::vector<Bytes> values;
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 100; i++){
+            values.push_back(Bytes(10000));
+            vault.put("entry" + std::to_string(i), values.back());
+        }
+    }
+    //no index yet, it is written when the session is opened
+    VaultSession session(path, dh, datakey, 100000);
+    EXPECT_TRUE(std::filesystem::exists(NameIndex::getIndexPath(path)));
+    CacheStats stats = session.getCacheStats();
+    EXPECT_GT(stats.segments, 10);
+    EXPECT_EQ(0, stats.cached_segments);
+
+    EXPECT_EQ(values[42], session.get("entry42").value());
+    EXPECT_EQ(values[42], session.get("entry42").value());
+    EXPECT_EQ(values[43], session.get("entry43").value());     //same segment
+    EXPECT_FALSE(session.get("none").has_value());
+    stats = session.getCacheStats();
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(2, stats.hits);
+    EXPECT_EQ(1, stats.cached_segments);
+
+    //the cache stays below its length
+    for(int i=0; i < 100; i++){
+        EXPECT_EQ(values[i], session.get("entry" + std::to_string(i)).value());
+    }
+    stats = session.getCacheStats();
+    EXPECT_LE(stats.cached_len, 100000);
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_EQ(stats.cached_segments + stats.evictions, stats.misses);      //every decrypted segment is cached or was dropped
+    EXPECT_EQ(100, session.getNames().size());
+
+    //a wrong key is detected
+    EXPECT_THROW(VaultSession(path, dh, KeyWrap::generateDataKey(32)), std::runtime_error);
+    removeVault(path);
+}
+
+TEST(VaultSessionClass, changes){
+    //testing that the changes are appended and read by other vaults
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_session_test.enc";
+    removeVault(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("mail", Bytes(10));
+        vault.put("bank", Bytes(10));
+    }
+    VaultSession session(path, dh, datakey);
+    Bytes shop = Bytes(20);
+    session.put("shop", shop);
+    EXPECT_TRUE(session.remove("mail"));
+    EXPECT_FALSE(session.remove("mail"));
+    EXPECT_FALSE(session.remove("none"));
+    EXPECT_EQ(shop, session.get("shop").value());
+    EXPECT_FALSE(session.get("mail").has_value());
+    EXPECT_EQ(std::vector<std::string>({"bank", "shop"}), session.getNames());
+    {
+        LogVault vault(path, dh, datakey);
+        EXPECT_EQ(std::vector<std::string>({"bank", "shop"}), vault.getNames());
+        EXPECT_EQ(shop, vault.get("shop").value());
+        vault.put("code", Bytes(10));
+    }
+    //changes of another process
+    EXPECT_FALSE(session.get("code").has_value());
+    EXPECT_TRUE(session.refresh());
+    EXPECT_FALSE(session.refresh());
+    EXPECT_TRUE(session.get("code").has_value());
+
+    //a compaction with a new index
+    {
+        LogVault vault(path, dh, datakey);
+        vault.compact();
+    }
+    Bytes bank = Bytes(30);
+    session.put("bank", bank);
+    EXPECT_EQ(bank, session.get("bank").value());
+    EXPECT_EQ(std::vector<std::string>({"bank", "code", "shop"}), session.getNames());
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(bank, vault.get("bank").value());
+    removeVault(path);
+}
+
+TEST(VaultSessionClass, maintenance){
+    //testing that the tail and the garbage stay bounded
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_session_test.enc";
+    removeVault(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh = createVaultHeader(datakey);
+    {
+        LogVault vault(path, dh, datakey);
+        vault.put("first", Bytes(100));
+    }
+    Bytes last;
+    {
+        VaultSession session(path, dh, datakey);
+        for(int i=0; i < 2000; i++){
+            last = Bytes(1000);
+            session.put("entry" + std::to_string(i % 10), last);     //almost every frame is garbage
+            EXPECT_LE(std::filesystem::file_size(path) - NameIndex::readCoveredLen(NameIndex::getIndexPath(path)).value_or(0), MAX_UNINDEXED_LEN + 2000);
+        }
+        EXPECT_TRUE(session.remove("first"));
+        EXPECT_EQ(10, session.getNames().size());
+        EXPECT_EQ(last, session.get("entry9").value());
+    }
+    EXPECT_LT(std::filesystem::file_size(path), 2 * MIN_COMPACTION_LEN + MAX_UNINDEXED_LEN);    //compacted, not 2 MB
+    LogVault vault(path, dh, datakey);
+    EXPECT_EQ(10, vault.getRecordNumber());
+    EXPECT_EQ(last, vault.get("entry9").value());
+    EXPECT_FALSE(vault.get("first").has_value());
+    removeVault(path);
+}
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "vault_unlock.h"
+#include "log_vault.h"
+
+TEST(VaultUnlockClass, unlockAsync){
+    //testing that the vault is unlocked and decrypted asynchronously
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_unlock_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setCipherMode(3);
+    dh.setChainHash1(1, 5000, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    {
+        LogVault vault(path, dh, datakey);
+        for(int i=0; i < 100; i++){
+            vault.put("entry" + std::to_string(i), Bytes(100));
+        }
+    }
+
+    VaultUnlock unlock{MappedVault(path)};
+    EXPECT_EQ(dh.getHeaderBytes(), unlock.getHeader().getHeaderBytes());
+    std::future<std::optional<UnlockedVault>> right = unlock.unlockAsync("password1");
+    std::future<std::optional<UnlockedVault>> wrong = unlock.unlockAsync("password2");
+    std::optional<UnlockedVault> unlocked = right.get();
+    ASSERT_TRUE(unlocked.has_value());
+    EXPECT_EQ(datakey, unlocked->datakey);
+    EXPECT_EQ(100, unlocked->log.getRecordNumber());
+    EXPECT_EQ(100, unlocked->log.get("entry42").value().getLen());
+    EXPECT_FALSE(wrong.get().has_value());
+    std::filesystem::remove(path);
+}
+
+TEST(VaultUnlockClass, invalid){
+    //testing that empty vaults and vaults without a record log are not unlocked
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_unlock_test.enc";
+    AtomicWriter::writeFile(path, std::string(""));
+    EXPECT_THROW(VaultUnlock{MappedVault(path)}, std::logic_error);
+
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setCipherMode(1);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    Bytes header = dh.getHeaderBytes();
+    AtomicWriter::writeFile(path, {header.getView()});
+    VaultUnlock unlock{MappedVault(path)};
+    std::future<std::optional<UnlockedVault>> future = unlock.unlockAsync("password1");
+    EXPECT_THROW(future.get(), std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+TEST(VaultUnlockClass, unlockWithKeyAsync){
+    //testing that a known key is checked against the header, also if the body would decrypt with every key
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pman_vault_unlock_test.enc";
+    std::filesystem::remove(path);
+    Bytes datakey = KeyWrap::generateDataKey(32);
+    DataHeader dh(1);
+    dh.setCipherMode(3);
+    dh.setChainHash1(1, 10, 0, Bytes());
+    dh.setChainHash2(1, 10, 0, Bytes());
+    dh.setPassword("password1", datakey);
+    dh.setEncryptedSalt(Bytes(32));
+    for(int records : {0, 1}){
+        {
+            LogVault vault(path, dh, datakey);
+            if(records == 1){
+                vault.put("mail", Bytes(10));
+            }
+        }
+        VaultUnlock unlock{MappedVault(path)};
+        EXPECT_FALSE(unlock.unlockWithKeyAsync(KeyWrap::generateDataKey(32)).get().has_value());
+        std::optional<UnlockedVault> unlocked = unlock.unlockWithKeyAsync(datakey).get();
+        ASSERT_TRUE(unlocked.has_value());
+        EXPECT_EQ(records, unlocked->log.getRecordNumber());
+    }
+    std::filesystem::remove(path);
+}